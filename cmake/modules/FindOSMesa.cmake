@@ -0,0 +1,7 @@
+#  Copyright 2010-2014 Matus Chochlik. Distributed under the Boost
+#  Software License, Version 1.0. (See accompanying file
+#  LICENSE_1_0.txt or copy at http://www.boost.org/LICENSE_1_0.txt)
+#
+
+include(CommonFindMod)
+ogles_gpgpu_common_find_module(OSMesa osmesa GL/osmesa.h OSMesa)
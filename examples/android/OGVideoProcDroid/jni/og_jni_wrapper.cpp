@@ -60,10 +60,10 @@ JNIEXPORT void JNICALL Java_ogles_1gpgpu_OGJNIWrapper_init(JNIEnv *env, jobject
     assert(ogCore == NULL);
     OG_LOGINF("OGJNIWrapper", "creating instance of ogles_gpgpu::Core");
 
-    ogCore = ogles_gpgpu::Core::getInstance();
+    ogCore = new ogles_gpgpu::Core();
 
     if (platOpt) {
-        ogles_gpgpu::Core::tryEnablePlatformOptimizations();
+        ogCore->tryEnablePlatformOptimizations();
     }
 
     // this method is user-defined and sets up the processing pipeline
@@ -90,7 +90,7 @@ JNIEXPORT void JNICALL Java_ogles_1gpgpu_OGJNIWrapper_cleanup(JNIEnv *env, jobje
 
     OG_LOGINF("OGJNIWrapper", "destroying instance of ogles_gpgpu::Core");
 
-    ogles_gpgpu::Core::destroy();
+    delete ogCore;
     ogCore = NULL;
 
     ogCleanupHelper(env);
@@ -82,8 +82,8 @@ static NSArray *availableTestImages = [NSArray arrayWithObjects:
     if (testImgData) delete [] testImgData;
     if (outputBuf) delete [] outputBuf;
     
-    // delete ogles_gpgpu singleton object
-    ogles_gpgpu::Core::destroy();
+    // delete ogles_gpgpu core object
+    delete gpgpuMngr;
     gpgpuMngr = NULL;
     
     // release image objects
@@ -265,11 +265,11 @@ static NSArray *availableTestImages = [NSArray arrayWithObjects:
 - (void)initOGLESGPGPU {
     NSLog(@"initializing ogles_gpgpu");
     
-    // get ogles_gpgpu::Core singleton instance
-    gpgpuMngr = ogles_gpgpu::Core::getInstance();
+    // create ogles_gpgpu::Core instance
+    gpgpuMngr = new ogles_gpgpu::Core();
     
     // enable iOS optimizations (fast texture access)
-    ogles_gpgpu::Core::tryEnablePlatformOptimizations();
+    gpgpuMngr->tryEnablePlatformOptimizations();
     
     // do not use mipmaps (will not work with NPOT images)
     gpgpuMngr->setUseMipmaps(false);
@@ -77,8 +77,8 @@ void fourCCStringFromCode(int code, char fourCC[5]) {
 }
 
 - (void)dealloc {
-    // delete ogles_gpgpu singleton object
-    ogles_gpgpu::Core::destroy();
+    // delete ogles_gpgpu core object
+    delete gpgpuMngr;
     gpgpuMngr = NULL;
 }
 
@@ -221,11 +221,11 @@ void fourCCStringFromCode(int code, char fourCC[5]) {
 - (void)initOGLESGPGPU {
     NSLog(@"initializing ogles_gpgpu");
     
-    // get ogles_gpgpu::Core singleton instance
-    gpgpuMngr = ogles_gpgpu::Core::getInstance();
+    // create ogles_gpgpu::Core instance
+    gpgpuMngr = new ogles_gpgpu::Core();
     
     // enable iOS optimizations (fast texture access)
-    ogles_gpgpu::Core::tryEnablePlatformOptimizations();
+    gpgpuMngr->tryEnablePlatformOptimizations();
     
     // do not use mipmaps (will not work with NPOT images)
     gpgpuMngr->setUseMipmaps(false);
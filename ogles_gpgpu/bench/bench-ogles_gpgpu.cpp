@@ -0,0 +1,968 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+// Benchmarks for the procs in common/proc and for MemTransfer throughput.
+//
+// All benchmarks run in a headless OpenGL context (see platform/opengl/headless.h).
+// Software rendering (Mesa llvmpipe) is forced with LIBGL_ALWAYS_SOFTWARE=1 unless the
+// variable is already set, so that results are reproducible on any Linux machine.
+// Results are written as JSON unless another --benchmark_format is given.
+//
+// Each benchmark reports "ms/frame" and "Mpix/s" (input pixels) as counters.
+
+#include <benchmark/benchmark.h>
+
+// clang-format off
+#include "../common/proc/video.h"
+#include "../common/proc/video_worker.h"
+#include "../common/proc/adapt_thresh.h"
+#include "../common/proc/batcher.h"
+#include "../common/proc/blend.h"
+#include "../common/proc/box_opt.h"
+#include "../common/proc/diff.h"
+#include "../common/proc/fifo.h"
+#include "../common/proc/fir3.h"
+#include "../common/proc/flow.h"
+#include "../common/proc/gain.h"
+#include "../common/proc/gauss.h"
+#include "../common/proc/gauss_opt.h"
+#include "../common/proc/grad.h"
+#include "../common/proc/grayscale.h"
+#include "../common/proc/harris.h"
+#include "../common/proc/hessian.h"
+#include "../common/proc/highpass.h"
+#include "../common/proc/histogram.h"
+#include "../common/proc/histopyramid.h"
+#include "../common/proc/hsv2rgb.h"
+#include "../common/proc/klt.h"
+#include "../common/proc/lbp.h"
+#include "../common/proc/lnorm.h"
+#include "../common/proc/lowpass.h"
+#include "../common/proc/median.h"
+#include "../common/proc/nms.h"
+#include "../common/proc/pyramid.h"
+#include "../common/proc/reduce.h"
+#include "../common/proc/rgb2hsv.h"
+#include "../common/proc/shitomasi.h"
+#include "../common/proc/tensor.h"
+#include "../common/proc/thresh.h"
+#include "../common/proc/tiler.h"
+#include "../common/proc/transform.h"
+#include "../common/proc/yuv2rgb.h"
+// clang-format on
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if !defined(OGLES_GPGPU_HEADLESS)
+#error ogles_gpgpu_bench requires OGLES_GPGPU_HEADLESS
+#endif
+
+using namespace ogles_gpgpu;
+
+typedef std::chrono::steady_clock Clock;
+
+#pragma mark helper functions
+
+// headless context shared by all benchmarks
+static HeadlessContext& getContext() {
+    static HeadlessContext context;
+    if (!context) {
+        context.setup();
+    }
+    return context;
+}
+
+// frame sizes from 320x240 to 4K
+static void setFrameSizes(benchmark::internal::Benchmark* b) {
+    b->Args({ 320, 240 });
+    b->Args({ 640, 480 });
+    b->Args({ 1280, 720 });
+    b->Args({ 1920, 1080 });
+    b->Args({ 3840, 2160 });
+    b->ArgNames({ "width", "height" });
+    b->Unit(benchmark::kMillisecond);
+    b->UseRealTime(); // GPU work is not CPU time of this thread
+}
+
+// frame sizes from 640x480 to 4K with <n0> and <n1> pixel buffers (or frames in flight)
+static void setBufferArgs(benchmark::internal::Benchmark* b, int n0, int n1) {
+    for (int n : { n0, n1 }) {
+        b->Args({ 640, 480, n });
+        b->Args({ 1920, 1080, n });
+        b->Args({ 3840, 2160, n });
+    }
+    b->ArgNames({ "width", "height", "buffers" });
+    b->Unit(benchmark::kMillisecond);
+    b->UseRealTime();
+}
+
+// RGBA test image with some structure
+static std::vector<unsigned char> getTestPixels(int width, int height) {
+    std::vector<unsigned char> pixels(width * height * 4);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            unsigned char* p = &pixels[(y * width + x) * 4];
+            p[0] = (unsigned char)(x ^ y);
+            p[1] = (unsigned char)(x * 3 + y);
+            p[2] = (unsigned char)((x / 8 + y / 8) % 2 ? 200 : 50);
+            p[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+// Skip the benchmark if an OpenGL error was raised since the last call, so that the time of
+// a broken run is not reported. Returns false on error.
+static bool checkGLError(benchmark::State& state) {
+    const GLenum error = glGetError();
+    if (error == GL_NO_ERROR) {
+        return true;
+    }
+
+    // clear the other error flags (they belong to this run, not to the next benchmark)
+    while (glGetError() != GL_NO_ERROR) {
+    }
+
+    OG_LOGERR("ogles_gpgpu_bench", "GL error '%d' occured", error);
+    state.SkipWithError("OpenGL error");
+    return false;
+}
+
+// set "ms/frame" and "Mpix/s" from the measured time <elapsed> of all iterations
+// (the benchmark is skipped if it raised an OpenGL error, see checkGLError())
+static void setCounters(benchmark::State& state, int width, int height, Clock::duration elapsed) {
+    if (!checkGLError(state)) {
+        return;
+    }
+
+    const double iterations = (double)state.iterations();
+    const double ms = std::chrono::duration<double, std::milli>(elapsed).count();
+    const double msPerFrame = (iterations > 0) ? ms / iterations : 0.0;
+
+    state.counters["ms/frame"] = msPerFrame;
+    state.counters["Mpix/s"] = (msPerFrame > 0) ? (width * height) / (msPerFrame * 1e3) : 0.0;
+    state.SetItemsProcessed(state.iterations() * width * height);
+}
+
+// Process the filter graph starting at <first> on an input frame of the benchmark's size.
+// The input is uploaded once, each iteration processes the whole graph from the input texture.
+// Processing is restricted to the region of interest <roi> of the input (empty for the whole frame).
+static void runGraph(benchmark::State& state, ProcInterface& first, const Rect2d& roi = Rect2d()) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    std::vector<unsigned char> pixels = getTestPixels(width, height);
+
+    VideoSource video;
+    video.set(&first);
+    video.getCore().setRoi(roi);
+    video({ width, height }, pixels.data(), true, 0, GL_RGBA);
+
+    const GLuint inputTex = video.getInputTexId();
+
+    // fill FIFOs and caches
+    for (int i = 0; i < 3; i++) {
+        video({ width, height }, nullptr, false, inputTex, GL_RGBA);
+    }
+    glFinish();
+    if (!checkGLError(state)) {
+        return;
+    }
+
+    const Clock::time_point start = Clock::now();
+    for (auto _ : state) {
+        video({ width, height }, nullptr, false, inputTex, GL_RGBA);
+        glFinish();
+    }
+    setCounters(state, width, height, Clock::now() - start);
+}
+
+#pragma mark single procs
+
+#define OGLES_GPGPU_BENCH_PROC(NAME, ...) \
+    static void BM_##NAME(benchmark::State& state) { \
+        NAME proc{ __VA_ARGS__ }; \
+        runGraph(state, proc); \
+    } \
+    BENCHMARK(BM_##NAME)->Apply(setFrameSizes)
+
+OGLES_GPGPU_BENCH_PROC(GainProc, 1.5f);
+OGLES_GPGPU_BENCH_PROC(GrayscaleProc);
+OGLES_GPGPU_BENCH_PROC(ThreshProc);
+OGLES_GPGPU_BENCH_PROC(AdaptThreshProc);
+OGLES_GPGPU_BENCH_PROC(GaussProc);
+OGLES_GPGPU_BENCH_PROC(GaussOptProc, 5.0f);
+OGLES_GPGPU_BENCH_PROC(BoxOptProc, 5.0f);
+OGLES_GPGPU_BENCH_PROC(MedianProc);
+OGLES_GPGPU_BENCH_PROC(HessianProc);
+OGLES_GPGPU_BENCH_PROC(LbpProc);
+OGLES_GPGPU_BENCH_PROC(GradProc);
+OGLES_GPGPU_BENCH_PROC(TensorProc);
+OGLES_GPGPU_BENCH_PROC(HarrisProc);
+OGLES_GPGPU_BENCH_PROC(ShiTomasiProc);
+OGLES_GPGPU_BENCH_PROC(NmsProc);
+OGLES_GPGPU_BENCH_PROC(LocalNormProc);
+OGLES_GPGPU_BENCH_PROC(LowPassFilterProc);
+OGLES_GPGPU_BENCH_PROC(HighPassFilterProc);
+OGLES_GPGPU_BENCH_PROC(Rgb2HsvProc);
+OGLES_GPGPU_BENCH_PROC(Hsv2RgbProc);
+OGLES_GPGPU_BENCH_PROC(TransformProc);
+OGLES_GPGPU_BENCH_PROC(PyramidProc, 4);
+
+// cascaded pyramids (each level is reduced from the previous level)
+static void BM_PyramidProcGaussian(benchmark::State& state) {
+    PyramidProc pyramid(4);
+    pyramid.setMode(PyramidProc::GAUSSIAN);
+    runGraph(state, pyramid);
+}
+BENCHMARK(BM_PyramidProcGaussian)->Apply(setFrameSizes);
+
+static void BM_PyramidProcLaplacian(benchmark::State& state) {
+    PyramidProc pyramid(4);
+    pyramid.setMode(PyramidProc::LAPLACIAN);
+    runGraph(state, pyramid);
+}
+BENCHMARK(BM_PyramidProcLaplacian)->Apply(setFrameSizes);
+
+#pragma mark graphs
+
+// corner detection graph: GaussOpt -> Tensor -> Harris/ShiTomasi -> Nms
+static void BM_CornerGraph(benchmark::State& state) {
+    GaussOptProc gauss;
+    TensorProc tensor;
+    ShiTomasiProc shiTomasi;
+    NmsProc nms;
+
+    gauss.add(&tensor);
+    tensor.add(&shiTomasi);
+    shiTomasi.add(&nms);
+
+    runGraph(state, gauss);
+}
+BENCHMARK(BM_CornerGraph)->Apply(setFrameSizes);
+
+// corner detection graph restricted to the center quarter of the frame
+static void BM_CornerGraphRoi(benchmark::State& state) {
+    GaussOptProc gauss;
+    TensorProc tensor;
+    ShiTomasiProc shiTomasi;
+    NmsProc nms;
+
+    gauss.add(&tensor);
+    tensor.add(&shiTomasi);
+    shiTomasi.add(&nms);
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    runGraph(state, gauss, Rect2d(width / 4, height / 4, width / 2, height / 2));
+}
+BENCHMARK(BM_CornerGraphRoi)->Apply(setFrameSizes);
+
+// corner detection graph in tiles of at most 512x512 pixels (incl. the upload of each tile
+// and the readback of the stitched NMS output)
+static void BM_CornerGraphTiled(benchmark::State& state) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    GaussOptProc gauss;
+    TensorProc tensor;
+    ShiTomasiProc shiTomasi;
+    NmsProc nms;
+
+    gauss.add(&tensor);
+    tensor.add(&shiTomasi);
+    shiTomasi.add(&nms);
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    std::vector<unsigned char> pixels = getTestPixels(width, height);
+
+    Tiler tiler;
+    tiler.set(&gauss, &nms);
+    tiler.setMaxTileSize(512);
+    if (!tiler({ width, height }, pixels.data(), 0, GL_RGBA)) {
+        state.SkipWithError("graph can not be tiled");
+        return;
+    }
+
+    const Clock::time_point start = Clock::now();
+    for (auto _ : state) {
+        tiler({ width, height }, pixels.data(), 0, GL_RGBA);
+    }
+    setCounters(state, width, height, Clock::now() - start);
+
+    state.counters["tiles"] = (double)tiler.getNumTiles();
+}
+BENCHMARK(BM_CornerGraphTiled)->Apply(setFrameSizes);
+
+// 256 images of 64x64 or 64 images of 224x224 pixels
+static void setBatchArgs(benchmark::internal::Benchmark* b) {
+    b->Args({ 64, 256 });
+    b->Args({ 224, 64 });
+    b->ArgNames({ "size", "images" });
+    b->Unit(benchmark::kMillisecond);
+    b->UseRealTime();
+}
+
+// GaussOptProc on many small images one at a time (<batch> is false) or packed into
+// atlases by a Batcher (<batch> is true), incl. the upload and the readback of the results
+static void runBatch(benchmark::State& state, bool batch) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    const int size = (int)state.range(0), count = (int)state.range(1);
+    std::vector<unsigned char> pixels = getTestPixels(size, size * count), result(size * size * 4);
+    std::vector<const void*> images;
+    for (int i = 0; i < count; i++) {
+        images.push_back(&pixels[size_t(i) * size * size * 4]);
+    }
+
+    GaussProc gauss;
+    VideoSource video;
+    Batcher batcher;
+    if (batch) {
+        batcher.set(&gauss, &gauss);
+        batcher({ size, size }, images, 0, GL_RGBA);
+    } else {
+        video.set(&gauss);
+    }
+
+    const Clock::time_point start = Clock::now();
+    for (auto _ : state) {
+        if (batch) {
+            batcher({ size, size }, images, 0, GL_RGBA);
+        } else {
+            for (auto image : images) {
+                video({ size, size }, const_cast<void*>(image), true, 0, GL_RGBA);
+                gauss.getResultData(result.data());
+            }
+        }
+    }
+    setCounters(state, size, size * count, Clock::now() - start);
+
+    benchmark::DoNotOptimize(result.data());
+}
+
+static void BM_SmallImagesSingle(benchmark::State& state) {
+    runBatch(state, false);
+}
+BENCHMARK(BM_SmallImagesSingle)->Apply(setBatchArgs);
+
+static void BM_SmallImagesBatched(benchmark::State& state) {
+    runBatch(state, true);
+}
+BENCHMARK(BM_SmallImagesBatched)->Apply(setBatchArgs);
+
+// flow pipelines (fed by a GainProc as in the unit tests)
+static void BM_FlowPipeline(benchmark::State& state) {
+    GainProc gain(1.f);
+    FlowPipeline flow;
+
+    gain.add(&flow);
+
+    runGraph(state, gain);
+}
+BENCHMARK(BM_FlowPipeline)->Apply(setFrameSizes);
+
+static void BM_Flow2Pipeline(benchmark::State& state) {
+    GainProc gain(1.f);
+    Flow2Pipeline flow;
+
+    gain.add(&flow);
+
+    runGraph(state, gain);
+}
+BENCHMARK(BM_Flow2Pipeline)->Apply(setFrameSizes);
+
+static void BM_PyramidFlowPipeline(benchmark::State& state) {
+    GainProc gain(1.f);
+    PyramidFlowPipeline flow;
+
+    gain.add(&flow);
+
+    runGraph(state, gain);
+}
+BENCHMARK(BM_PyramidFlowPipeline)->Apply(setFrameSizes);
+
+// two input procs (incl. the GainProc that feeds the second input)
+static void BM_BlendProc(benchmark::State& state) {
+    GainProc gain1(1.f), gain2(2.f);
+    BlendProc blend(0.5f);
+
+    gain1.add(&blend, 0);
+    gain1.add(&gain2);
+    gain2.add(&blend, 1);
+
+    runGraph(state, gain1);
+}
+BENCHMARK(BM_BlendProc)->Apply(setFrameSizes);
+
+static void BM_DiffProc(benchmark::State& state) {
+    GainProc gain1(1.f), gain2(2.f);
+    DiffProc diff;
+
+    gain1.add(&diff, 1);
+    gain1.add(&gain2);
+    gain2.add(&diff, 0);
+
+    runGraph(state, gain1);
+}
+BENCHMARK(BM_DiffProc)->Apply(setFrameSizes);
+
+// three input proc fed by a FIFO (incl. the GainProc and the FIFO)
+static void BM_Fir3Proc(benchmark::State& state) {
+    GainProc gain(1.f);
+    FifoProc fifo(3);
+    Fir3Proc fir3(true);
+
+    gain.add(&fifo);
+    fifo.addWithDelay(&fir3, 0, 0);
+    fifo.addWithDelay(&fir3, 1, 1);
+    fifo.addWithDelay(&fir3, 2, 2);
+
+    runGraph(state, gain);
+}
+BENCHMARK(BM_Fir3Proc)->Apply(setFrameSizes);
+
+// FIFO that copies each frame into a slot (<rotate> is false) or that rotates the
+// slot textures, so that the GainProc renders directly into the next slot
+static void runFifo(benchmark::State& state, bool rotate) {
+    GainProc gain(1.f);
+    FifoProc fifo(3);
+
+    gain.add(&fifo);
+    if (rotate) {
+        fifo.setProducer(&gain);
+    }
+
+    runGraph(state, gain);
+}
+
+static void BM_FifoProcCopy(benchmark::State& state) {
+    runFifo(state, false);
+}
+BENCHMARK(BM_FifoProcCopy)->Apply(setFrameSizes);
+
+static void BM_FifoProcRotation(benchmark::State& state) {
+    runFifo(state, true);
+}
+BENCHMARK(BM_FifoProcRotation)->Apply(setFrameSizes);
+
+// NV12 -> RGBA conversion from luminance and chrominance textures
+static void BM_Yuv2RgbProc(benchmark::State& state) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    std::vector<unsigned char> y(width * height, 128), uv(width * height / 2, 128);
+
+    GLuint tex[2];
+    glGenTextures(2, tex);
+    glBindTexture(GL_TEXTURE_2D, tex[0]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, y.data());
+    glBindTexture(GL_TEXTURE_2D, tex[1]);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, width / 2, height / 2, 0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, uv.data());
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, tex[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+
+    {
+        Core core;
+        core.init();
+
+        Yuv2RgbProc yuv2rgb;
+        yuv2rgb.setCore(&core);
+        yuv2rgb.init(width, height, 0, true);
+        yuv2rgb.setExternalInputDataFormat(0); // NV12
+        yuv2rgb.createFBOTex(false);
+        yuv2rgb.setTextures(tex[0], tex[1]);
+        yuv2rgb.render();
+        glFinish();
+
+        const Clock::time_point start = Clock::now();
+        for (auto _ : state) {
+            core.beginFrame();
+            yuv2rgb.render();
+            core.endFrame();
+            glFinish();
+        }
+        setCounters(state, width, height, Clock::now() - start);
+    }
+
+    glDeleteTextures(2, tex);
+}
+BENCHMARK(BM_Yuv2RgbProc)->Apply(setFrameSizes);
+
+// upload, corner detection and readback with <range(2)> frames in flight
+static void BM_FramesInFlight(benchmark::State& state) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    std::vector<unsigned char> pixels = getTestPixels(width, height);
+
+    GaussOptProc gauss;
+    TensorProc tensor;
+    ShiTomasiProc shiTomasi;
+    gauss.add(&tensor);
+    tensor.add(&shiTomasi);
+
+    unsigned int checksum = 0;
+
+    VideoSource video;
+    video.set(&gauss);
+    video.setFramesInFlight((int)state.range(2));
+    video.setOutput(&shiTomasi, [&](const Size2d& size, const void* data, size_t rowStride) {
+        checksum += ((const unsigned char*)data)[0];
+    });
+    video({ width, height }, pixels.data(), true, 0, GL_RGBA);
+    video.flush();
+
+    const Clock::time_point start = Clock::now();
+    for (auto _ : state) {
+        video({ width, height }, pixels.data(), true, 0, GL_RGBA);
+    }
+    video.flush();
+    setCounters(state, width, height, Clock::now() - start);
+
+    benchmark::DoNotOptimize(checksum);
+}
+BENCHMARK(BM_FramesInFlight)->Apply([](benchmark::internal::Benchmark* b) { setBufferArgs(b, 1, 3); });
+
+// frames submitted to a VideoWorker (upload, corner detection and readback on the worker thread)
+// with <range(2)> frames in flight
+static void BM_VideoWorker(benchmark::State& state) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    std::vector<unsigned char> pixels = getTestPixels(width, height);
+
+    std::unique_ptr<GaussOptProc> gauss;
+    std::unique_ptr<TensorProc> tensor;
+    std::unique_ptr<ShiTomasiProc> shiTomasi;
+
+    VideoWorker worker(4, VideoWorkerBlock);
+    worker.setFramesInFlight((int)state.range(2));
+    bool started = worker.start([&](VideoSource& video) {
+        gauss.reset(new GaussOptProc);
+        tensor.reset(new TensorProc);
+        shiTomasi.reset(new ShiTomasiProc);
+        gauss->add(tensor.get());
+        tensor->add(shiTomasi.get());
+        video.set(gauss.get());
+        return shiTomasi.get();
+    },
+        [&]() {
+            shiTomasi.reset();
+            tensor.reset();
+            gauss.reset();
+        });
+    if (!started) {
+        state.SkipWithError("could not start the worker");
+        return;
+    }
+
+    std::atomic<unsigned int> checksum(0);
+    const VideoWorker::ResultCallback callback = [&](const VideoWorkerResult& result) {
+        checksum += result.pixels.empty() ? 0 : result.pixels[0];
+    };
+    worker.submit({ { width, height }, pixels.data(), true, 0, GL_RGBA }).wait();
+
+    const Clock::time_point start = Clock::now();
+    for (auto _ : state) {
+        worker.submit({ { width, height }, pixels.data(), true, 0, GL_RGBA }, callback);
+    }
+    worker.stop();
+    setCounters(state, width, height, Clock::now() - start);
+
+    benchmark::DoNotOptimize(checksum.load());
+}
+BENCHMARK(BM_VideoWorker)->Apply([](benchmark::internal::Benchmark* b) { setBufferArgs(b, 1, 3); });
+
+#pragma mark keypoints
+
+// number of keypoints in the RGBA output <pixels> of NmsProc, i.e. pixels with a red channel
+// greater than 0 (the default threshold of HistoPyramidProc)
+static int countKeypoints(const std::vector<unsigned char>& pixels) {
+    int count = 0;
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        count += (pixels[i] > 0);
+    }
+    return count;
+}
+
+// corner detection with the readback of the whole NMS output and a scan for the keypoints on
+// the CPU (<compact> is false) or with the keypoints compacted by a HistoPyramidProc (<compact>
+// is true)
+static void runKeypoints(benchmark::State& state, bool compact) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    std::vector<unsigned char> pixels = getTestPixels(width, height), result(width * height * 4);
+
+    GaussOptProc gauss;
+    TensorProc tensor;
+    ShiTomasiProc shiTomasi;
+    NmsProc nms;
+    HistoPyramidProc histoPyramid(4096);
+    shiTomasi.setSensitivity(100.f); // some hundred corners in the test image
+    nms.setThreshold(0.1f);
+    gauss.add(&tensor);
+    tensor.add(&shiTomasi);
+    shiTomasi.add(&nms);
+    if (compact) {
+        nms.add(&histoPyramid);
+    }
+
+    VideoSource video;
+    video.set(&gauss);
+    video({ width, height }, pixels.data(), true, 0, GL_RGBA);
+    nms.getMemTransferObj()->setOutputPixelFormat(GL_RGBA);
+
+    const GLuint inputTex = video.getInputTexId();
+    std::vector<Keypoint> keypoints;
+    int numKeypoints = 0;
+
+    // both variants must find the same keypoints
+    if (compact) {
+        nms.getResultData(result.data());
+        if (histoPyramid.getKeypoints(keypoints) != countKeypoints(result)) {
+            state.SkipWithError("HistoPyramidProc and the NMS output differ in the number of keypoints");
+            return;
+        }
+    }
+
+    const Clock::time_point start = Clock::now();
+    for (auto _ : state) {
+        video({ width, height }, nullptr, false, inputTex, GL_RGBA);
+        if (compact) {
+            numKeypoints = histoPyramid.getKeypoints(keypoints);
+        } else {
+            nms.getResultData(result.data());
+            numKeypoints = countKeypoints(result);
+        }
+    }
+    setCounters(state, width, height, Clock::now() - start);
+
+    state.counters["keypoints"] = (double)numKeypoints;
+    benchmark::DoNotOptimize(result.data());
+}
+
+static void BM_KeypointsFullReadback(benchmark::State& state) {
+    runKeypoints(state, false);
+}
+BENCHMARK(BM_KeypointsFullReadback)->Apply(setFrameSizes);
+
+static void BM_KeypointsHistoPyramid(benchmark::State& state) {
+    runKeypoints(state, true);
+}
+BENCHMARK(BM_KeypointsHistoPyramid)->Apply(setFrameSizes);
+
+// sparse tracking of a grid of 1024 points by a KltPipeline incl. the readback of the points
+static void BM_KltPipeline(benchmark::State& state) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    std::vector<unsigned char> pixels = getTestPixels(width, height);
+
+    std::vector<TrackedPoint> points;
+    for (int y = 0; y < 32; y++) {
+        for (int x = 0; x < 32; x++) {
+            points.emplace_back((x + 0.5f) * width / 32.f, (y + 0.5f) * height / 32.f);
+        }
+    }
+
+    KltPipeline klt(4, int(points.size()));
+
+    VideoSource video;
+    video.set(&klt);
+    video({ width, height }, pixels.data(), true, 0, GL_RGBA);
+
+    const GLuint inputTex = video.getInputTexId();
+    std::vector<TrackedPoint> result;
+
+    const Clock::time_point start = Clock::now();
+    for (auto _ : state) {
+        klt.getTracker().setPoints(points);
+        video({ width, height }, nullptr, false, inputTex, GL_RGBA);
+        klt.getTracker().getPoints(result);
+    }
+    setCounters(state, width, height, Clock::now() - start);
+
+    state.counters["points"] = (double)result.size();
+}
+BENCHMARK(BM_KltPipeline)->Apply(setFrameSizes);
+
+#pragma mark histogram
+
+// 256 bin histogram of the grayscale image with the readback of the whole image and a
+// histogram on the CPU (<gpu> is false) or with a HistogramProc (<gpu> is true)
+static void runHistogram(benchmark::State& state, bool gpu) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    std::vector<unsigned char> pixels = getTestPixels(width, height), result(width * height * 4);
+
+    GrayscaleProc grayscale;
+    HistogramProc histogram;
+    if (gpu) {
+        grayscale.add(&histogram);
+    }
+
+    VideoSource video;
+    video.set(&grayscale);
+    video({ width, height }, pixels.data(), true, 0, GL_RGBA);
+
+    const GLuint inputTex = video.getInputTexId();
+    std::vector<unsigned int> counts(256);
+
+    const Clock::time_point start = Clock::now();
+    for (auto _ : state) {
+        video({ width, height }, nullptr, false, inputTex, GL_RGBA);
+        if (gpu) {
+            histogram.getHistograms(counts);
+        } else {
+            grayscale.getResultData(result.data());
+            std::fill(counts.begin(), counts.end(), 0);
+            for (size_t i = 0; i < result.size(); i += 4) {
+                counts[result[i]]++;
+            }
+        }
+    }
+    setCounters(state, width, height, Clock::now() - start);
+
+    benchmark::DoNotOptimize(counts.data());
+}
+
+static void BM_HistogramCPU(benchmark::State& state) {
+    runHistogram(state, false);
+}
+BENCHMARK(BM_HistogramCPU)->Apply(setFrameSizes);
+
+static void BM_HistogramProc(benchmark::State& state) {
+    runHistogram(state, true);
+}
+BENCHMARK(BM_HistogramProc)->Apply(setFrameSizes);
+
+#pragma mark reduce
+
+// mean of the red channel with the readback of the whole image and a sum on the CPU
+// (<gpu> is false) or with a ReduceProc (<gpu> is true)
+static void runReduce(benchmark::State& state, bool gpu) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    std::vector<unsigned char> pixels = getTestPixels(width, height), result(width * height * 4);
+
+    GainProc gain(1.f);
+    ReduceProc reduce(ReduceMean);
+    if (gpu) {
+        gain.add(&reduce);
+    }
+
+    VideoSource video;
+    video.set(&gain);
+    video({ width, height }, pixels.data(), true, 0, GL_RGBA);
+
+    const GLuint inputTex = video.getInputTexId();
+    float mean[4] = { 0.f };
+
+    const Clock::time_point start = Clock::now();
+    for (auto _ : state) {
+        video({ width, height }, nullptr, false, inputTex, GL_RGBA);
+        if (gpu) {
+            reduce.getResult(mean);
+        } else {
+            gain.getResultData(result.data());
+            unsigned long long sum = 0;
+            for (size_t i = 0; i < result.size(); i += 4) {
+                sum += result[i];
+            }
+            mean[0] = float(sum) / (255.f * width * height);
+        }
+    }
+    setCounters(state, width, height, Clock::now() - start);
+
+    benchmark::DoNotOptimize(mean);
+}
+
+static void BM_ReduceCPU(benchmark::State& state) {
+    runReduce(state, false);
+}
+BENCHMARK(BM_ReduceCPU)->Apply(setFrameSizes);
+
+static void BM_ReduceProc(benchmark::State& state) {
+    runReduce(state, true);
+}
+BENCHMARK(BM_ReduceProc)->Apply(setFrameSizes);
+
+#pragma mark MemTransfer
+
+// upload of RGBA frames (as done by VideoSource for each frame) through <range(2)> pixel buffers (0 = direct)
+static void BM_MemTransferUpload(benchmark::State& state) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    std::vector<unsigned char> pixels = getTestPixels(width, height);
+
+    Core core;
+    core.init();
+    std::unique_ptr<MemTransfer> transfer(core.createMemTransfer());
+    transfer->init();
+    transfer->setUploadBuffers((int)state.range(2));
+
+    const Clock::time_point start = Clock::now();
+    for (auto _ : state) {
+        transfer->prepareInput(width, height, GL_RGBA, pixels.data());
+        transfer->toGPU(pixels.data());
+    }
+    glFinish();
+    setCounters(state, width, height, Clock::now() - start);
+}
+BENCHMARK(BM_MemTransferUpload)->Apply([](benchmark::internal::Benchmark* b) { setBufferArgs(b, 0, 2); });
+
+// readback of the RGBA output of a proc
+static void BM_MemTransferReadback(benchmark::State& state) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    std::vector<unsigned char> pixels = getTestPixels(width, height), result(width * height * 4);
+
+    VideoSource video;
+    GainProc gain(1.f);
+    video.set(&gain);
+    video({ width, height }, pixels.data(), true, 0, GL_RGBA);
+    gain.getMemTransferObj()->setOutputPixelFormat(GL_RGBA);
+    glFinish();
+
+    const Clock::time_point start = Clock::now();
+    for (auto _ : state) {
+        gain.getResultData(result.data());
+        benchmark::DoNotOptimize(result.data());
+    }
+    setCounters(state, width, height, Clock::now() - start);
+}
+BENCHMARK(BM_MemTransferReadback)->Apply(setFrameSizes);
+
+// render and read back each frame with a ring of <range(2)> pixel buffers (1 = synchronous)
+static void BM_MemTransferReadbackAsync(benchmark::State& state) {
+    if (!getContext()) {
+        state.SkipWithError("no headless OpenGL context");
+        return;
+    }
+
+    const int width = (int)state.range(0), height = (int)state.range(1);
+    std::vector<unsigned char> pixels = getTestPixels(width, height);
+
+    VideoSource video;
+    GainProc gain(1.f);
+    video.set(&gain);
+    video({ width, height }, pixels.data(), true, 0, GL_RGBA);
+
+    const GLuint inputTex = video.getInputTexId();
+    MemTransfer* transfer = gain.getMemTransferObj();
+    transfer->setOutputPixelFormat(GL_RGBA);
+    transfer->setReadbackBuffers((int)state.range(2));
+
+    unsigned int checksum = 0;
+    MemTransfer::FrameDelegate delegate = [&](const Size2d& size, const void* data, size_t rowStride) {
+        checksum += ((const unsigned char*)data)[0];
+    };
+    glFinish();
+
+    const Clock::time_point start = Clock::now();
+    for (auto _ : state) {
+        video({ width, height }, nullptr, false, inputTex, GL_RGBA);
+        gain.getResultData(delegate);
+    }
+    transfer->flushReadback();
+    setCounters(state, width, height, Clock::now() - start);
+
+    benchmark::DoNotOptimize(checksum);
+}
+BENCHMARK(BM_MemTransferReadbackAsync)->Apply([](benchmark::internal::Benchmark* b) { setBufferArgs(b, 1, 3); });
+
+#pragma mark main
+
+int main(int argc, char** argv) {
+    // software rendering by default (reproducible results)
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+
+    // JSON output by default
+    std::vector<char*> args(argv, argv + argc);
+    bool hasFormat = false;
+    for (int i = 1; i < argc; i++) {
+        hasFormat |= (strncmp(argv[i], "--benchmark_format", 18) == 0);
+    }
+
+    std::string jsonFormat = "--benchmark_format=json";
+    if (!hasFormat) {
+        args.insert(args.begin() + 1, &jsonFormat[0]);
+    }
+
+    int numArgs = (int)args.size();
+    benchmark::Initialize(&numArgs, args.data());
+    if (benchmark::ReportUnrecognizedArguments(numArgs, args.data())) {
+        return 1;
+    }
+
+    if (!getContext()) {
+        OG_LOGERR("ogles_gpgpu_bench", "could not create a headless OpenGL context");
+        return 1;
+    }
+
+    // the benchmarks check for OpenGL errors themselves (checkGLErr() would clear them)
+    Tools::setGLErrorCheckInterval(0);
+
+    benchmark::AddCustomContext("gl_renderer", (const char*)glGetString(GL_RENDERER));
+    benchmark::AddCustomContext("gl_version", (const char*)glGetString(GL_VERSION));
+    benchmark::AddCustomContext("gl_backend", HeadlessContext::getBackendName(getContext().getBackend()));
+
+    benchmark::RunSpecifiedBenchmarks();
+
+    getContext().shutdown();
+
+    return 0;
+}
@@ -17,33 +17,6 @@
 using namespace std;
 using namespace ogles_gpgpu;
 
-#pragma mark singleton stuff
-
-// initialize static variables
-
-Core* Core::instance = NULL; // no instance
-
-Core* Core::getInstance() {
-    if (!Core::instance) {
-        Core::instance = new Core();
-    }
-
-    return Core::instance;
-}
-
-void Core::destroy() {
-    if (Core::instance) {
-        delete Core::instance;
-        Core::instance = NULL;
-    }
-}
-
-#pragma mark other static methods
-
-bool Core::tryEnablePlatformOptimizations() {
-    return MemTransferFactory::tryEnablePlatformOptimizations();
-}
-
 #pragma mark constructor and setup methods
 
 Core::Core() {
@@ -51,6 +24,9 @@ Core::Core() {
     initialized = false;
     useMipmaps = false;
     glExtNPOTMipmaps = false;
+    useFilterFusion = false;
+    useMemoryPlanner = false;
+    roiDirty = false;
     renderDisp = NULL;
     glContextPtr = NULL;
     inputTexTarget = GL_TEXTURE_2D;
@@ -63,6 +39,14 @@ Core::~Core() {
     cleanup();
 }
 
+bool Core::tryEnablePlatformOptimizations() {
+    return memTransferFactory.tryEnablePlatformOptimizations();
+}
+
+MemTransfer* Core::createMemTransfer() {
+    return memTransferFactory.createInstance(glContextPtr);
+}
+
 void Core::reset() {
     OG_LOGINF("Core", "resetting core");
 
@@ -87,14 +71,32 @@ void Core::addProcToPipeline(ProcInterface* proc) {
 
     OG_LOGINF("Core", "adding processor #%u to pipeline", (unsigned int)(pipeline.size() + 1));
 
+    // bind processor to this context
+    proc->setCore(this);
+
     // add not processor to pipeline
     pipeline.push_back(proc);
 }
 
+const MemoryReport& Core::planMemory(ProcInterface* root) {
+    MemoryPlanner planner(texturePool);
+    memoryReport = planner.plan(root);
+
+    return memoryReport;
+}
+
+int Core::planRoi(ProcInterface* root) {
+    RoiPlanner planner;
+    roiDirty = false;
+
+    return planner.plan(root, roi);
+}
+
 Disp* Core::createRenderDisplay(int dispW, int dispH, RenderOrientation orientation) {
     assert(!renderDisp);
 
     renderDisp = new Disp();
+    renderDisp->setCore(this);
     renderDisp->setOutputRenderOrientation(orientation);
 
     if (dispW > 0 && dispH > 0) {
@@ -121,6 +123,21 @@ void Core::init(void* glContext) {
     initialized = true;
 }
 
+#if defined(OGLES_GPGPU_HEADLESS)
+bool Core::initHeadless(HeadlessBackend backend) {
+    std::unique_ptr<HeadlessContext> ctx(new HeadlessContext);
+    if (!ctx->setup(backend)) {
+        return false;
+    }
+
+    headlessContext = std::move(ctx);
+
+    init(headlessContext.get());
+
+    return true;
+}
+#endif
+
 void Core::prepare(int inW, int inH, GLenum inFmt) {
     assert(initialized && inW > 0 && inH > 0 && pipeline.size() > 0);
 
@@ -313,17 +330,40 @@ void Core::process() {
     // set input texture id
     firstProc->useTexture(inputTexId, 1, inputTexTarget);
 
+    beginFrame();
+
     // run the processors in the pipeline
     for (auto& it : pipeline) {
+        if (profiler.getEnabled()) {
+            profiler.begin(it);
+        }
+
         it->render();
+
+        if (profiler.getEnabled()) {
+            profiler.end(it);
+        }
+
         glFinish();
     }
 
+    endFrame();
+
 #ifdef OGLES_GPGPU_BENCHMARK
     Tools::stopTimeMeasurement();
 #endif
 }
 
+void Core::beginFrame() {
+    glState.beginFrame();
+    profiler.beginFrame();
+}
+
+void Core::endFrame() {
+    glState.endFrame();
+    profiler.endFrame();
+}
+
 void Core::getInputData(unsigned char* buf) {
     assert(initialized);
 
@@ -400,4 +440,8 @@ void Core::cleanup() {
     // the processor objects are not deleted in this class, because it only
     // stores weak references
     pipeline.clear();
+
+    // delete shared render targets
+    texturePool.clear();
+    memoryReport = MemoryReport();
 }
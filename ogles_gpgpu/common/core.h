@@ -16,9 +16,22 @@
 
 #include "common_includes.h"
 #include "gl/memtransfer.h"
+#include "gl/memtransfer_factory.h"
+#include "gl/quad_buffer.h"
+#include "gl/shader_cache.h"
+#include "gl/state_cache.h"
+#include "proc/base/memoryplanner.h"
 #include "proc/base/procinterface.h"
+#include "proc/base/profiler.h"
+#include "proc/base/roiplanner.h"
+#include "gl/texture_pool.h"
+
+#if defined(OGLES_GPGPU_HEADLESS)
+#include "../platform/opengl/headless.h"
+#endif
 
 #include <list>
+#include <memory>
 #include <vector>
 
 using namespace std;
@@ -30,25 +43,25 @@ class Disp;
 /**
  * main processing handler. set up and initialize processing pipeline.
  * set processing input, run the processing tasks, get the processing output.
- * is a singleton class that returns an object via getInstance().
+ * each Core instance is an independent processing context that owns its pipeline,
+ * its MemTransfer factory state and its render display. several instances can be
+ * used side by side (i.e. one per OpenGL context or per processing graph).
  */
 class Core {
 public:
     /**
-     * Get singleton instance.
+     * Constructor.
      */
-    static Core* getInstance();
-
-    /**
-     * Destroy singleton instance.
-     */
-    static void destroy();
+    Core();
 
     /**
      * Deconstructor. Will call cleanup().
      */
     ~Core();
 
+    Core(const Core&) = delete;
+    Core& operator=(const Core&) = delete;
+
     /**
      * Reset the complete processing pipeline (will also call cleanup()).
      */
@@ -56,6 +69,7 @@ public:
 
     /**
      * Add a weak ref pointer to a GPGPU processor object to the pipeline.
+     * The processor will be bound to this context (see ProcInterface::setCore()).
      * Note: OpenGL context must be initialized before a ProcInterface object
      * was created!
      */
@@ -124,6 +138,134 @@ public:
         return useMipmaps;
     }
 
+    /**
+     * Fuse chains of point-wise filters: <use>. If enabled, consecutive point-wise
+     * FilterProcBase procs in a filter graph (see ProcInterface::add()) are executed
+     * as one combined shader pass. Only the last proc of a fused chain provides an
+     * output texture. Must be set before the graph is prepared.
+     */
+    void setUseFilterFusion(bool use) {
+        useFilterFusion = use;
+    }
+
+    /**
+     * Get "fuse point-wise filters" status.
+     */
+    bool getUseFilterFusion() const {
+        return useFilterFusion;
+    }
+
+    /**
+     * Share render targets between procs: <use>. If enabled, the output textures of
+     * intermediate procs in a filter graph with non-overlapping lifetimes are taken
+     * from the texture pool of this context (see MemoryPlanner). Their results are
+     * not available anymore after processing.
+     */
+    void setUseMemoryPlanner(bool use) {
+        useMemoryPlanner = use;
+    }
+
+    /**
+     * Get "share render targets" status.
+     */
+    bool getUseMemoryPlanner() const {
+        return useMemoryPlanner;
+    }
+
+    /**
+     * Plan the render target memory of the prepared filter graph that starts at <root>.
+     * Returns the memory report.
+     */
+    const MemoryReport& planMemory(ProcInterface* root);
+
+    /**
+     * Get the memory report of the last planMemory() call.
+     */
+    const MemoryReport& getMemoryReport() const {
+        return memoryReport;
+    }
+
+    /**
+     * Restrict processing to the region of interest <roi> of the input frame (in input
+     * pixels). The filter graph is planned again before the next frame (see RoiPlanner).
+     * The results outside of the region (plus the halo of the neighbourhood filters) are
+     * undefined. An empty <roi> processes the whole frame.
+     */
+    void setRoi(const Rect2d& r) {
+        roi = r;
+        roiDirty = true;
+    }
+
+    /**
+     * Get the region of interest of the input frame (empty for the whole frame).
+     */
+    const Rect2d& getRoi() const {
+        return roi;
+    }
+
+    /**
+     * Returns true if the region of interest changed since the last planRoi() call.
+     */
+    bool getRoiDirty() const {
+        return roiDirty;
+    }
+
+    /**
+     * Restrict the prepared filter graph that starts at <root> to the region of interest.
+     * Returns the number of procs that render a part of their output frame.
+     */
+    int planRoi(ProcInterface* root);
+
+    /**
+     * Get the cache of shared shader programs of this context.
+     */
+    ShaderCache& getShaderCache() {
+        return shaderCache;
+    }
+
+    /**
+     * Get the OpenGL state cache of this context. Procs set their render state
+     * through it, so that redundant calls are skipped.
+     */
+    GLStateCache& getGLState() {
+        return glState;
+    }
+
+    /**
+     * Get the per-proc CPU/GPU time profiler of this context (disabled by default).
+     */
+    Profiler& getProfiler() {
+        return profiler;
+    }
+
+    /**
+     * Start processing a frame: resets the OpenGL state cache and starts a
+     * profiler frame. Called before the pipeline is processed. Callers that run
+     * ProcInterface::process() themselves (i.e. without VideoSource) must call it
+     * (or at least getGLState().invalidate()) before, whenever OpenGL state may
+     * have been changed outside of the cache since the last frame.
+     */
+    void beginFrame();
+
+    /**
+     * End processing a frame. Called after the pipeline was processed.
+     */
+    void endFrame();
+
+    /**
+     * Get the full-screen quad geometry shared by the procs of this context.
+     */
+    QuadBuffer& getQuadBuffer() {
+        return quadBuffer;
+    }
+
+    /**
+     * Get the pool of shared render target textures of this context.
+     */
+    TexturePool& getTexturePool() {
+        return texturePool;
+    }
+
     /**
      * Set input as OpenGL texture id.
      */
@@ -186,9 +328,38 @@ public:
 #endif
 
     /**
-     * Global switch for platform optimizations. Should be set before calling init().
+     * Switch for platform optimizations of this context. Should be set before calling init().
      */
-    static bool tryEnablePlatformOptimizations();
+    bool tryEnablePlatformOptimizations();
+
+    /**
+     * Create a new MemTransfer instance for this context (strong ref., caller takes ownership).
+     */
+    MemTransfer* createMemTransfer();
+
+    /**
+     * Get the MemTransfer factory of this context.
+     */
+    MemTransferFactory& getMemTransferFactory() {
+        return memTransferFactory;
+    }
+
+#if defined(OGLES_GPGPU_HEADLESS)
+    /**
+     * Create a headless OpenGL context with backend <backend> (no display or window
+     * system needed), make it current and call init() with it. The context is owned
+     * by this Core and destroyed after all other OpenGL resources.
+     * Returns false if no context could be created.
+     */
+    bool initHeadless(HeadlessBackend backend = HeadlessBackendAuto);
+
+    /**
+     * Get the headless OpenGL context created by initHeadless() (may be NULL). Weak ref.
+     */
+    HeadlessContext* getHeadlessContext() const {
+        return headlessContext.get();
+    }
+#endif
 
 #ifdef OGLES_GPGPU_IOS
     /**
@@ -205,16 +376,6 @@ public:
 #endif
 
 private:
-    /**
-     * Private constructor for singleton instance.
-     */
-    Core();
-
-    /**
-     * Empty copy constructor.
-     */
-    Core(const Core&) {}
-
     /**
      * Check which OpenGL extensions are available.
      */
@@ -228,7 +389,19 @@ private:
      */
     void cleanup();
 
-    static Core* instance; // singleton instance
+#if defined(OGLES_GPGPU_HEADLESS)
+    std::unique_ptr<HeadlessContext> headlessContext; // declared first, so that it is destroyed last. strong ref.!
+#endif
+
+    MemTransferFactory memTransferFactory; // creates MemTransfer objects for the FBOs of this context
+
+    ShaderCache shaderCache; // shader programs shared by the procs of this context
+
+    GLStateCache glState; // shadowed OpenGL render state of this context
+
+    QuadBuffer quadBuffer; // full-screen quad geometry of this context
+
+    Profiler profiler; // per-proc CPU/GPU times
 
     void* glContextPtr; // pointer to OpenGL context (platform specific type), weak ref.
 
@@ -245,6 +418,15 @@ private:
     bool useMipmaps; // use mipmaps?
     bool glExtNPOTMipmaps; // hardware supports NPOT mipmapping?
 
+    bool useFilterFusion; // fuse chains of point-wise filters?
+
+    bool useMemoryPlanner; // share render targets between procs?
+    TexturePool texturePool; // shared render target textures
+    MemoryReport memoryReport; // result of the last planMemory() call
+
+    Rect2d roi; // region of interest of the input frame (empty for the whole frame)
+    bool roiDirty; // region of interest changed since the last planRoi() call?
+
     bool inputSizeIsPOT; // input frame size is POT?
 
     int inputFrameW; // input frame width
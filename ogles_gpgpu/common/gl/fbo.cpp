@@ -14,18 +14,16 @@
 using namespace std;
 using namespace ogles_gpgpu;
 
-FBO::FBO() {
+FBO::FBO(Core* core)
+    : core(core) {
     // set defaults
     id = 0;
     texW = texH = 0;
     attachedTexId = 0;
     glTexUnit = 0;
 
-    // get singleton Core instance
-    core = Core::getInstance();
-
     // create a dedicated MemTransfer object for this FBO
-    memTransfer = MemTransferFactory::createInstance();
+    memTransfer = core ? core->createMemTransfer() : MemTransferFactory().createInstance();
     memTransfer->init();
 
     // generate a FBO id
@@ -40,12 +38,20 @@ FBO::~FBO() {
 }
 
 void FBO::bind() {
-    glBindFramebuffer(GL_FRAMEBUFFER, id);
+    if (core) {
+        core->getGLState().bindFramebuffer(id);
+    } else {
+        glBindFramebuffer(GL_FRAMEBUFFER, id);
+    }
     Tools::checkGLErr("FBO", "glBindFrameBuffer");
 }
 
 void FBO::unbind() {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (core) {
+        core->getGLState().bindFramebuffer(0);
+    } else {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
 }
 
 void FBO::destroyFramebuffer() {
@@ -65,7 +71,7 @@ void FBO::createAttachedTex(int w, int h, bool genMipmap, GLenum attachment, GLe
     assert(memTransfer && w > 0 && h > 0);
 
     // get a corrected width and height when we use a mipmap
-    if (genMipmap && core->getUseMipmaps()) {
+    if (genMipmap && core && core->getUseMipmaps()) {
         w = Tools::getBiggerPOTValue(w);
         h = Tools::getBiggerPOTValue(h);
     }
@@ -116,6 +122,41 @@ void FBO::createAttachedTex(int w, int h, bool genMipmap, GLenum attachment, GLe
     unbind();
 }
 
+void FBO::attachTex(GLuint texId, int w, int h, GLenum attachment, GLenum target) {
+    assert(memTransfer && texId > 0 && w > 0 && h > 0);
+
+    // the own output texture is replaced by the shared one (which is read back from now on)
+    memTransfer->useOutput(texId, w, h);
+
+    // all output textures are RGBA, so a complete FBO stays complete with a texture of the same
+    // size (the textures are swapped on each frame in rotation and feedback mode)
+    const bool complete = attachedTexId > 0 && texW == w && texH == h;
+
+    texW = w;
+    texH = h;
+
+    // bind it to FBO
+    bind();
+
+    glFramebufferTexture2D(GL_FRAMEBUFFER,
+        attachment,
+        target,
+        texId, 0);
+
+    GLenum fboStatus = complete ? GL_FRAMEBUFFER_COMPLETE : glCheckFramebufferStatus(GL_FRAMEBUFFER);
+
+    if (fboStatus != GL_FRAMEBUFFER_COMPLETE) {
+        OG_LOGERR("FBO", "Framebuffer incomplete (error %d)", fboStatus);
+        attachedTexId = 0;
+    } else {
+        OG_LOGINF("FBO", "FBO with ID %d: attached shared texture %d of size %dx%d", id, texId, w, h);
+        attachedTexId = texId;
+    }
+
+    // unbind FBO
+    unbind();
+}
+
 void FBO::readBuffer(unsigned char* buf) {
     assert(memTransfer && attachedTexId > 0 && texW > 0 && texH > 0);
 
@@ -30,9 +30,11 @@ public:
     using FrameDelegate = MemTransfer::FrameDelegate;
 
     /**
-     * Constructor.
+     * Constructor. The processing context <core> provides the MemTransfer factory
+     * and mipmap settings. If it is NULL, a non-optimized MemTransfer object is used
+     * and mipmaps are disabled.
      */
-    FBO();
+    FBO(Core* core = NULL);
 
     /**
      * Deconstructor.
@@ -90,6 +92,13 @@ public:
      */
     virtual void createAttachedTex(int w, int h, bool genMipmap = false, GLenum attachment = GL_COLOR_ATTACHMENT0, GLenum target = GL_TEXTURE_2D);
 
+    /**
+     * Attach the existing texture <texId> of size <w>x<h> to this FBO instead of an own
+     * output texture. The texture is not owned by the FBO (i.e. it comes from a TexturePool).
+     * An own output texture will be released.
+     */
+    virtual void attachTex(GLuint texId, int w, int h, GLenum attachment = GL_COLOR_ATTACHMENT0, GLenum target = GL_TEXTURE_2D);
+
     /**
      * Copy the framebuffer data which was written to the framebuffer texture back to
      * main memory at <buf>.
@@ -138,7 +147,7 @@ protected:
      */
     virtual void generateIds();
 
-    Core* core; // Core singleton
+    Core* core; // processing context. weak ref.
 
     MemTransfer* memTransfer; // MemTransfer object associated with this FBO
 
@@ -9,6 +9,8 @@
 
 #include "memtransfer.h"
 
+#include <cstring>
+
 using namespace ogles_gpgpu;
 
 #pragma mark static methods
@@ -19,6 +21,25 @@ bool MemTransfer::initPlatformOptimizations() {
     return false;
 }
 
+int MemTransfer::getBytesPerPixel(GLenum pxFormat) {
+    switch (pxFormat) {
+    case GL_RGBA:
+#if defined(GL_BGRA)
+    case GL_BGRA:
+#endif
+        return 4;
+    case GL_RGB:
+        return 3;
+    case GL_LUMINANCE_ALPHA:
+        return 2;
+    case GL_LUMINANCE:
+    case GL_ALPHA:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
 #pragma mark constructor/deconstructor
 
 #if ANDROID
@@ -49,8 +70,8 @@ MemTransfer::~MemTransfer() {
 GLuint MemTransfer::prepareInput(int inTexW, int inTexH, GLenum inputPxFormat, void* inputDataPtr) {
     assert(initialized && inTexW > 0 && inTexH > 0);
 
-    if ((inputDataPtr == nullptr) && (inputW == inTexW) && (inputH == inTexH) && (inputPixelFormat == inputPxFormat)) {
-        return inputTexId; // no change
+    if (preparedInput && (inputW == inTexW) && (inputH == inTexH) && (inputPixelFormat == inputPxFormat)) {
+        return inputTexId; // no change -- the input data is uploaded to the same texture
     }
 
     if (preparedInput) { // already prepared -- release buffers!
@@ -70,6 +91,15 @@ GLuint MemTransfer::prepareInput(int inTexW, int inTexH, GLenum inputPxFormat, v
         return 0;
     }
 
+    // allocate the texture storage once, the data is uploaded with toGPU()
+    // (not for GL_NONE, i.e. when the input texture is provided by another proc)
+    if (getBytesPerPixel(inputPixelFormat) > 0) {
+        setCommonTextureParams(inputTexId);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, inputW, inputH, 0, inputPixelFormat, GL_UNSIGNED_BYTE, NULL);
+
+        Tools::checkGLErr("MemTransfer", "input texture creation");
+    }
+
     // done
     preparedInput = true;
 
@@ -81,7 +111,7 @@ GLuint MemTransfer::prepareInput(int inTexW, int inTexH, GLenum inputPxFormat, v
 GLuint MemTransfer::prepareOutput(int outTexW, int outTexH) {
     assert(initialized && outTexW > 0 && outTexH > 0);
 
-    if (outputW == outTexW && outputH == outTexH) {
+    if (!sharedOutput && outputW == outTexW && outputH == outTexH) {
         return outputTexId; // no change
     }
 
@@ -124,35 +154,133 @@ GLuint MemTransfer::prepareOutput(int outTexW, int outTexH) {
 }
 
 void MemTransfer::releaseInput() {
+    releaseUploadBuffers();
+
     if (inputTexId > 0) {
         glDeleteTextures(1, &inputTexId);
         inputTexId = 0;
     }
+
+    // force re-creation in prepareInput()
+    inputW = inputH = 0;
+    preparedInput = false;
 }
 
 void MemTransfer::releaseOutput() {
-    if (outputTexId > 0) {
-        glDeleteTextures(1, &outputTexId);
-        outputTexId = 0;
+    releaseReadbackBuffers();
+    releaseOutputTex();
+
+    // force re-creation in prepareOutput()
+    outputW = outputH = 0;
+    preparedOutput = false;
+    sharedOutput = false;
+}
+
+void MemTransfer::useOutput(GLuint texId, int outTexW, int outTexH) {
+    assert(initialized && texId > 0 && outTexW > 0 && outTexH > 0);
+
+    // the own output texture is not needed anymore (the pending readbacks are kept, the
+    // texture is swapped on each frame in rotation and feedback mode)
+    if (!sharedOutput) {
+        releaseOutputTex();
     }
+
+    outputW = outTexW;
+    outputH = outTexH;
+    outputTexId = texId;
+
+    sharedOutput = true;
+    preparedOutput = true;
 }
 
 void MemTransfer::toGPU(const unsigned char* buf) {
-    assert(preparedInput && inputTexId > 0 && buf);
+    const int bytesPerPixel = getBytesPerPixel(inputPixelFormat);
+    assert(preparedInput && inputTexId > 0 && buf && bytesPerPixel > 0);
+
+    const size_t rowBytes = (size_t)inputW * bytesPerPixel;
+    size_t rowStride = (inputRowStride > 0) ? inputRowStride : rowBytes;
+    assert(rowStride >= rowBytes && rowStride % bytesPerPixel == 0);
 
     // set input texture
     glBindTexture(GL_TEXTURE_2D, inputTexId); // bind input texture
 
-    // copy data as texture to GPU (tested: OS X)
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, inputW, inputH, 0, inputPixelFormat, GL_UNSIGNED_BYTE, buf);
+
+    if (rowStride != rowBytes) {
+#if defined(GL_UNPACK_ROW_LENGTH)
+        // padded rows are skipped by the driver
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, (GLint)(rowStride / bytesPerPixel));
+#else
+        // repack the rows
+        uploadPixels.resize(rowBytes * inputH);
+        for (int y = 0; y < inputH; y++) {
+            memcpy(&uploadPixels[y * rowBytes], buf + y * rowStride, rowBytes);
+        }
+        buf = &uploadPixels[0];
+        rowStride = rowBytes;
+#endif
+    }
+
+    const unsigned char* data = buf;
+
+#ifdef OGLES_GPGPU_PIXEL_BUFFER
+    if (numUploadBuffers > 0) {
+        const size_t numBytes = rowStride * (inputH - 1) + rowBytes;
+
+        if ((int)uploadBuffers.size() != numUploadBuffers || uploadBufferSize != numBytes) {
+            releaseUploadBuffers();
+
+            uploadBuffers.resize(numUploadBuffers);
+            glGenBuffers(numUploadBuffers, &uploadBuffers[0]);
+            for (auto pbo : uploadBuffers) {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, numBytes, NULL, GL_STREAM_DRAW);
+            }
+            uploadBufferSize = numBytes;
+        }
+
+        // copy the data to the least recently used buffer (the GPU may still read the others)
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, uploadBuffers[uploadIndex]);
+        uploadIndex = (uploadIndex + 1) % numUploadBuffers;
+
+        void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, numBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (mapped) {
+            memcpy(mapped, buf, numBytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            data = NULL; // offset in the bound buffer
+        } else {
+            OG_LOGERR("MemTransfer", "could not map pixel buffer for upload");
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        }
+    }
+#endif
+
+    // copy data to the texture storage that was allocated in prepareInput()
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, inputW, inputH, inputPixelFormat, GL_UNSIGNED_BYTE, data);
+
+#ifdef OGLES_GPGPU_PIXEL_BUFFER
+    if (numUploadBuffers > 0) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+#endif
+
+#if defined(GL_UNPACK_ROW_LENGTH)
+    if (rowStride != rowBytes) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+#endif
 
     // check for error
-    Tools::checkGLErr("MemTransfer", "toGPU (glTexImage2D)");
+    Tools::checkGLErr("MemTransfer", "toGPU (glTexSubImage2D)");
 
     setCommonTextureParams(0);
 }
 
+void MemTransfer::setUploadBuffers(int n) {
+    assert(n >= 0);
+    numUploadBuffers = n;
+}
+
 void MemTransfer::fromGPU(unsigned char* buf) {
     assert(preparedOutput && outputTexId > 0 && buf);
 
@@ -165,9 +293,78 @@ void MemTransfer::fromGPU(unsigned char* buf) {
     Tools::checkGLErr("MemTransfer", "fromGPU (glReadPixels)");
 }
 
-// The zero copy fromGPU() call is not possibly with generic glReadPixels() access
 void MemTransfer::fromGPU(FrameDelegate& delegate) {
-    assert(false);
+    assert(preparedOutput && outputTexId > 0);
+
+#ifdef OGLES_GPGPU_PIXEL_BUFFER
+    const Size2d size(outputW, outputH);
+    const GLsizeiptr numBytes = (GLsizeiptr)bytesPerRow() * outputH;
+
+    if ((int)readbackBuffers.size() != numReadbackBuffers) {
+        flushReadback();
+        releaseReadbackBuffers();
+
+        readbackBuffers.resize(numReadbackBuffers);
+        for (auto& buffer : readbackBuffers) {
+            glGenBuffers(1, &buffer.pbo);
+        }
+    }
+
+    // the oldest readback still occupies the buffer: deliver it first
+    ReadbackBuffer& buffer = readbackBuffers[readbackIndex];
+    if (buffer.pending) {
+        mapReadbackBuffer(buffer);
+    }
+
+    // issue the readback into the pixel buffer (returns without waiting for the GPU)
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, numBytes, NULL, GL_STREAM_READ);
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, outputW, outputH, outputPixelFormat, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    Tools::checkGLErr("MemTransfer", "fromGPU (glReadPixels to pixel buffer)");
+
+    buffer.size = size;
+    buffer.delegate = delegate;
+    buffer.pending = true;
+
+    readbackIndex = (readbackIndex + 1) % numReadbackBuffers;
+
+    // deliver the readback issued <numReadbackBuffers> - 1 calls ago (this one for a single buffer)
+    ReadbackBuffer& oldest = readbackBuffers[readbackIndex];
+    if (oldest.pending) {
+        mapReadbackBuffer(oldest);
+    }
+#else
+    // no pixel buffers: read into a CPU buffer
+    readbackPixels.resize(bytesPerRow() * outputH);
+    fromGPU(&readbackPixels[0]);
+    delegate(Size2d(outputW, outputH), &readbackPixels[0], bytesPerRow());
+#endif
+}
+
+void MemTransfer::setReadbackBuffers(int n) {
+    assert(n > 0);
+    numReadbackBuffers = n;
+}
+
+bool MemTransfer::deliverReadback() {
+    // the oldest readback follows the buffer of the next readback in the ring
+    for (size_t i = 0; i < readbackBuffers.size(); i++) {
+        ReadbackBuffer& buffer = readbackBuffers[(readbackIndex + i) % readbackBuffers.size()];
+        if (buffer.pending) {
+            mapReadbackBuffer(buffer);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void MemTransfer::flushReadback() {
+    while (deliverReadback()) {
+    }
 }
 
 size_t MemTransfer::bytesPerRow() {
@@ -180,6 +377,38 @@ void MemTransfer::setOutputPixelFormat(GLenum outputPxFormat) {
 
 #pragma mark protected methods
 
+void MemTransfer::releaseReadbackBuffers() {
+#ifdef OGLES_GPGPU_PIXEL_BUFFER
+    for (auto& buffer : readbackBuffers) {
+        if (buffer.pbo > 0) {
+            glDeleteBuffers(1, &buffer.pbo);
+        }
+    }
+#endif
+
+    readbackBuffers.clear();
+    readbackIndex = 0;
+}
+
+void MemTransfer::releaseOutputTex() {
+    if (outputTexId > 0 && !sharedOutput) {
+        glDeleteTextures(1, &outputTexId);
+    }
+    outputTexId = 0;
+}
+
+void MemTransfer::releaseUploadBuffers() {
+#ifdef OGLES_GPGPU_PIXEL_BUFFER
+    if (!uploadBuffers.empty()) {
+        glDeleteBuffers((GLsizei)uploadBuffers.size(), &uploadBuffers[0]);
+    }
+#endif
+
+    uploadBuffers.clear();
+    uploadBufferSize = 0;
+    uploadIndex = 0;
+}
+
 void MemTransfer::setCommonTextureParams(GLuint texId, GLenum target) {
     if (texId > 0) {
         Tools::checkGLErr("MemTransfer", "setCommonTextureParams (>glBindTexture)");
@@ -191,3 +420,32 @@ void MemTransfer::setCommonTextureParams(GLuint texId, GLenum target) {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 }
+
+#pragma mark private methods
+
+void MemTransfer::mapReadbackBuffer(ReadbackBuffer& buffer) {
+    assert(buffer.pending);
+    buffer.pending = false;
+
+#ifdef OGLES_GPGPU_PIXEL_BUFFER
+    const size_t rowStride = buffer.size.width * 4; // assume GL_{BGRA,RGBA}
+    const GLsizeiptr numBytes = (GLsizeiptr)rowStride * buffer.size.height;
+
+    // waits until the readback is finished (if it is not yet)
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pbo);
+    const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, numBytes, GL_MAP_READ_BIT);
+
+    if (pixels) {
+        buffer.delegate(buffer.size, pixels, rowStride);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    } else {
+        OG_LOGERR("MemTransfer", "could not map pixel buffer %d", buffer.pbo);
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    Tools::checkGLErr("MemTransfer", "mapReadbackBuffer");
+#endif
+
+    buffer.delegate = nullptr;
+}
@@ -16,6 +16,12 @@
 
 #include "../common_includes.h"
 #include <functional>
+#include <vector>
+
+// pixel buffer objects (GL_PIXEL_PACK_BUFFER, GL_PIXEL_UNPACK_BUFFER) and glMapBufferRange() are available?
+#if defined(OGLES_GPGPU_OPENGL) && !defined(__APPLE__) && defined(GL_PIXEL_PACK_BUFFER) && defined(GL_MAP_READ_BIT)
+#define OGLES_GPGPU_PIXEL_BUFFER 1
+#endif
 
 namespace ogles_gpgpu {
 
@@ -47,6 +53,7 @@ public:
 
     /**
      * Prepare for input frames of size <inTexW>x<inTexH>. Return a texture id for the input frames.
+     * The texture storage is only (re-)allocated if the size or the pixel format changes.
      */
     virtual GLuint prepareInput(int inTexW, int inTexH, GLenum inputPxFormat = GL_RGBA, void* inputDataPtr = NULL);
 
@@ -70,6 +77,20 @@ public:
      */
     virtual void releaseOutput();
 
+    /**
+     * Use the texture <texId> of size <outTexW>x<outTexH> as output. The texture is
+     * owned by the caller (i.e. shared by several FBOs) and is not deleted by releaseOutput().
+     * Pending readbacks (see setReadbackBuffers()) are kept.
+     */
+    virtual void useOutput(GLuint texId, int outTexW, int outTexH);
+
+    /**
+     * Returns true if the output texture is owned by the caller (see useOutput()).
+     */
+    bool isOutputShared() const {
+        return sharedOutput;
+    }
+
     /**
      * Get input texture id.
      */
@@ -100,9 +121,41 @@ public:
 
     /**
      * Map data in <buf> to GPU.
+     * The generic implementation updates the texture that was allocated in
+     * prepareInput() with glTexSubImage2D(), optionally through a ring of
+     * pixel buffer objects (see setUploadBuffers()).
      */
     virtual void toGPU(const unsigned char* buf);
 
+    /**
+     * Set the row stride of the input data to <bytesPerRow> (0: rows are
+     * tightly packed, default). Allows to upload padded buffers without repacking.
+     */
+    void setInputRowStride(size_t bytesPerRow) {
+        inputRowStride = bytesPerRow;
+    }
+
+    /**
+     * Get the row stride of the input data (0: rows are tightly packed).
+     */
+    size_t getInputRowStride() const {
+        return inputRowStride;
+    }
+
+    /**
+     * Upload through a ring of <n> pixel buffer objects (0: upload directly, default).
+     * The input data is copied into a mapped buffer while the GPU may still
+     * read the buffers of the previous frames.
+     */
+    void setUploadBuffers(int n);
+
+    /**
+     * Get the number of pixel buffer objects for the upload.
+     */
+    int getUploadBuffers() const {
+        return numUploadBuffers;
+    }
+
     /**
      * Map data from GPU to <buf>
      */
@@ -110,9 +163,38 @@ public:
 
     /**
      * Callback for data in GPU.
+     * The generic implementation reads the output into a ring of pixel buffer
+     * objects (see setReadbackBuffers()) and calls <delegate> with the mapped
+     * buffer. Without pixel buffer support, the pixels are read into a CPU buffer.
      */
     virtual void fromGPU(FrameDelegate& delegate);
 
+    /**
+     * Use a ring of <n> pixel buffer objects for fromGPU(FrameDelegate&).
+     * With <n> = 1 (default) the delegate is called immediately. With <n> > 1
+     * the readback is only issued and the delegate is called <n> - 1 calls
+     * later, so that the CPU does not wait for the GPU.
+     */
+    void setReadbackBuffers(int n);
+
+    /**
+     * Get the number of pixel buffer objects for fromGPU(FrameDelegate&).
+     */
+    int getReadbackBuffers() const {
+        return numReadbackBuffers;
+    }
+
+    /**
+     * Call the delegate of the oldest pending readback of fromGPU(FrameDelegate&).
+     * Returns false if no readback is pending.
+     */
+    bool deliverReadback();
+
+    /**
+     * Call the delegates of all pending readbacks of fromGPU(FrameDelegate&).
+     */
+    void flushReadback();
+
     /**
      * Get output pixel format (i.e., GL_BGRA or GL_RGBA)
      */
@@ -141,6 +223,11 @@ public:
         useRawPixels = flag;
     }
 
+    /**
+     * Return the number of bytes per pixel of pixel format <pxFormat> (0 if unknown).
+     */
+    static int getBytesPerPixel(GLenum pxFormat);
+
     /**
      * Try to initialize platform optimizations. Returns true on success, else false.
      * Is only fully implemented in platform-specialized classes of MemTransfer.
@@ -154,10 +241,26 @@ protected:
      */
     virtual void setCommonTextureParams(GLuint texId, GLenum target = GL_TEXTURE_2D);
 
+    /**
+     * Delete the pixel buffer objects of the readback ring (pending readbacks are dropped).
+     */
+    void releaseReadbackBuffers();
+
+    /**
+     * Delete the own output texture (a texture of useOutput() is not deleted).
+     */
+    virtual void releaseOutputTex();
+
+    /**
+     * Delete the pixel buffer objects of the upload ring.
+     */
+    void releaseUploadBuffers();
+
     bool initialized; // is initialized?
 
     bool preparedInput; // input is prepared?
     bool preparedOutput; // output is prepared?
+    bool sharedOutput = false; // output texture is owned by the caller (see useOutput())
 
     int inputW; // input texture width
     int inputH; // input texture height
@@ -174,6 +277,32 @@ protected:
     GLenum outputPixelFormat;
 
     bool useRawPixels = false;
+
+    size_t inputRowStride = 0; // row stride of the input data in bytes (0: tightly packed)
+
+private:
+    struct ReadbackBuffer {
+        GLuint pbo = 0; // pixel buffer object
+        Size2d size; // size of the pending frame
+        FrameDelegate delegate; // delegate of the pending frame
+        bool pending = false; // readback issued, delegate not called yet
+    };
+
+    /**
+     * Map the pixel buffer of the pending readback <buffer> and call its delegate.
+     */
+    void mapReadbackBuffer(ReadbackBuffer& buffer);
+
+    int numReadbackBuffers = 1; // size of the readback ring
+    int readbackIndex = 0; // ring index of the next readback
+    std::vector<ReadbackBuffer> readbackBuffers; // readback ring
+    std::vector<unsigned char> readbackPixels; // CPU buffer if pixel buffers are not supported
+
+    int numUploadBuffers = 0; // size of the upload ring
+    int uploadIndex = 0; // ring index of the next upload
+    size_t uploadBufferSize = 0; // size of each upload buffer in bytes
+    std::vector<GLuint> uploadBuffers; // upload ring (pixel buffer objects)
+    std::vector<unsigned char> uploadPixels; // repacked rows if GL_UNPACK_ROW_LENGTH is not supported
 };
 }
 
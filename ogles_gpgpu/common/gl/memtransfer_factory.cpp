@@ -8,7 +8,6 @@
 //
 
 #include "memtransfer_factory.h"
-#include "../core.h"
 
 //#ifdef __APPLE__
 //#include "../../platform/ios/memtransfer_ios.h"
@@ -28,16 +27,14 @@
 
 using namespace ogles_gpgpu;
 
-bool MemTransferFactory::usePlatformOptimizations = false;
-
-MemTransfer* MemTransferFactory::createInstance() {
+MemTransfer* MemTransferFactory::createInstance(void* glContext) const {
     MemTransfer* instance = NULL;
 
     if (usePlatformOptimizations) { // create specialized instance
 #ifdef OGLES_GPGPU_IOS
-        instance = (MemTransfer*)new MemTransferIOS();
+        instance = (MemTransfer*)new MemTransferIOS(glContext);
 #elif OGLES_GPGPU_OSX
-        instance = (MemTransfer*)new MemTransferOSX();
+        instance = (MemTransfer*)new MemTransferOSX(glContext);
 #elif OGLES_GPGPU_ANDROID
         instance = (MemTransfer*)new MemTransferAndroid();
 #else
@@ -22,22 +22,39 @@ namespace ogles_gpgpu {
 
 /**
  * MemTransferFactory creates MemTransfer instances according to
- * the platform it was compiled for.
+ * the platform it was compiled for. Each Core context owns one factory,
+ * so that platform optimizations can be enabled per context.
  */
 class MemTransferFactory {
 public:
     /**
-     * Create a new MemTransfer instance.
+     * Constructor. Platform optimizations are disabled by default.
+     */
+    MemTransferFactory()
+        : usePlatformOptimizations(false) {
+    }
+
+    /**
+     * Create a new MemTransfer instance. Optionally pass the OpenGL context
+     * <glContext> (platform specific type) that is needed by some platform
+     * optimized implementations.
      */
-    static MemTransfer* createInstance();
+    MemTransfer* createInstance(void* glContext = NULL) const;
 
     /**
      * Try to enable platform optimizations. Returns true on success, else false.
      */
-    static bool tryEnablePlatformOptimizations();
+    bool tryEnablePlatformOptimizations();
+
+    /**
+     * Return true if platform optimizations are enabled for this factory.
+     */
+    bool getUsePlatformOptimizations() const {
+        return usePlatformOptimizations;
+    }
 
 private:
-    static bool usePlatformOptimizations; // is true if tryEnablePlatformOptimizations() was called and succeeded
+    bool usePlatformOptimizations; // is true if tryEnablePlatformOptimizations() was called and succeeded
 };
 }
 
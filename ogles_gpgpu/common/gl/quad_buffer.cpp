@@ -0,0 +1,66 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "quad_buffer.h"
+#include "../common_includes.h"
+
+#include <vector>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+// number of orientations stored in the buffer (RenderOrientationStd .. RenderOrientationDiagonalMirrored)
+static const int kNumOrientations = RenderOrientationDiagonalMirrored + 1;
+
+QuadBuffer::QuadBuffer()
+    : bufferId(0)
+    , numVertexFloats(0)
+    , numTexCoordFloats(0) {
+}
+
+QuadBuffer::~QuadBuffer() {
+    clear();
+}
+
+bool QuadBuffer::init(const GLfloat* vertices, int numVertexFloats, const GLfloat* const texCoords[], int numTexCoordFloats) {
+    clear();
+
+    this->numVertexFloats = numVertexFloats;
+    this->numTexCoordFloats = numTexCoordFloats;
+
+    // vertex positions first, then the texture coordinates of each orientation
+    vector<GLfloat> data(vertices, vertices + numVertexFloats);
+    for (int i = 0; i < kNumOrientations; i++) {
+        data.insert(data.end(), texCoords[i], texCoords[i] + numTexCoordFloats);
+    }
+
+    glGenBuffers(1, &bufferId);
+    glBindBuffer(GL_ARRAY_BUFFER, bufferId);
+    glBufferData(GL_ARRAY_BUFFER, data.size() * sizeof(GLfloat), &data[0], GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    Tools::checkGLErr("QuadBuffer", "init");
+
+    OG_LOGINF("QuadBuffer", "created buffer %d with %d values", bufferId, (int)data.size());
+
+    return bufferId != 0;
+}
+
+void QuadBuffer::clear() {
+    if (bufferId) {
+        glDeleteBuffers(1, &bufferId);
+        bufferId = 0;
+    }
+}
+
+const GLvoid* QuadBuffer::getTexCoordsOffset(RenderOrientation o) const {
+    if (o < 0 || o >= kNumOrientations) {
+        o = RenderOrientationStd;
+    }
+
+    size_t offset = (numVertexFloats + (int)o * numTexCoordFloats) * sizeof(GLfloat);
+    return (const GLvoid*)offset;
+}
@@ -0,0 +1,87 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Shared vertex buffer for full-screen quads.
+ */
+#ifndef OGLES_GPGPU_COMMON_GL_QUAD_BUFFER
+#define OGLES_GPGPU_COMMON_GL_QUAD_BUFFER
+
+#include "../common_includes.h"
+#include "../types.h"
+
+namespace ogles_gpgpu {
+
+/**
+ * QuadBuffer holds the geometry of a full-screen quad in one vertex buffer object:
+ * the vertex positions followed by the texture coordinates of each RenderOrientation.
+ * It is created once per context and used by all procs, so that the vertex data
+ * does not need to be copied from client memory for each render pass.
+ */
+class QuadBuffer {
+public:
+    /**
+     * Constructor.
+     */
+    QuadBuffer();
+
+    /**
+     * Deconstructor. Deletes the buffer.
+     */
+    ~QuadBuffer();
+
+    QuadBuffer(const QuadBuffer&) = delete;
+    QuadBuffer& operator=(const QuadBuffer&) = delete;
+
+    /**
+     * Create the buffer with the vertex positions <vertices> (<numVertexFloats> values)
+     * and one set of texture coordinates (<numTexCoordFloats> values each) for every
+     * render orientation in <texCoords>, indexed by RenderOrientation.
+     * Returns true on success.
+     */
+    bool init(const GLfloat* vertices, int numVertexFloats, const GLfloat* const texCoords[], int numTexCoordFloats);
+
+    /**
+     * Delete the buffer.
+     */
+    void clear();
+
+    /**
+     * Returns true if the buffer was created.
+     */
+    bool getIsInitialized() const {
+        return bufferId != 0;
+    }
+
+    /**
+     * Return the vertex buffer object id.
+     */
+    GLuint getBufferId() const {
+        return bufferId;
+    }
+
+    /**
+     * Return the offset of the vertex positions (for glVertexAttribPointer() with
+     * the buffer bound).
+     */
+    const GLvoid* getVerticesOffset() const {
+        return (const GLvoid*)0;
+    }
+
+    /**
+     * Return the offset of the texture coordinates for orientation <o> (for
+     * glVertexAttribPointer() with the buffer bound).
+     */
+    const GLvoid* getTexCoordsOffset(RenderOrientation o) const;
+
+private:
+    GLuint bufferId; // vertex buffer object
+    int numVertexFloats; // number of values of the vertex positions
+    int numTexCoordFloats; // number of values of one set of texture coordinates
+};
+}
+
+#endif
@@ -12,6 +12,35 @@
 using namespace std;
 using namespace ogles_gpgpu;
 
+#pragma mark program binary entry points
+
+#if defined(OGLES_GPGPU_PROGRAM_BINARY) && defined(OGLES_GPGPU_ANDROID)
+// OES_get_program_binary is an extension on OpenGL ES 2.0: query the entry points at runtime
+#define OG_GL_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH_OES
+#define OG_GL_NUM_PROGRAM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS_OES
+
+static PFNGLGETPROGRAMBINARYOESPROC ogGetProgramBinary() {
+    static auto func = (PFNGLGETPROGRAMBINARYOESPROC)eglGetProcAddress("glGetProgramBinaryOES");
+    return func;
+}
+
+static PFNGLPROGRAMBINARYOESPROC ogProgramBinary() {
+    static auto func = (PFNGLPROGRAMBINARYOESPROC)eglGetProcAddress("glProgramBinaryOES");
+    return func;
+}
+#elif defined(OGLES_GPGPU_PROGRAM_BINARY)
+#define OG_GL_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH
+#define OG_GL_NUM_PROGRAM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS
+
+static PFNGLGETPROGRAMBINARYPROC ogGetProgramBinary() {
+    return glGetProgramBinary;
+}
+
+static PFNGLPROGRAMBINARYPROC ogProgramBinary() {
+    return glProgramBinary;
+}
+#endif
+
 Shader::Shader() {
     programId = 0;
 }
@@ -29,13 +58,99 @@ bool Shader::buildFromSrc(const char* vshSrc, const char* fshSrc, const std::vec
     return (programId > 0);
 }
 
+bool Shader::buildFromBinary(GLenum format, const void* data, GLsizei length) {
+#ifdef OGLES_GPGPU_PROGRAM_BINARY
+    if (!getSupportsBinary()) {
+        return false;
+    }
+
+    programId = glCreateProgram();
+
+    if (programId == 0) {
+        OG_LOGERR("Shader", "could not create shader program");
+        return false;
+    }
+
+    ogProgramBinary()(programId, format, data, length);
+
+    // the driver may reject the binary, i.e. after an update
+    GLint linkStatus;
+    glGetProgramiv(programId, GL_LINK_STATUS, &linkStatus);
+    if (linkStatus != GL_TRUE) {
+        OG_LOGINF("Shader", "program binary was rejected by the driver");
+
+        // clear the GL error state of glProgramBinary()
+        while (glGetError() != GL_NO_ERROR) {
+        }
+
+        glDeleteProgram(programId);
+        programId = 0;
+
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool Shader::getBinary(GLenum& format, std::vector<unsigned char>& data) const {
+#ifdef OGLES_GPGPU_PROGRAM_BINARY
+    if (programId == 0 || !getSupportsBinary()) {
+        return false;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(programId, OG_GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (length <= 0) {
+        return false;
+    }
+
+    data.resize(length);
+
+    GLsizei written = 0;
+    ogGetProgramBinary()(programId, length, &written, &format, &data[0]);
+    data.resize(written);
+
+    Tools::checkGLErr("Shader", "get program binary");
+
+    return written > 0;
+#else
+    return false;
+#endif
+}
+
+bool Shader::getSupportsBinary() {
+#ifdef OGLES_GPGPU_PROGRAM_BINARY
+    if (!ogGetProgramBinary() || !ogProgramBinary()) {
+        return false;
+    }
+
+    GLint numFormats = 0;
+    glGetIntegerv(OG_GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+
+    return numFormats > 0;
+#else
+    return false;
+#endif
+}
+
 void Shader::use() {
     glUseProgram(programId);
 }
 
 GLint Shader::getParam(ShaderParamType type, const char* name) const {
     // get position according to type and name
-    GLint id = (type == ATTR) ? glGetAttribLocation(programId, name) : glGetUniformLocation(programId, name);
+    GLint id;
+    if (type == ATTR) {
+        id = glGetAttribLocation(programId, name);
+    } else if (uniformSuffix.empty()) {
+        id = glGetUniformLocation(programId, name);
+    } else {
+        id = glGetUniformLocation(programId, (string(name) + uniformSuffix).c_str());
+    }
 
     if (id < 0) {
         OG_LOGERR("Shader", "could not get parameter id for param %s", name);
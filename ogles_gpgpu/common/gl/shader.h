@@ -25,6 +25,16 @@
 #define OGLES_GPGPU_HIGHP
 #endif
 
+// program binaries can be saved and loaded (glGetProgramBinary() / glProgramBinary())?
+#if defined(OGLES_GPGPU_ANDROID) && defined(GL_OES_get_program_binary)
+#define OGLES_GPGPU_PROGRAM_BINARY 1
+#elif defined(OGLES_GPGPU_OPENGL) && !defined(__APPLE__) && defined(GL_PROGRAM_BINARY_LENGTH)
+#define OGLES_GPGPU_PROGRAM_BINARY 1
+#endif
+
+#include <string>
+#include <vector>
+
 namespace ogles_gpgpu {
 
 typedef enum {
@@ -56,6 +66,25 @@ public:
      */
     bool buildFromSrc(const char* vshSrc, const char* fshSrc, const std::vector<Attribute>& attributes = {});
 
+    /**
+     * Build an OpenGL shader object from a program binary <data> of <length> bytes in
+     * the driver specific binary format <format> (see getBinary()). Fails if the driver
+     * does not accept the binary anymore (i.e. after a driver update).
+     */
+    bool buildFromBinary(GLenum format, const void* data, GLsizei length);
+
+    /**
+     * Get the binary of the linked shader program in the driver specific format <format>
+     * as <data>. Returns false if program binaries are not supported.
+     */
+    bool getBinary(GLenum& format, std::vector<unsigned char>& data) const;
+
+    /**
+     * Returns true if the driver of the current OpenGL context can save and load
+     * program binaries.
+     */
+    static bool getSupportsBinary();
+
     /**
      * Use the shader program.
      */
@@ -67,6 +96,15 @@ public:
      */
     GLint getParam(ShaderParamType type, const char* name) const;
 
+    /**
+     * Set a <suffix> that is appended to all uniform names in getParam().
+     * This is used for fused shader programs in which the uniforms of
+     * each stage are renamed to avoid name clashes.
+     */
+    void setUniformSuffix(const std::string& suffix) {
+        uniformSuffix = suffix;
+    }
+
     /**
      * Get a shader parameter position for a parameter of type <type> and with
      * <name>.
@@ -90,6 +128,8 @@ private:
     GLuint programId; // full shader program id
     GLuint vshId; // vertex shader id
     GLuint fshId; // fragment shader id
+
+    std::string uniformSuffix; // suffix for uniform names in getParam()
 };
 }
 
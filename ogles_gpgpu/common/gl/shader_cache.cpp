@@ -0,0 +1,213 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "shader_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#pragma mark helper functions
+
+// identifies a program binary file of this version
+static const char binaryMagic[] = { 'O', 'G', 'P', 'B', 0, 0, 0, 1 };
+
+// 64 bit FNV-1a hash, stable across platforms and runs
+static uint64_t hashString(const string& str) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (auto c : str) {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static void writeString(ostream& os, const string& str) {
+    uint32_t len = (uint32_t)str.size();
+    os.write((const char*)&len, sizeof(len));
+    os.write(str.data(), len);
+}
+
+static bool readString(istream& is, string& str) {
+    uint32_t len = 0;
+    if (!is.read((char*)&len, sizeof(len)) || len > (1 << 20)) {
+        return false;
+    }
+    str.resize(len);
+    return len == 0 || is.read(&str[0], len);
+}
+
+#pragma mark program cache
+
+shared_ptr<Shader> ShaderCache::acquire(const char* vshSrc, const char* fshSrc, GLenum target, const Shader::Attributes& attributes) {
+    assert(vshSrc && fshSrc);
+
+    const string key = makeKey(vshSrc, fshSrc, target, attributes);
+
+    // reuse a program that is still in use
+    auto it = programs.find(key);
+    if (it != programs.end()) {
+        if (auto shader = it->second.lock()) {
+            numHits++;
+            return shader;
+        }
+    }
+
+    auto shader = make_shared<Shader>();
+
+    // try the program binary of a previous run before compiling the sources
+    const bool useBinary = !binaryDir.empty() && Shader::getSupportsBinary();
+    const string binaryPath = useBinary ? getBinaryPath(key) : string();
+
+    if (useBinary && loadBinary(binaryPath, key, *shader)) {
+        numBinaryLoaded++;
+    } else if (!shader->buildFromSrc(vshSrc, fshSrc, attributes)) {
+        return shader;
+    } else {
+        numCompiled++;
+
+        if (useBinary && storeBinary(binaryPath, key, *shader)) {
+            numBinaryStored++;
+        }
+    }
+
+    // drop programs that are not used anymore
+    for (auto it = programs.begin(); it != programs.end();) {
+        if (it->second.expired()) {
+            it = programs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    programs[key] = shader;
+
+    OG_LOGINF("ShaderCache", "created shader program %d (%d compiled, %d loaded, %d hits)", shader->getProgramId(), numCompiled, numBinaryLoaded, numHits);
+
+    return shader;
+}
+
+void ShaderCache::clear() {
+    programs.clear();
+}
+
+int ShaderCache::getNumPrograms() const {
+    int num = 0;
+    for (auto& it : programs) {
+        if (!it.second.expired()) {
+            num++;
+        }
+    }
+    return num;
+}
+
+string ShaderCache::makeKey(const char* vshSrc, const char* fshSrc, GLenum target, const Shader::Attributes& attributes) {
+    stringstream ss;
+    ss << target << '\0';
+    for (auto& it : attributes) {
+        ss << it.first << ' ' << it.second << '\0';
+    }
+    ss << vshSrc << '\0' << fshSrc;
+    return ss.str();
+}
+
+#pragma mark program binaries
+
+string ShaderCache::getBinaryPath(const string& key) {
+    if (driver.empty()) {
+        // identify the driver of the current context
+        stringstream ss;
+        ss << glGetString(GL_VENDOR) << '|' << glGetString(GL_RENDERER) << '|' << glGetString(GL_VERSION);
+        driver = ss.str();
+    }
+
+    stringstream ss;
+    ss << binaryDir;
+    if (binaryDir.back() != '/' && binaryDir.back() != '\\') {
+        ss << '/';
+    }
+    ss << "ogles_gpgpu_" << hex << setw(16) << setfill('0') << hashString(driver + '\0' + key) << ".bin";
+
+    return ss.str();
+}
+
+bool ShaderCache::loadBinary(const string& path, const string& key, Shader& shader) {
+    ifstream is(path.c_str(), ios::binary);
+    if (!is) {
+        return false; // not saved yet
+    }
+
+    char magic[sizeof(binaryMagic)];
+    string fileDriver;
+    uint64_t keyHash = 0;
+    uint32_t format = 0;
+    uint32_t length = 0;
+
+    if (!is.read(magic, sizeof(magic)) || !equal(magic, magic + sizeof(magic), binaryMagic)
+        || !readString(is, fileDriver) || fileDriver != driver
+        || !is.read((char*)&keyHash, sizeof(keyHash)) || keyHash != hashString(key)
+        || !is.read((char*)&format, sizeof(format))
+        || !is.read((char*)&length, sizeof(length)) || length == 0) {
+        OG_LOGINF("ShaderCache", "program binary %s does not match", path.c_str());
+        return false;
+    }
+
+    vector<unsigned char> data(length);
+    if (!is.read((char*)&data[0], length)) {
+        OG_LOGERR("ShaderCache", "program binary %s is truncated", path.c_str());
+        return false;
+    }
+
+    return shader.buildFromBinary((GLenum)format, &data[0], (GLsizei)length);
+}
+
+bool ShaderCache::storeBinary(const string& path, const string& key, const Shader& shader) {
+    GLenum format = 0;
+    vector<unsigned char> data;
+    if (!shader.getBinary(format, data)) {
+        return false;
+    }
+
+    // write to a temporary file first, so that concurrent readers never see partial binaries
+    const string tmpPath = path + ".tmp";
+    {
+        ofstream os(tmpPath.c_str(), ios::binary | ios::trunc);
+        if (!os) {
+            OG_LOGERR("ShaderCache", "could not write program binary %s", tmpPath.c_str());
+            return false;
+        }
+
+        const uint64_t keyHash = hashString(key);
+        const uint32_t fileFormat = format;
+        const uint32_t length = (uint32_t)data.size();
+
+        os.write(binaryMagic, sizeof(binaryMagic));
+        writeString(os, driver);
+        os.write((const char*)&keyHash, sizeof(keyHash));
+        os.write((const char*)&fileFormat, sizeof(fileFormat));
+        os.write((const char*)&length, sizeof(length));
+        os.write((const char*)&data[0], length);
+
+        if (!os) {
+            OG_LOGERR("ShaderCache", "could not write program binary %s", tmpPath.c_str());
+            return false;
+        }
+    }
+
+    remove(path.c_str());
+    if (rename(tmpPath.c_str(), path.c_str()) != 0) {
+        remove(tmpPath.c_str());
+        return false;
+    }
+
+    return true;
+}
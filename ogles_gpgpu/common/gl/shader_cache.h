@@ -0,0 +1,144 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Cache of compiled shader programs.
+ */
+#ifndef OGLES_GPGPU_COMMON_GL_SHADER_CACHE
+#define OGLES_GPGPU_COMMON_GL_SHADER_CACHE
+
+#include "../common_includes.h"
+
+#include "shader.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace ogles_gpgpu {
+
+/**
+ * ShaderCache shares compiled shader programs between procs of one context.
+ * Programs are looked up by their vertex and fragment shader sources, texture
+ * target and attribute locations, so identical programs (i.e. the passes of
+ * a FifoProc or GaussOptProcs with the same radius) are only compiled once.
+ *
+ * The programs are reference counted: a program is deleted when the last proc
+ * that uses it releases its shader. The cache itself only holds weak refs.
+ *
+ * Optionally, the program binaries are saved in a directory (see setBinaryDirectory())
+ * and loaded instead of compiling the sources on the next start. The binaries are
+ * looked up by a hash of the sources and the driver (vendor, renderer and version).
+ * If a binary does not match or is rejected by the driver, the program is compiled
+ * from source and the binary is replaced.
+ */
+class ShaderCache {
+public:
+    /**
+     * Constructor.
+     */
+    ShaderCache() {}
+
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    /**
+     * Get a shader program for vertex and fragment shader sources <vshSrc> and <fshSrc>,
+     * texture target <target> and attribute locations <attributes>. The program is
+     * compiled if it is not in the cache. If compilation fails, the returned shader
+     * has program id 0 and is not cached.
+     */
+    std::shared_ptr<Shader> acquire(const char* vshSrc, const char* fshSrc, GLenum target = GL_TEXTURE_2D, const Shader::Attributes& attributes = {});
+
+    /**
+     * Save and load program binaries in the existing directory <dir>. An empty string
+     * disables the binary cache (default). Has no effect if the driver does not
+     * support program binaries.
+     */
+    void setBinaryDirectory(const std::string& dir) {
+        binaryDir = dir;
+    }
+
+    /**
+     * Get the program binary directory.
+     */
+    const std::string& getBinaryDirectory() const {
+        return binaryDir;
+    }
+
+    /**
+     * Forget all cached programs. Programs that are still in use stay valid.
+     */
+    void clear();
+
+    /**
+     * Return the number of programs in the cache that are still in use.
+     */
+    int getNumPrograms() const;
+
+    /**
+     * Return the number of programs that were compiled from source by this cache.
+     */
+    int getNumCompiled() const {
+        return numCompiled;
+    }
+
+    /**
+     * Return the number of acquire() calls that were served from the cache.
+     */
+    int getNumHits() const {
+        return numHits;
+    }
+
+    /**
+     * Return the number of programs that were loaded from a program binary.
+     */
+    int getNumBinaryLoaded() const {
+        return numBinaryLoaded;
+    }
+
+    /**
+     * Return the number of program binaries that were saved.
+     */
+    int getNumBinaryStored() const {
+        return numBinaryStored;
+    }
+
+private:
+    /**
+     * Create the lookup key for a program.
+     */
+    static std::string makeKey(const char* vshSrc, const char* fshSrc, GLenum target, const Shader::Attributes& attributes);
+
+    /**
+     * Get the program binary file name for the program with lookup key <key>.
+     */
+    std::string getBinaryPath(const std::string& key);
+
+    /**
+     * Load the program binary <path> into <shader>. Returns false if the file does not exist,
+     * does not belong to <key> or the current driver, or was rejected by the driver.
+     */
+    bool loadBinary(const std::string& path, const std::string& key, Shader& shader);
+
+    /**
+     * Save the binary of <shader> with lookup key <key> as <path>.
+     */
+    bool storeBinary(const std::string& path, const std::string& key, const Shader& shader);
+
+    std::unordered_map<std::string, std::weak_ptr<Shader>> programs; // cached programs, weak refs.
+
+    int numCompiled = 0; // number of compiled programs
+    int numHits = 0; // number of cache hits
+
+    std::string binaryDir; // directory for program binaries. empty if disabled
+    std::string driver; // vendor, renderer and version of the OpenGL driver
+    int numBinaryLoaded = 0; // number of programs loaded from a binary
+    int numBinaryStored = 0; // number of saved program binaries
+};
+}
+
+#endif
@@ -0,0 +1,183 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "state_cache.h"
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+GLStateCache::GLStateCache(bool enabled)
+    : enabled(enabled)
+    , numIssued(0)
+    , numSkipped(0) {
+    invalidate();
+}
+
+void GLStateCache::setEnabled(bool e) {
+    if (enabled && !e) {
+        endFrame();
+    }
+
+    enabled = e;
+    invalidate();
+}
+
+void GLStateCache::invalidate() {
+    programValid = false;
+    fboValid = false;
+    viewportValid = false;
+    activeUnitValid = false;
+    arrayBufferValid = false;
+
+    for (auto& it : textures) {
+        it.valid = false;
+    }
+
+    for (auto& it : attribs) {
+        it.valid = false;
+    }
+}
+
+void GLStateCache::beginFrame() {
+    invalidate();
+
+    numIssued = numSkipped = 0;
+}
+
+void GLStateCache::endFrame() {
+    // disable the vertex attribute arrays that are not needed anymore
+    for (int i = 0; i < MAX_ATTRIBS; i++) {
+        Attrib& attrib = attribs[i];
+        if (attrib.valid && attrib.enabled && !attrib.used) {
+            glDisableVertexAttribArray(i);
+            attrib.enabled = false;
+            count(true);
+        }
+    }
+}
+
+void GLStateCache::useProgram(GLuint p) {
+    if (count(!enabled || !programValid || program != p)) {
+        glUseProgram(p);
+        program = p;
+        programValid = enabled;
+    }
+}
+
+void GLStateCache::bindFramebuffer(GLuint f) {
+    if (count(!enabled || !fboValid || fbo != f)) {
+        glBindFramebuffer(GL_FRAMEBUFFER, f);
+        fbo = f;
+        fboValid = enabled;
+    }
+}
+
+void GLStateCache::viewport(GLint x, GLint y, GLsizei w, GLsizei h) {
+    if (count(!enabled || !viewportValid
+            || viewportRect[0] != x || viewportRect[1] != y || viewportRect[2] != w || viewportRect[3] != h)) {
+        glViewport(x, y, w, h);
+        viewportRect[0] = x;
+        viewportRect[1] = y;
+        viewportRect[2] = w;
+        viewportRect[3] = h;
+        viewportValid = enabled;
+    }
+}
+
+void GLStateCache::bindTexture(GLuint unit, GLenum target, GLuint tex) {
+    if (unit >= MAX_TEX_UNITS) { // not tracked
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(target, tex);
+        activeUnitValid = false;
+        count(true);
+        count(true);
+        return;
+    }
+
+    Texture& binding = textures[unit];
+    if (enabled && binding.valid && binding.target == target && binding.id == tex) {
+        count(false);
+        return;
+    }
+
+    if (count(!enabled || !activeUnitValid || activeUnit != unit)) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        activeUnit = unit;
+        activeUnitValid = enabled;
+    }
+
+    glBindTexture(target, tex);
+    count(true);
+
+    binding.target = target;
+    binding.id = tex;
+    binding.valid = enabled;
+}
+
+void GLStateCache::bindArrayBuffer(GLuint buffer) {
+    if (count(!enabled || !arrayBufferValid || arrayBuffer != buffer)) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        arrayBuffer = buffer;
+        arrayBufferValid = enabled;
+    }
+}
+
+void GLStateCache::vertexAttribArray(GLint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer) {
+    if (index < 0) {
+        return; // attribute not used by the shader
+    }
+
+    if (index >= MAX_ATTRIBS) { // not tracked
+        glEnableVertexAttribArray(index);
+        glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+        count(true);
+        count(true);
+        return;
+    }
+
+    Attrib& attrib = attribs[index];
+    const bool known = enabled && attrib.valid && arrayBufferValid;
+
+    if (count(!known || !attrib.enabled)) {
+        glEnableVertexAttribArray(index);
+    }
+
+    // the pointer refers to the bound array buffer (if any)
+    if (count(!known || attrib.size != size || attrib.type != type || attrib.normalized != normalized
+            || attrib.stride != stride || attrib.pointer != pointer || attrib.buffer != arrayBuffer)) {
+        glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+    }
+
+    attrib.valid = enabled && arrayBufferValid;
+    attrib.enabled = true;
+    attrib.used = true;
+    attrib.size = size;
+    attrib.type = type;
+    attrib.normalized = normalized;
+    attrib.stride = stride;
+    attrib.pointer = pointer;
+    attrib.buffer = arrayBuffer;
+}
+
+void GLStateCache::disableVertexAttribArray(GLint index) {
+    if (index < 0) {
+        return;
+    }
+
+    if (!enabled || index >= MAX_ATTRIBS || !attribs[index].valid) {
+        glDisableVertexAttribArray(index);
+        count(true);
+
+        if (index < MAX_ATTRIBS) {
+            attribs[index].valid = false;
+        }
+        return;
+    }
+
+    // keep the array enabled for the next render pass
+    attribs[index].used = false;
+    count(false);
+}
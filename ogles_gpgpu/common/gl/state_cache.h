@@ -0,0 +1,168 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * OpenGL state cache.
+ */
+#ifndef OGLES_GPGPU_COMMON_GL_STATE_CACHE
+#define OGLES_GPGPU_COMMON_GL_STATE_CACHE
+
+#include "../common_includes.h"
+
+namespace ogles_gpgpu {
+
+/**
+ * GLStateCache shadows the OpenGL state that is set for each render pass (shader
+ * program, framebuffer, viewport, texture bindings per unit, array buffer and vertex
+ * attribute arrays) and skips calls that would not change it. Disabling vertex
+ * attribute arrays is deferred until they are enabled with different parameters
+ * or the frame ends (see endFrame()).
+ *
+ * The cache only knows about calls that are made through it. State that is changed
+ * directly (e.g. texture uploads by MemTransfer or rendering by the application)
+ * is picked up by invalidate(), which is done in beginFrame().
+ */
+class GLStateCache {
+public:
+    /**
+     * Constructor. If <enabled> is false, all calls are passed to OpenGL.
+     */
+    GLStateCache(bool enabled = true);
+
+    /**
+     * Enable or disable the cache with <enabled>.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Returns true if redundant calls are skipped.
+     */
+    bool getEnabled() const {
+        return enabled;
+    }
+
+    /**
+     * Forget all state, so that the next calls are passed to OpenGL.
+     */
+    void invalidate();
+
+    /**
+     * Start a new frame: invalidate the state and reset the call counters.
+     */
+    void beginFrame();
+
+    /**
+     * End a frame: apply deferred changes so that the OpenGL state is as
+     * requested by the last calls.
+     */
+    void endFrame();
+
+    /**
+     * glUseProgram(<program>).
+     */
+    void useProgram(GLuint program);
+
+    /**
+     * glBindFramebuffer(GL_FRAMEBUFFER, <fbo>).
+     */
+    void bindFramebuffer(GLuint fbo);
+
+    /**
+     * glViewport(<x>, <y>, <w>, <h>).
+     */
+    void viewport(GLint x, GLint y, GLsizei w, GLsizei h);
+
+    /**
+     * glActiveTexture(GL_TEXTURE0 + <unit>) and glBindTexture(<target>, <tex>).
+     */
+    void bindTexture(GLuint unit, GLenum target, GLuint tex);
+
+    /**
+     * glBindBuffer(GL_ARRAY_BUFFER, <buffer>).
+     */
+    void bindArrayBuffer(GLuint buffer);
+
+    /**
+     * glEnableVertexAttribArray(<index>) and glVertexAttribPointer(<index>, ...).
+     */
+    void vertexAttribArray(GLint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+
+    /**
+     * glDisableVertexAttribArray(<index>). Deferred until endFrame().
+     */
+    void disableVertexAttribArray(GLint index);
+
+    /**
+     * Return the number of OpenGL calls that were issued since beginFrame().
+     */
+    int getNumIssued() const {
+        return numIssued;
+    }
+
+    /**
+     * Return the number of OpenGL calls that were skipped since beginFrame().
+     */
+    int getNumSkipped() const {
+        return numSkipped;
+    }
+
+private:
+    enum {
+        MAX_TEX_UNITS = 32, // tracked texture units
+        MAX_ATTRIBS = 16 // tracked vertex attributes
+    };
+
+    struct Texture {
+        bool valid; // state known?
+        GLenum target;
+        GLuint id;
+    };
+
+    struct Attrib {
+        bool valid; // state known?
+        bool enabled; // array is enabled
+        bool used; // array is needed by the current render pass
+        GLint size;
+        GLenum type;
+        GLboolean normalized;
+        GLsizei stride;
+        const void* pointer;
+        GLuint buffer; // array buffer at glVertexAttribPointer()
+    };
+
+    /**
+     * Count a call as issued (<issue> is true) or skipped. Returns <issue>.
+     */
+    bool count(bool issue) {
+        (issue ? numIssued : numSkipped)++;
+        return issue;
+    }
+
+    bool enabled; // skip redundant calls?
+
+    bool programValid;
+    GLuint program;
+
+    bool fboValid;
+    GLuint fbo;
+
+    bool viewportValid;
+    GLint viewportRect[4];
+
+    bool activeUnitValid;
+    GLuint activeUnit;
+    Texture textures[MAX_TEX_UNITS];
+
+    bool arrayBufferValid;
+    GLuint arrayBuffer;
+    Attrib attribs[MAX_ATTRIBS];
+
+    int numIssued; // issued calls since beginFrame()
+    int numSkipped; // skipped calls since beginFrame()
+};
+}
+
+#endif
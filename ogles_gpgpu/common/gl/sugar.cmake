@@ -23,6 +23,14 @@ sugar_files(
     memtransfer_factory.cpp
     memtransfer_factory.h
     memtransfer_optimized.h
+    quad_buffer.cpp
+    quad_buffer.h
     shader.cpp
     shader.h
+    shader_cache.cpp
+    shader_cache.h
+    state_cache.cpp
+    state_cache.h
+    texture_pool.cpp
+    texture_pool.h
 )
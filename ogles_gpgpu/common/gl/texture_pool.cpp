@@ -0,0 +1,105 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "texture_pool.h"
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+TexturePool::~TexturePool() {
+    clear();
+}
+
+GLuint TexturePool::acquire(int w, int h) {
+    assert(w > 0 && h > 0);
+
+    // recycle a free texture of the same size
+    for (auto& it : textures) {
+        if (!it.inUse && it.width == w && it.height == h) {
+            it.inUse = it.acquired = true;
+            return it.id;
+        }
+    }
+
+    GLuint texId = 0;
+    glGenTextures(1, &texId);
+
+    if (texId == 0) {
+        OG_LOGERR("TexturePool", "no valid texture generated");
+        return 0;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, texId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    Tools::checkGLErr("TexturePool", "texture creation");
+
+    OG_LOGINF("TexturePool", "created texture %d of size %dx%d", texId, w, h);
+
+    Texture tex = { texId, w, h, true, true };
+    textures.push_back(tex);
+
+    return texId;
+}
+
+void TexturePool::release(GLuint texId) {
+    for (auto& it : textures) {
+        if (it.id == texId) {
+            it.inUse = false;
+            return;
+        }
+    }
+
+    OG_LOGERR("TexturePool", "texture %d does not belong to this pool", texId);
+}
+
+void TexturePool::releaseAll() {
+    for (auto& it : textures) {
+        it.inUse = it.acquired = false;
+    }
+}
+
+void TexturePool::purge() {
+    for (auto it = textures.begin(); it != textures.end();) {
+        if (!it->acquired) {
+            glDeleteTextures(1, &it->id);
+            it = textures.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void TexturePool::clear() {
+    for (auto& it : textures) {
+        glDeleteTextures(1, &it.id);
+    }
+
+    textures.clear();
+}
+
+bool TexturePool::owns(GLuint texId) const {
+    for (auto& it : textures) {
+        if (it.id == texId) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t TexturePool::getAllocatedBytes() const {
+    size_t bytes = 0;
+    for (auto& it : textures) {
+        bytes += size_t(it.width) * size_t(it.height) * 4;
+    }
+    return bytes;
+}
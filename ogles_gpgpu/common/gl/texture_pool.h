@@ -0,0 +1,95 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Pool of render target textures.
+ */
+#ifndef OGLES_GPGPU_COMMON_GL_TEXTURE_POOL
+#define OGLES_GPGPU_COMMON_GL_TEXTURE_POOL
+
+#include "../common_includes.h"
+
+#include <vector>
+
+namespace ogles_gpgpu {
+
+/**
+ * TexturePool hands out RGBA render target textures by size and recycles
+ * released textures for later requests of the same size. All textures are
+ * owned by the pool.
+ */
+class TexturePool {
+public:
+    /**
+     * Constructor.
+     */
+    TexturePool() {}
+
+    /**
+     * Deconstructor. Deletes all textures.
+     */
+    ~TexturePool();
+
+    TexturePool(const TexturePool&) = delete;
+    TexturePool& operator=(const TexturePool&) = delete;
+
+    /**
+     * Get a texture of size <w>x<h>. A released texture of the same size is
+     * reused, otherwise a new texture is created.
+     */
+    GLuint acquire(int w, int h);
+
+    /**
+     * Give the texture <texId> back to the pool so that it can be reused.
+     */
+    void release(GLuint texId);
+
+    /**
+     * Give all textures back to the pool so that they can be reused.
+     */
+    void releaseAll();
+
+    /**
+     * Delete the textures that were not acquired since the last releaseAll() call.
+     */
+    void purge();
+
+    /**
+     * Delete all textures.
+     */
+    void clear();
+
+    /**
+     * Returns true if the texture <texId> belongs to this pool.
+     */
+    bool owns(GLuint texId) const;
+
+    /**
+     * Return the number of textures owned by the pool.
+     */
+    int getNumTextures() const {
+        return (int)textures.size();
+    }
+
+    /**
+     * Return the number of bytes allocated for all textures of the pool.
+     */
+    size_t getAllocatedBytes() const;
+
+private:
+    struct Texture {
+        GLuint id; // texture id
+        int width; // texture width
+        int height; // texture height
+        bool inUse; // handed out?
+        bool acquired; // handed out since releaseAll()?
+    };
+
+    std::vector<Texture> textures; // all textures of the pool
+};
+}
+
+#endif
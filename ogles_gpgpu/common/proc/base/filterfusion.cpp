@@ -0,0 +1,344 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "filterfusion.h"
+#include "filterprocbase.h"
+
+#include "../../core.h"
+#include "../../gl/fbo.h"
+#include "../../gl/shader.h"
+
+#include <algorithm>
+#include <regex>
+#include <set>
+#include <sstream>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#pragma mark helper functions
+
+// suffix that is appended to the global identifiers of stage <index>
+static string getStageSuffix(int index) {
+    stringstream ss;
+    ss << "_og" << index;
+    return ss.str();
+}
+
+// replace everything enclosed in curly braces by spaces (keeps positions)
+static string getOuterScope(const string& src) {
+    string outer = src;
+    int depth = 0;
+    for (auto& c : outer) {
+        if (c == '{') {
+            depth++;
+        } else if (c == '}') {
+            depth--;
+            c = ' ';
+            continue;
+        }
+
+        if (depth > 0) {
+            c = ' ';
+        }
+    }
+    return outer;
+}
+
+static void collectNames(const string& src, const regex& re, set<string>& names) {
+    for (sregex_iterator it(src.begin(), src.end(), re), end; it != end; ++it) {
+        names.insert((*it)[1].str());
+    }
+}
+
+#pragma mark shader conversion
+
+bool FilterFusion::convertFragmentShader(const char* src, int index, string& decl, string& func) {
+    static const regex precisionRe("precision\\s+\\w+\\s+float\\s*;");
+    static const regex varyingRe("varying\\s+vec2\\s+vTexCoord\\s*;");
+    static const regex samplerRe("uniform\\s+sampler2D\\s+uInputTex\\s*;");
+    static const regex mainRe("void\\s+main\\s*\\(\\s*(void)?\\s*\\)\\s*\\{");
+    static const regex uniformRe("\\buniform\\s+(?:(?:lowp|mediump|highp)\\s+)?\\w+\\s+(\\w+)");
+    static const regex constRe("\\bconst\\s+(?:(?:lowp|mediump|highp)\\s+)?\\w+\\s+(\\w+)");
+    static const regex functionRe("\\b\\w+\\s+(\\w+)\\s*\\(");
+    static const regex inputTexRe("\\buInputTex\\b");
+    static const regex sampleRe("texture2D\\s*\\(\\s*uInputTex\\s*,\\s*vTexCoord\\s*\\)");
+    static const regex fragColorRe("\\bgl_FragColor\\b");
+    static const regex returnRe("\\breturn\\s*;");
+
+    if (!src) {
+        return false;
+    }
+
+    // remove declarations that are shared by all stages
+    string s = regex_replace(string(src), precisionRe, "");
+    s = regex_replace(s, varyingRe, "");
+    s = regex_replace(s, samplerRe, "");
+
+    // split into global declarations and main() body
+    smatch m;
+    if (!regex_search(s, m, mainRe)) {
+        return false;
+    }
+
+    size_t bodyBegin = m.position(0) + m.length(0);
+    size_t i = bodyBegin;
+    for (int depth = 1; i < s.size() && depth > 0; i++) {
+        if (s[i] == '{') {
+            depth++;
+        } else if (s[i] == '}') {
+            depth--;
+        }
+    }
+
+    if (i > s.size() || s[i - 1] != '}') {
+        return false;
+    }
+
+    string body = s.substr(bodyBegin, i - 1 - bodyBegin);
+    string globals = s.substr(0, m.position(0)) + s.substr(i);
+
+    // the input texture may only be sampled at the current fragment
+    if (regex_search(globals, inputTexRe)) {
+        return false;
+    }
+
+    body = regex_replace(body, sampleRe, "og_in");
+    if (regex_search(body, inputTexRe)) {
+        return false;
+    }
+
+    // rename global identifiers (uniforms, constants, helper functions)
+    const string outer = getOuterScope(globals);
+    set<string> names;
+    collectNames(outer, uniformRe, names);
+    collectNames(outer, constRe, names);
+    collectNames(outer, functionRe, names);
+
+    const string suffix = getStageSuffix(index);
+    for (auto& name : names) {
+        const regex nameRe("\\b" + name + "\\b");
+        globals = regex_replace(globals, nameRe, name + suffix);
+        body = regex_replace(body, nameRe, name + suffix);
+    }
+
+    // main() becomes a vec4 -> vec4 stage function
+    body = regex_replace(body, fragColorRe, "og_out");
+    body = regex_replace(body, returnRe, "return og_out;");
+
+    stringstream ss;
+    ss << "vec4 og_stage" << index << "(vec4 og_in) { vec4 og_out = og_in; " << body << " return og_out; }\n";
+
+    decl = globals + "\n";
+    func = ss.str();
+
+    return true;
+}
+
+#pragma mark constructor/deconstructor
+
+FilterFusion* FilterFusion::create(FilterProcBase* head) {
+    assert(head);
+
+    // check if <proc> can be a stage of a fused chain
+    auto canFuse = [&](FilterProcBase* proc) {
+        return proc->getIsPointwise()
+            && proc->active
+            && !proc->getFeedback() // the output of the previous frame must be kept
+            && proc->fusion == NULL
+            && proc->fusionHead == NULL
+            && (proc->core == NULL || proc->core == head->core) // subscribers get the context in prepare()
+            && proc->getVertexShaderSource() == FilterProcBase::vshaderDefault;
+    };
+
+    if (!canFuse(head)) {
+        return NULL;
+    }
+
+    vector<FilterProcBase*> stages;
+    string decl, func, decls, funcs;
+
+    if (!convertFragmentShader(head->getFragmentShaderSource(), 0, decl, func)) {
+        return NULL;
+    }
+
+    stages.push_back(head);
+    decls += decl;
+    funcs += func;
+
+    // follow the subscriber graph as long as there is exactly one point-wise subscriber
+    // that does not change the frame size or orientation
+    for (FilterProcBase* cur = head; cur->subscribers.size() == 1 && cur->subscribers[0].second == 0;) {
+        auto* next = dynamic_cast<FilterProcBase*>(cur->subscribers[0].first);
+
+        if (!next || !canFuse(next)
+            || next->procParamOutW != 0 || next->procParamOutH != 0 || next->procParamOutScale != 1.0f
+            || next->renderOrientation != RenderOrientationStd) {
+            break;
+        }
+
+        if (!convertFragmentShader(next->getFragmentShaderSource(), (int)stages.size(), decl, func)) {
+            break;
+        }
+
+        stages.push_back(next);
+        decls += decl;
+        funcs += func;
+
+        cur = next;
+    }
+
+    if (stages.size() < 2) {
+        return NULL;
+    }
+
+    // create the combined fragment shader
+    stringstream ss;
+#if defined(OGLES_GPGPU_OPENGLES)
+    ss << "precision mediump float;\n";
+#endif
+    ss << "varying vec2 vTexCoord;\n";
+    ss << "uniform sampler2D uInputTex;\n";
+    ss << decls;
+    ss << funcs;
+    ss << "vec4 og_quantize(vec4 v) { v = clamp(v, 0.0, 1.0) * 255.0; vec4 r = floor(v + 0.5); "
+          "return (r - vec4(equal(r - v, vec4(0.5))) * mod(r, 2.0)) / 255.0; }\n"; // ties to even
+    ss << "void main() { vec4 og_val = texture2D(uInputTex, vTexCoord); ";
+    for (int i = 0; i < (int)stages.size(); i++) {
+        ss << "og_val = og_stage" << i << "(og_val); ";
+
+        // clamp and round as the RGBA8 output texture of an unfused stage does
+        if (i + 1 < (int)stages.size()) {
+            ss << "og_val = og_quantize(og_val); ";
+        }
+    }
+    ss << "gl_FragColor = og_val; }\n";
+
+    OG_LOGINF("FilterFusion", "fusing %d stages starting at %s", (int)stages.size(), head->getProcName());
+
+    return new FilterFusion(stages, ss.str());
+}
+
+FilterFusion::FilterFusion(const vector<FilterProcBase*>& stages, const string& fragShaderSrc)
+    : stages(stages)
+    , fragShaderSrc(fragShaderSrc)
+    , shParamAPos(-1)
+    , shParamATexCoord(-1)
+    , shParamUInputTex(-1)
+    , dirty(true) {
+    for (auto& it : stages) {
+        if (it != getHead()) {
+            it->fusionHead = getHead();
+        }
+    }
+}
+
+FilterFusion::~FilterFusion() {
+    release();
+}
+
+void FilterFusion::release(FilterProcBase* except) {
+    for (auto& it : stages) {
+        it->fusionHead = NULL;
+
+        // restore the uniform ids of the stage's own shader
+        if (it != except && it->shader) {
+            it->getUniforms();
+        }
+    }
+
+    stages.clear();
+}
+
+#pragma mark setup and rendering
+
+bool FilterFusion::setup() {
+    if (!shader) {
+        Core* core = getHead()->core;
+        if (core) {
+            shader = core->getShaderCache().acquire(FilterProcBase::vshaderDefault, fragShaderSrc.c_str());
+        } else {
+            shader = make_shared<Shader>();
+            shader->buildFromSrc(FilterProcBase::vshaderDefault, fragShaderSrc.c_str());
+        }
+
+        if (shader->getProgramId() == 0) {
+            OG_LOGERR("FilterFusion", "could not compile fused shader:\n%s", fragShaderSrc.c_str());
+            shader.reset();
+            return false;
+        }
+
+        shParamAPos = shader->getParam(ATTR, "aPos");
+        shParamATexCoord = shader->getParam(ATTR, "aTexCoord");
+        shParamUInputTex = shader->getParam(UNIF, "uInputTex");
+    }
+
+    // let each stage fetch its (renamed) uniforms from the fused shader
+    for (int i = 0; i < (int)stages.size(); i++) {
+        shared_ptr<Shader> stageShader = stages[i]->shader;
+        stages[i]->shader = shader;
+        shader->setUniformSuffix(getStageSuffix(i));
+        stages[i]->getUniforms();
+        stages[i]->shader = stageShader;
+    }
+    shader->setUniformSuffix("");
+
+    dirty = false;
+
+    return true;
+}
+
+int FilterFusion::render() {
+    if (dirty && !setup()) {
+        return 1;
+    }
+
+    FilterProcBase* head = getHead();
+    FilterProcBase* tail = getTail();
+
+    OG_LOGINF("FilterFusion", "%d stages, input tex %d, framebuffer of size %dx%d", (int)stages.size(), head->texId, tail->outFrameW, tail->outFrameH);
+
+    GLStateCache& glState = head->getGLState();
+
+    glState.useProgram(shader->getProgramId());
+
+    // render to the FBO of the last stage
+    tail->useNextOutputTex();
+    tail->fbo->bind();
+
+    glState.viewport(0, 0, tail->outFrameW, tail->outFrameH);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // set input texture
+    glState.bindTexture(head->texUnit, GL_TEXTURE_2D, head->texId);
+    glUniform1i(shParamUInputTex, head->texUnit);
+
+    for (auto& it : stages) {
+        it->setUniforms();
+    }
+    Tools::checkGLErr("FilterFusion", "render prepare");
+
+    // set geometry
+    head->filterRenderSetQuad(shParamAPos, shParamATexCoord, head->texCoordOrientation);
+
+    // the stages are point-wise: the region of interest of the last stage is rendered
+    const bool scissor = tail->filterRenderSetScissor();
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, OGLES_GPGPU_QUAD_VERTICES);
+    Tools::checkGLErr("FilterFusion", "render draw");
+
+    if (scissor) {
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    // cleanup
+    glState.disableVertexAttribArray(shParamAPos);
+    glState.disableVertexAttribArray(shParamATexCoord);
+
+    tail->fbo->unbind();
+
+    return 0;
+}
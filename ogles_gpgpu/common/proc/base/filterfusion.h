@@ -0,0 +1,134 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Fusion of chained point-wise filters into a single shader pass.
+ */
+#ifndef OGLES_GPGPU_COMMON_PROC_FILTERFUSION
+#define OGLES_GPGPU_COMMON_PROC_FILTERFUSION
+
+#include "../../common_includes.h"
+
+#include "../../gl/shader.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ogles_gpgpu {
+
+class FilterProcBase;
+
+/**
+ * FilterFusion executes a chain of consecutive point-wise filters (see
+ * FilterProcBase::getIsPointwise()) as one draw call. The fragment shaders
+ * of all stages are combined into one shader program: the main() function of
+ * each stage becomes a function vec4 -> vec4, its uniforms and helper functions
+ * are renamed with a stage specific suffix. The result is rendered directly
+ * into the FBO of the last stage, so the intermediate render targets are not needed.
+ * Between the stages the values are clamped and rounded to 8 bit (ties to even) as
+ * by the RGBA8 render targets of the unfused chain, so both give the same result on
+ * drivers that round the same way.
+ *
+ * A FilterFusion object is owned by the first stage of the chain (the "head").
+ */
+class FilterFusion {
+public:
+    /**
+     * Detect a chain of point-wise filters in the subscriber graph that starts
+     * at <head>. Return a new FilterFusion object (strong ref.) if at least two
+     * stages can be fused, else NULL.
+     */
+    static FilterFusion* create(FilterProcBase* head);
+
+    /**
+     * Deconstructor. Releases all stages.
+     */
+    ~FilterFusion();
+
+    /**
+     * Render all stages as one shader pass into the FBO of the last stage.
+     * Return 0 on success.
+     */
+    int render();
+
+    /**
+     * Mark the shader uniforms as outdated. They will be fetched again before the
+     * next render() call. Must be called whenever a stage was (re)initialized.
+     */
+    void invalidate() {
+        dirty = true;
+    }
+
+    /**
+     * Release the stages of the fused chain. <except> will not be touched (it
+     * is in destruction).
+     */
+    void release(FilterProcBase* except = NULL);
+
+    /**
+     * Return the first stage.
+     */
+    FilterProcBase* getHead() const {
+        return stages.front();
+    }
+
+    /**
+     * Return the last stage. It holds the output texture of the fused chain.
+     */
+    FilterProcBase* getTail() const {
+        return stages.back();
+    }
+
+    /**
+     * Return all stages (weak refs).
+     */
+    const std::vector<FilterProcBase*>& getStages() const {
+        return stages;
+    }
+
+    /**
+     * Return the generated fragment shader source.
+     */
+    const std::string& getFragmentShaderSource() const {
+        return fragShaderSrc;
+    }
+
+    /**
+     * Convert the fragment shader source <src> of a point-wise filter into a
+     * stage function named "og_stage<index>". Global declarations are written to
+     * <decl>, the stage function to <func>. Return false if the shader does not
+     * follow the point-wise pattern (i.e. it samples the input texture anywhere
+     * else than at "vTexCoord").
+     */
+    static bool convertFragmentShader(const char* src, int index, std::string& decl, std::string& func);
+
+private:
+    /**
+     * Constructor for the fused chain <stages>.
+     */
+    FilterFusion(const std::vector<FilterProcBase*>& stages, const std::string& fragShaderSrc);
+
+    /**
+     * Compile the fused shader (only once) and fetch the uniforms of all stages.
+     */
+    bool setup();
+
+    std::vector<FilterProcBase*> stages; // fused stages, weak refs.
+
+    std::string fragShaderSrc; // combined fragment shader source
+
+    std::shared_ptr<Shader> shader; // combined shader program. strong ref.!
+
+    GLint shParamAPos; // shader attribute vertex positions
+    GLint shParamATexCoord; // shader attribute texture coordinates
+    GLint shParamUInputTex; // shader uniform input texture sampler
+
+    bool dirty; // uniforms need to be fetched?
+};
+}
+
+#endif
@@ -8,8 +8,7 @@
 //
 
 #include "filterprocbase.h"
-
-#include <memory.h> // for memcpy on linux
+#include "filterfusion.h"
 
 using namespace ogles_gpgpu;
 using namespace std;
@@ -83,6 +82,29 @@ void main()
 
 #pragma mark public methods
 
+FilterProcBase::~FilterProcBase() {
+    releaseFusion();
+}
+
+void FilterProcBase::cleanup() {
+    releaseFusion();
+
+    ProcBase::cleanup();
+}
+
+void FilterProcBase::createFBOTex(bool genMipmap) {
+    if (!fusionHead) {
+        updateFusion();
+    }
+
+    // the output of all but the last stage of a fused chain stays on-chip
+    if (fusion || (fusionHead && fusionHead->fusion->getTail() != this)) {
+        return;
+    }
+
+    ProcBase::createFBOTex(genMipmap);
+}
+
 void FilterProcBase::setOutputRenderOrientation(RenderOrientation o) {
     ProcBase::setOutputRenderOrientation(o);
 
@@ -108,8 +130,20 @@ void FilterProcBase::filterInit(const char* vShaderSrc, const char* fShaderSrc,
     // create shader object
     filterShaderSetup(vShaderSrc, fShaderSrc, texTarget);
 
-    // set geometry
-    memcpy(vertexBuf, ProcBase::quadVertices, OGLES_GPGPU_QUAD_VERTEX_BUFSIZE * sizeof(GLfloat));
+    // set geometry (shared by all procs of the context)
+    if (core && !core->getQuadBuffer().getIsInitialized()) {
+        const GLfloat* texCoords[] = {
+            ProcBase::quadTexCoordsStd,
+            ProcBase::quadTexCoordsStdMirrored,
+            ProcBase::quadTexCoordsFlipped,
+            ProcBase::quadTexCoordsFlippedMirrored,
+            ProcBase::quadTexCoordsDiagonal,
+            ProcBase::quadTexCoordsDiagonalFlipped,
+            ProcBase::quadTexCoordsDiagonalMirrored
+        };
+
+        core->getQuadBuffer().init(ProcBase::quadVertices, OGLES_GPGPU_QUAD_VERTEX_BUFSIZE, texCoords, OGLES_GPGPU_QUAD_TEX_BUFSIZE);
+    }
 
     // set texture coordinates
     initTexCoordBuf(o);
@@ -137,8 +171,22 @@ void FilterProcBase::getUniforms() {
  * Abstract method.
  */
 int FilterProcBase::render(int position) {
+    if (fusion) { // render the complete fused chain
+        return fusion->render();
+    }
+
+    if (fusionHead) { // already rendered by the head of the fused chain
+        return 0;
+    }
+
     OG_LOGINF(getProcName(), "input tex %d, target %d, framebuffer of size %dx%d", texId, texTarget, outFrameW, outFrameH);
 
+    useNextOutputTex();
+
+    if (feedback) { // keep the output of the previous frame
+        swapFeedback();
+    }
+
     filterRenderPrepare();
     Tools::checkGLErr(getProcName(), "render prepare");
 
@@ -193,24 +241,82 @@ const GLfloat* FilterProcBase::getTexCoordBuf(RenderOrientation o) {
 }
 
 void FilterProcBase::initTexCoordBuf(RenderOrientation overrideRenderOrientation) {
-    RenderOrientation o = (overrideRenderOrientation == RenderOrientationNone) ? renderOrientation : overrideRenderOrientation;
-    memcpy(texCoordBuf, getTexCoordBuf(o), OGLES_GPGPU_QUAD_TEX_BUFSIZE * sizeof(GLfloat));
+    texCoordOrientation = (overrideRenderOrientation == RenderOrientationNone) ? renderOrientation : overrideRenderOrientation;
+}
+
+void FilterProcBase::filterRenderSetQuad(GLint posParam, GLint texCoordParam, RenderOrientation o) {
+    GLStateCache& glState = getGLState();
+
+    const GLvoid* vertices = ProcBase::quadVertices;
+    const GLvoid* texCoords = getTexCoordBuf(o);
+
+    if (core && core->getQuadBuffer().getIsInitialized()) {
+        const QuadBuffer& quad = core->getQuadBuffer();
+        glState.bindArrayBuffer(quad.getBufferId());
+        vertices = quad.getVerticesOffset();
+        texCoords = quad.getTexCoordsOffset(o);
+    } else {
+        glState.bindArrayBuffer(0);
+    }
+
+    glState.vertexAttribArray(posParam,
+        OGLES_GPGPU_QUAD_COORDS_PER_VERTEX,
+        GL_FLOAT,
+        GL_FALSE,
+        0,
+        vertices);
+
+    glState.vertexAttribArray(texCoordParam,
+        OGLES_GPGPU_QUAD_TEXCOORDS_PER_VERTEX,
+        GL_FLOAT,
+        GL_FALSE,
+        0,
+        texCoords);
+}
+
+void FilterProcBase::updateFusion() {
+    bool useFusion = core && core->getUseFilterFusion();
+
+    if (fusion && !useFusion) {
+        releaseFusion();
+    } else if (!fusion && useFusion) {
+        fusion = FilterFusion::create(this);
+    }
+
+    if (fusion) {
+        fusion->invalidate(); // stages will be (re)initialized
+    }
+}
+
+void FilterProcBase::releaseFusion() {
+    FilterProcBase* head = fusionHead ? fusionHead : this;
+    if (head->fusion) {
+        head->fusion->release(this);
+        delete head->fusion;
+        head->fusion = nullptr;
+    }
 }
 
 void FilterProcBase::filterRenderPrepare() {
-    shader->use();
+    GLStateCache& glState = getGLState();
+
+    glState.useProgram(shader->getProgramId());
     Tools::checkGLErr(getProcName(), "shader->use()");
 
+    // clear the FBO (there may be no default framebuffer, i.e. with a surfaceless context)
+    if (fbo) {
+        fbo->bind();
+    }
+
     // set the viewport
-    glViewport(0, 0, outFrameW, outFrameH);
+    glState.viewport(0, 0, outFrameW, outFrameH);
 
     glClear(GL_COLOR_BUFFER_BIT);
 
     assert(texTarget == GL_TEXTURE_2D); // texTarget = GL_TEXTURE_2D;
 
     // set input texture
-    glActiveTexture(GL_TEXTURE0 + texUnit);
-    glBindTexture(texTarget, texId); // bind input texture
+    glState.bindTexture(texUnit, texTarget, texId); // bind input texture
 
     // set common uniforms
     glUniform1i(shParamUInputTex, texUnit);
@@ -222,32 +328,39 @@ void FilterProcBase::filterRenderSetCoords() {
         fbo->bind();
 
     // set geometry
-    glEnableVertexAttribArray(shParamAPos);
-    glVertexAttribPointer(shParamAPos,
-        OGLES_GPGPU_QUAD_COORDS_PER_VERTEX,
-        GL_FLOAT,
-        GL_FALSE,
-        0,
-        vertexBuf);
-
-    glVertexAttribPointer(shParamATexCoord,
-        OGLES_GPGPU_QUAD_TEXCOORDS_PER_VERTEX,
-        GL_FLOAT,
-        GL_FALSE,
-        0,
-        texCoordBuf);
-    glEnableVertexAttribArray(shParamATexCoord);
+    filterRenderSetQuad(shParamAPos, shParamATexCoord, texCoordOrientation);
 }
 
 void FilterProcBase::filterRenderDraw() {
+    const bool scissor = filterRenderSetScissor();
+
     // draw
     glDrawArrays(GL_TRIANGLE_STRIP, 0, OGLES_GPGPU_QUAD_VERTICES);
+
+    if (scissor) {
+        glDisable(GL_SCISSOR_TEST);
+    }
+}
+
+bool FilterProcBase::filterRenderSetScissor() {
+    if (roi.width <= 0 || roi.height <= 0 || getRoiHalo() < 0) {
+        return false; // whole frame
+    }
+
+    // clamp the region of interest to the output frame
+    const int x0 = max(roi.x, 0), y0 = max(roi.y, 0);
+    const int x1 = min(roi.x + roi.width, outFrameW), y1 = min(roi.y + roi.height, outFrameH);
+
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(x0, y0, max(x1 - x0, 0), max(y1 - y0, 0));
+
+    return true;
 }
 
 void FilterProcBase::filterRenderCleanup() {
     // cleanup
-    glDisableVertexAttribArray(shParamAPos);
-    glDisableVertexAttribArray(shParamATexCoord);
+    getGLState().disableVertexAttribArray(shParamAPos);
+    getGLState().disableVertexAttribArray(shParamATexCoord);
 
     if (fbo)
         fbo->unbind();
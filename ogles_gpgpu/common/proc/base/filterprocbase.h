@@ -19,17 +19,55 @@
 
 namespace ogles_gpgpu {
 
+class FilterFusion;
+
 /**
  * Base class for filter processors. Such processors implement image processing
  * tasks with fragment shaders. They output is rendered on a fullscreen quad.
  */
 class FilterProcBase : public ProcBase {
+    friend class FilterFusion;
+
 public:
     FilterProcBase()
         : ProcBase()
         , fragShaderSrcForCompilation(NULL) {
     }
 
+    /**
+     * Deconstructor. Releases a fused filter chain this proc belongs to.
+     */
+    virtual ~FilterProcBase();
+
+    /**
+     * Cleanup processor's resources.
+     */
+    virtual void cleanup();
+
+    /**
+     * Returns true if the filter is point-wise, i.e. its output pixel only depends
+     * on the input pixel at the same position and its fragment shader samples
+     * the input texture only at "vTexCoord". Chains of point-wise filters can be
+     * fused into a single shader pass (see Core::setUseFilterFusion()).
+     */
+    virtual bool getIsPointwise() const {
+        return false;
+    }
+
+    /**
+     * Returns true if this proc is a stage of a fused filter chain.
+     */
+    bool getIsFused() const {
+        return fusion != nullptr || fusionHead != nullptr;
+    }
+
+    /**
+     * Create a texture that is attached to the FBO and will contain the processing result.
+     * Set <genMipmap> to true to generate a mipmap (usually only works with POT textures).
+     * If this proc is part of a fused filter chain, only the last stage gets a texture.
+     */
+    virtual void createFBOTex(bool genMipmap);
+
     /**
      * Set output orientation to <o>.
      */
@@ -95,12 +133,35 @@ protected:
      */
     void initTexCoordBuf(RenderOrientation overrideRenderOrientation = RenderOrientationNone);
 
+    /**
+     * Set the vertex attribute arrays <posParam> and <texCoordParam> to the full-screen
+     * quad with texture coordinates for orientation <o>. The quad buffer of the context
+     * is used if available, else the vertex data is passed from client memory.
+     */
+    void filterRenderSetQuad(GLint posParam, GLint texCoordParam, RenderOrientation o);
+
+    /**
+     * Enable the scissor test for the region of interest of the output (see setRoi()).
+     * Returns false if the whole frame is rendered.
+     */
+    bool filterRenderSetScissor();
+
     /**
      * Return texture coordinates cooresponding to a particular orientation: buffer according to member variable
      * <renderOrientation> or override member variable by <overrideRenderOrientation>.
      */
     static const GLfloat* getTexCoordBuf(RenderOrientation o);
 
+    /**
+     * Detect (or release) a fused chain of point-wise filters starting at this proc.
+     */
+    void updateFusion();
+
+    /**
+     * Release the fused chain this proc belongs to.
+     */
+    void releaseFusion();
+
     virtual void filterRenderPrepare();
     virtual void filterRenderSetCoords();
     virtual void filterRenderDraw();
@@ -116,8 +177,10 @@ protected:
     GLint shParamAPos; // shader attribute vertex positions
     GLint shParamATexCoord; // shader attribute texture coordinates
 
-    GLfloat vertexBuf[OGLES_GPGPU_QUAD_VERTEX_BUFSIZE]; // vertex data buffer for a quad
-    GLfloat texCoordBuf[OGLES_GPGPU_QUAD_TEX_BUFSIZE]; // texture coordinate data buffer for a quad
+    RenderOrientation texCoordOrientation = RenderOrientationStd; // orientation of the quad texture coordinates
+
+    FilterFusion* fusion = nullptr; // fused chain that starts at this proc. strong ref.!
+    FilterProcBase* fusionHead = nullptr; // first proc of the fused chain this proc belongs to. weak ref.
 };
 }
 
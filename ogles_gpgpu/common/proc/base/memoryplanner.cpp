@@ -0,0 +1,144 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "memoryplanner.h"
+#include "filterprocbase.h"
+
+#include <algorithm>
+
+BEGIN_OGLES_GPGPU
+
+void MemoryPlanner::visit(ProcInterface* proc) {
+    nodes[proc].visits.push_back(++numEvents);
+
+    stack.push_back(proc);
+    for (auto& subscriber : proc->getSubscribers()) {
+        edges.emplace_back(proc, subscriber.first);
+
+        if (std::find(stack.begin(), stack.end(), subscriber.first) != stack.end()) {
+            // feedback loop: both outputs are needed in the next frame
+            nodes[proc].pinned = true;
+            nodes[subscriber.first].pinned = true;
+            continue;
+        }
+
+        visit(subscriber.first);
+    }
+    stack.pop_back();
+}
+
+MemoryReport MemoryPlanner::plan(ProcInterface* root) {
+    assert(root);
+
+    nodes.clear();
+    edges.clear();
+    stack.clear();
+    numEvents = 0;
+
+    // simulate the processing order
+    visit(root);
+
+    // the textures of a previous plan are handed out again (in the same order for
+    // an unchanged graph), the unused ones are deleted at the end
+    pool.releaseAll();
+
+    for (auto& it : nodes) {
+        it.second.lastRead = it.second.visits.back();
+    }
+
+    // a subscriber may read the output at any of its render events
+    for (auto& edge : edges) {
+        Node& producer = nodes[edge.first];
+        const Node& consumer = nodes[edge.second];
+
+        if (consumer.visits.front() < producer.visits.front()) {
+            producer.pinned = true; // output of the previous frame is read
+        } else {
+            producer.lastRead = std::max(producer.lastRead, consumer.visits.back());
+        }
+    }
+
+    MemoryReport report;
+    size_t pinnedBytes = 0;
+
+    // collect the procs whose output can be shared, in order of their first render event
+    std::vector<std::pair<int, ProcBase*>> candidates;
+    for (auto& it : nodes) {
+        auto* proc = dynamic_cast<ProcBase*>(it.first);
+        size_t bytes = proc ? proc->getOutputTexBytes() : 0;
+        if (!bytes) {
+            continue; // composite proc or no own output texture
+        }
+
+        report.numProcs++;
+        report.unplannedBytes += bytes;
+
+        // the tail of a fused chain is rendered at the visit of its head
+        auto* filterProc = dynamic_cast<FilterProcBase*>(proc);
+        const bool fused = filterProc && filterProc->getIsFused();
+
+        // a shared output texture is managed elsewhere (i.e. by a FifoProc in rotation mode),
+        // unless it was assigned by a previous plan
+        const bool planned = pool.owns(proc->getOutputTexId());
+        const bool shared = proc->getMemTransferObj()->isOutputShared() && !planned;
+
+        if (it.second.pinned || fused || shared || proc->getSubscribers().empty()) {
+            if (planned) {
+                proc->createFBOTex(false); // render into an own texture again
+                bytes = proc->getOutputTexBytes();
+            }
+            report.numTextures++;
+            pinnedBytes += bytes;
+        } else {
+            candidates.emplace_back(it.second.visits.front(), proc);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+
+    // greedy interval allocation: release textures that are dead before the next proc renders
+    std::vector<std::pair<int, GLuint>> live; // (last read event, texture)
+    std::vector<size_t> liveBytes(numEvents + 2, 0);
+    for (auto& it : candidates) {
+        const int start = it.first;
+        ProcBase* proc = it.second;
+        const Node& node = nodes[proc];
+
+        for (auto liveIt = live.begin(); liveIt != live.end();) {
+            if (liveIt->first < start) {
+                pool.release(liveIt->second);
+                liveIt = live.erase(liveIt);
+            } else {
+                ++liveIt;
+            }
+        }
+
+        const size_t bytes = proc->getOutputTexBytes();
+        GLuint texId = pool.acquire(proc->getOutFrameW(), proc->getOutFrameH());
+        proc->setOutputTex(texId);
+        live.emplace_back(node.lastRead, texId);
+
+        for (int event = start; event <= node.lastRead; event++) {
+            liveBytes[event] += bytes;
+        }
+
+        report.numAliased++;
+    }
+
+    pool.purge();
+
+    report.numTextures += pool.getNumTextures();
+    report.steadyBytes = pinnedBytes + pool.getAllocatedBytes();
+    report.peakBytes = pinnedBytes + *std::max_element(liveBytes.begin(), liveBytes.end());
+
+    OG_LOGINF("MemoryPlanner", "%d procs, %d aliased, %d textures: %zu bytes unplanned, %zu bytes steady, %zu bytes peak",
+        report.numProcs, report.numAliased, report.numTextures,
+        report.unplannedBytes, report.steadyBytes, report.peakBytes);
+
+    return report;
+}
+
+END_OGLES_GPGPU
@@ -0,0 +1,84 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Render target memory planner for filter graphs.
+ */
+#ifndef OGLES_GPGPU_COMMON_PROC_MEMORYPLANNER
+#define OGLES_GPGPU_COMMON_PROC_MEMORYPLANNER
+
+#include "../../common_includes.h"
+
+#include "../../gl/texture_pool.h"
+#include "procinterface.h"
+
+#include <map>
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+/**
+ * Render target memory statistics of a filter graph.
+ */
+struct MemoryReport {
+    int numProcs = 0; // number of procs with an output texture
+    int numAliased = 0; // number of procs that render to a shared texture
+    int numTextures = 0; // number of output textures after planning
+    size_t unplannedBytes = 0; // output texture memory with one texture per proc
+    size_t steadyBytes = 0; // output texture memory held after planning
+    size_t peakBytes = 0; // max. output texture memory that is live at the same time during one frame
+};
+
+/**
+ * MemoryPlanner aliases the output textures of intermediate procs in a filter graph
+ * (see ProcInterface::add()). It simulates the processing order of ProcInterface::process()
+ * to find the lifetime of each output texture, i.e. from its first render until its last
+ * read by a subscriber. Procs with non-overlapping lifetimes share one texture from a TexturePool.
+ * The peak memory is then proportional to the width of the graph rather than its depth.
+ *
+ * The outputs of the last procs (without subscribers) are never shared. Procs in feedback
+ * loops or with subscribers that read their output of the previous frame keep their own
+ * texture, too. Intermediate results are not valid anymore after processing.
+ */
+class MemoryPlanner {
+public:
+    /**
+     * Constructor. Shared textures are taken from <pool>.
+     */
+    MemoryPlanner(TexturePool& pool)
+        : pool(pool) {
+    }
+
+    /**
+     * Plan the filter graph that starts at <root>. Must be called after the graph
+     * was prepared. Returns the memory statistics. May be called again for the same
+     * graph (i.e. after it was changed): the textures of the previous plan are reused.
+     */
+    MemoryReport plan(ProcInterface* root);
+
+private:
+    struct Node {
+        std::vector<int> visits; // render events of this proc
+        int lastRead = 0; // last event in which the output is read
+        bool pinned = false; // output must not be shared
+    };
+
+    /**
+     * Simulate processing of <proc> and all of its subscribers.
+     */
+    void visit(ProcInterface* proc);
+
+    TexturePool& pool; // texture pool for shared textures
+
+    std::map<ProcInterface*, Node> nodes; // all procs of the graph
+    std::vector<std::pair<ProcInterface*, ProcInterface*>> edges; // (producer, consumer)
+    std::vector<ProcInterface*> stack; // procs in the current processing path
+    int numEvents = 0; // number of render events
+};
+
+END_OGLES_GPGPU
+
+#endif // OGLES_GPGPU_COMMON_PROC_MEMORYPLANNER
@@ -105,6 +105,13 @@ void MultiPassProc::cleanup() {
     }
 }
 
+void MultiPassProc::setCore(Core* c) {
+    ProcInterface::setCore(c);
+    for (auto& it : procPasses) {
+        it->setCore(c);
+    }
+}
+
 void MultiPassProc::createFBOTex(bool genMipmap) {
     bool first = true;
     for (auto& it : procPasses) {
@@ -143,3 +150,34 @@ bool MultiPassProc::getWillDownscale() const {
     }
     return false;
 }
+
+void MultiPassProc::setRoi(const Rect2d& roi) {
+    ProcInterface::setRoi(roi);
+
+    const bool whole = (roi.width <= 0 || roi.height <= 0);
+
+    // go backwards: each pass renders the region that is read by the following passes
+    int halo = 0;
+    for (auto it = procPasses.rbegin(); it != procPasses.rend(); ++it) {
+        if (whole || halo < 0) {
+            (*it)->setRoi(Rect2d());
+        } else {
+            (*it)->setRoi(Rect2d(roi.x - halo, roi.y - halo, roi.width + 2 * halo, roi.height + 2 * halo));
+        }
+
+        const int passHalo = (*it)->getRoiHalo();
+        halo = (halo < 0 || passHalo < 0) ? -1 : halo + passHalo;
+    }
+}
+
+int MultiPassProc::getRoiHalo() const {
+    int halo = 0;
+    for (auto& it : procPasses) {
+        const int passHalo = it->getRoiHalo();
+        if (passHalo < 0) {
+            return -1;
+        }
+        halo += passHalo;
+    }
+    return halo;
+}
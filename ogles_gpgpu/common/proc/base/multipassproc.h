@@ -52,6 +52,11 @@ public:
      */
     virtual void cleanup();
 
+    /**
+     * Bind this proc and all of its passes to the processing context <c>.
+     */
+    virtual void setCore(Core* c);
+
     /**
      * Create a texture that is attached to the FBO and will contain the processing result.
      * Set <genMipmap> to true to generate a mipmap (usually only works with POT textures).
@@ -74,6 +79,17 @@ public:
      */
     virtual bool getWillDownscale() const;
 
+    /**
+     * Restrict rendering to the region of interest <roi> of the output frame. The
+     * passes render <roi> plus the halo of the passes that follow them.
+     */
+    virtual void setRoi(const Rect2d& roi);
+
+    /**
+     * Return the sum of the halos of all passes (or -1 if a pass depends on its whole input).
+     */
+    virtual int getRoiHalo() const;
+
     /**
      * Get number of passes for this multipass processor.
      */
@@ -8,6 +8,7 @@
 //
 
 #include "procbase.h"
+#include "../../core.h"
 
 #include <string>
 
@@ -73,7 +74,7 @@ const GLfloat ProcBase::quadVertices[] = {
 ProcBase::ProcBase() {
     texId = 0;
     texUnit = 1;
-    shader = NULL;
+    texTarget = GL_TEXTURE_2D;
     fbo = NULL;
     willDownscale = false;
 
@@ -95,10 +96,12 @@ void ProcBase::cleanup() {
         outFrameW = outFrameH = 0;
     }
 
-    if (shader) {
-        delete shader;
-        shader = NULL;
-    }
+    // the program is deleted when no other proc uses it anymore
+    shader.reset();
+
+    feedbackTextures.clear();
+    feedbackTexId = 0;
+    nextOutputTexId = 0;
 }
 
 void ProcBase::printInfo() {
@@ -141,6 +144,45 @@ void ProcBase::createFBOTex(bool genMipmap) {
     // update frame size, because it might be set to a POT size because of mipmapping
     outFrameW = fbo->getTexWidth();
     outFrameH = fbo->getTexHeight();
+
+    feedbackTextures.clear();
+    feedbackTexId = 0;
+    nextOutputTexId = 0;
+
+    if (feedback) {
+        // render alternately into two textures of the pool (see swapFeedback())
+        setOutputTex(feedbackTextures.acquire(outFrameW, outFrameH));
+        feedbackTexId = feedbackTextures.acquire(outFrameW, outFrameH);
+    }
+}
+
+void ProcBase::setOutputTex(GLuint texId) {
+    assert(fbo != NULL);
+
+    fbo->attachTex(texId, fbo->getTexWidth(), fbo->getTexHeight());
+}
+
+void ProcBase::swapFeedback() {
+    assert(feedback && feedbackTexId > 0);
+
+    const GLuint outputTexId = fbo->getAttachedTexId();
+    setOutputTex(feedbackTexId);
+    feedbackTexId = outputTexId;
+}
+
+void ProcBase::useNextOutputTex() {
+    if (nextOutputTexId > 0) {
+        setOutputTex(nextOutputTexId);
+        nextOutputTexId = 0;
+    }
+}
+
+size_t ProcBase::getOutputTexBytes() const {
+    if (!fbo || !fbo->getAttachedTexId()) {
+        return 0;
+    }
+
+    return size_t(fbo->getTexWidth()) * size_t(fbo->getTexHeight()) * 4; // RGBA
 }
 
 int ProcBase::reinit(int inW, int inH, bool prepareForExternalInput) {
@@ -219,17 +261,22 @@ void ProcBase::setInOutFrameSizes(int inW, int inH, int outW, int outH, float sc
     willDownscale = (outFrameW < inFrameW || outFrameH < inFrameH);
 }
 
+GLStateCache& ProcBase::getGLState() const {
+    static GLStateCache passThrough(false);
+    return core ? core->getGLState() : passThrough;
+}
+
 void ProcBase::createFBO() {
     assert(fbo == NULL);
 
-    fbo = new FBO();
+    fbo = new FBO(core);
     fbo->setGLTexUnit(1);
 }
 
 void ProcBase::createShader(const char* vShSrc, const char* fShSrc, GLenum target, const Shader::Attributes& attributes) {
     if (shader) { // already compiled,
         if (texTarget != target)
-            delete shader; // change in texture target -> recreate!
+            shader.reset(); // change in texture target -> recreate!
         else
             return; // no change -> do nothing
     }
@@ -253,8 +300,14 @@ void ProcBase::createShader(const char* vShSrc, const char* fShSrc, GLenum targe
     }
 #endif
 
-    shader = new Shader();
-    bool compiled = shader->buildFromSrc(vShSrc, fSrcStr.c_str(), attributes);
+    if (core) {
+        shader = core->getShaderCache().acquire(vShSrc, fSrcStr.c_str(), target, attributes);
+    } else {
+        shader = make_shared<Shader>();
+        shader->buildFromSrc(vShSrc, fSrcStr.c_str(), attributes);
+    }
+
+    bool compiled = (shader->getProgramId() > 0);
 
     assert(compiled);
 
@@ -19,6 +19,10 @@
 #include "../../gl/fbo.h"
 #include "../../gl/memtransfer.h"
 #include "../../gl/shader.h"
+#include "../../gl/state_cache.h"
+#include "../../gl/texture_pool.h"
+
+#include <memory>
 
 #define OGLES_GPGPU_QUAD_VERTICES 4
 #define OGLES_GPGPU_QUAD_COORDS_PER_VERTEX 3
@@ -185,7 +189,58 @@ public:
         return texTarget;
     }
 
+    /**
+     * Render to the texture <texId> (weak ref., i.e. from a TexturePool) instead of an own
+     * output texture. Must be called after createFBOTex(). The next createFBOTex() call will
+     * create an own output texture again.
+     */
+    virtual void setOutputTex(GLuint texId);
+
+    /**
+     * Return the number of bytes of the output texture (0 if there is none).
+     */
+    virtual size_t getOutputTexBytes() const;
+
+    /**
+     * Double-buffer the output for a feedback loop (i.e. a temporal filter that reads its own
+     * output of the previous frame): each frame is rendered into the other of two output
+     * textures, so that the previous output can be read while rendering without a copy.
+     * Must be called before createFBOTex().
+     */
+    void setFeedback(bool feedback) {
+        this->feedback = feedback;
+    }
+
+    /**
+     * Returns true if the output is double-buffered for a feedback loop.
+     */
+    bool getFeedback() const {
+        return feedback;
+    }
+
+    /**
+     * Return the output texture of the previous frame (0 if the output is not double-buffered).
+     * Its content is undefined before the second frame.
+     */
+    GLuint getFeedbackTexId() const {
+        return feedbackTexId;
+    }
+
+    /**
+     * Render the next frame into <texId> (i.e. a slot of a FifoProc in rotation mode).
+     * The output texture stays the same until then.
+     */
+    void setNextOutputTex(GLuint texId) {
+        nextOutputTexId = texId;
+    }
+
 protected:
+    /**
+     * Get the OpenGL state cache of the context of this proc. Procs without a
+     * context get a cache that passes all calls to OpenGL.
+     */
+    GLStateCache& getGLState() const;
+
     /**
      * Common initializations with input size <inW>x<inH>, pipeline processing <order>, output size <outW>x<outH> and
      * scaling factor <scaleFactor>. If output size is 0x0, the output size will be calculated by input size * scaling
@@ -207,10 +262,22 @@ protected:
     /**
      * Create the shader program from vertex and fragment shader source code
      * <vshSrc> and <fshSrc>. The fragment shader source might be modified, depending
-     * on texture target <target>.
+     * on texture target <target>. If this proc belongs to a context (see setCore()),
+     * identical programs are shared via the context's ShaderCache.
      */
     virtual void createShader(const char* vShSrc, const char* fShSrc, GLenum target, const Shader::Attributes& attributes = {});
 
+    /**
+     * Render the next frame into the feedback texture: the current output becomes the
+     * feedback texture (see setFeedback()).
+     */
+    void swapFeedback();
+
+    /**
+     * Attach the texture that was set with setNextOutputTex() (if any) before rendering.
+     */
+    void useNextOutputTex();
+
     static const GLfloat quadTexCoordsStd[]; // default quad texture coordinates
     static const GLfloat quadTexCoordsStdMirrored[]; // default quad texture coordinates (mirrored)
     static const GLfloat quadTexCoordsFlipped[]; // flipped quad texture coordinates
@@ -221,7 +288,7 @@ protected:
     static const GLfloat quadVertices[]; // default quad vertices
 
     FBO* fbo; // strong ref.!
-    Shader* shader; // strong ref.!
+    std::shared_ptr<Shader> shader; // shared program, strong ref.!
 
     unsigned int orderNum; // position of this processor in the pipeline
 
@@ -247,6 +314,11 @@ protected:
 
     int outFrameW = 0; // output frame width
     int outFrameH = 0; // output frame height
+
+    bool feedback = false; // double-buffered output?
+    TexturePool feedbackTextures; // both output textures in feedback mode
+    GLuint feedbackTexId = 0; // output texture of the previous frame
+    GLuint nextOutputTexId = 0; // render target of the next frame (0: the output texture)
 };
 }
 
@@ -1,4 +1,5 @@
 #include "procinterface.h"
+#include "../../core.h"
 
 using namespace ogles_gpgpu;
 
@@ -42,6 +43,28 @@ void ProcInterface::add(ProcInterface* filter, int position) {
     subscribers.emplace_back(filter, position);
 }
 
+void ProcInterface::shareCore(ProcInterface* subscriber) const {
+    if (core && !subscriber->getCore()) {
+        subscriber->setCore(core);
+    }
+}
+
+int ProcInterface::renderProfiled(int position) {
+    Profiler* profiler = (core && core->getProfiler().getEnabled()) ? &core->getProfiler() : nullptr;
+
+    if (profiler) {
+        profiler->begin(this);
+    }
+
+    int result = render(position);
+
+    if (profiler) {
+        profiler->end(this);
+    }
+
+    return result;
+}
+
 // Top level recursive filter chain processing, set input texture for first filter as needed
 void ProcInterface::process(GLuint id, GLuint useTexUnit, GLenum target, int index, int position, Logger logger) {
 
@@ -66,7 +89,7 @@ void ProcInterface::process(GLuint id, GLuint useTexUnit, GLenum target, int ind
         Tools::checkGLErr(getProcName(), "useTexture");
     }
 
-    int result = render(position);
+    int result = renderProfiled(position);
 
     if (m_postRenderCallback) {
         m_postRenderCallback(this);
@@ -101,7 +124,7 @@ void ProcInterface::process(int position, Logger logger) {
         m_preRenderCallback(this);
     }
 
-    int result = render(position);
+    int result = renderProfiled(position);
 
     if (m_postRenderCallback) {
         m_postRenderCallback(this);
@@ -163,6 +186,7 @@ void ProcInterface::prepare(int inW, int inH, GLenum inFmt, int index, int posit
         createFBOTex(useMipmaps && willDownScale); // last one is false
 
         for (auto& subscriber : subscribers) {
+            shareCore(subscriber.first);
             subscriber.first->prepare(getOutFrameW(), getOutFrameH(), index + 1, subscriber.second);
             subscriber.first->useTexture(getOutputTexId(), getTextureUnit(), GL_TEXTURE_2D, subscriber.second);
         }
@@ -202,6 +226,7 @@ void ProcInterface::prepare(int inW, int inH, int index, int position) {
         createFBOTex(useMipmaps && willDownScale); // last one is false
 
         for (auto& subscriber : subscribers) {
+            shareCore(subscriber.first);
             subscriber.first->prepare(getOutFrameW(), getOutFrameH(), index + 1, subscriber.second);
             subscriber.first->useTexture(getOutputTexId(), getTextureUnit(), GL_TEXTURE_2D, subscriber.second);
         }
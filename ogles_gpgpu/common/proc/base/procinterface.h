@@ -21,6 +21,8 @@
 
 BEGIN_OGLES_GPGPU
 
+class Core;
+
 /**
  * GPGPU processor interface
  */
@@ -218,6 +220,14 @@ public:
      */
     virtual void add(ProcInterface* filter, int position = 0);
 
+    /**
+     * Return all subscribers in processing order as pairs of (proc, input position).
+     * Procs that trigger additional (i.e. delayed) subscribers append those.
+     */
+    virtual std::vector<std::pair<ProcInterface*, int>> getSubscribers() const {
+        return subscribers;
+    }
+
     /**
      * Prepare the filter chain
      */
@@ -238,6 +248,23 @@ public:
      */
     virtual void process(int position, Logger logger = {});
 
+    /**
+     * Bind this proc to the processing context <c>. The context provides the MemTransfer
+     * factory and mipmap settings for the FBOs created by this proc. Must be set before
+     * init(). Procs without a context use the default (non-optimized) settings.
+     * The context is propagated to all subscribers in prepare().
+     */
+    virtual void setCore(Core* c) {
+        core = c;
+    }
+
+    /**
+     * Get the processing context this proc is bound to (may be NULL).
+     */
+    virtual Core* getCore() const {
+        return core;
+    }
+
     /**
      * Allow this proc to use mipmaps
      */
@@ -280,12 +307,50 @@ public:
      */
     virtual void setPostInitCallback(ProcDelegate& cb);
 
+    /**
+     * Restrict rendering to the region of interest <roi> of the output frame (in output
+     * pixels). The output outside of the region is undefined. An empty region renders
+     * the whole frame. See RoiPlanner for a region of a whole filter graph.
+     */
+    virtual void setRoi(const Rect2d& roi) {
+        this->roi = roi;
+    }
+
+    /**
+     * Get the region of interest of the output frame (empty for the whole frame).
+     */
+    const Rect2d& getRoi() const {
+        return roi;
+    }
+
+    /**
+     * Return the distance (in output pixels) up to which the input around an output pixel
+     * is read to render it (i.e. 1 for a 3x3 neighbourhood), or -1 if an output pixel may
+     * depend on any input pixel. A region of interest is not applied to a proc with -1.
+     */
+    virtual int getRoiHalo() const {
+        return 0;
+    }
+
 protected:
     /**
      * Get a formatted/unique filter tag
      */
     virtual std::string getFilterTag();
 
+    /**
+     * Pass the processing context of this proc on to <subscriber> if it has none yet.
+     */
+    void shareCore(ProcInterface* subscriber) const;
+
+    /**
+     * Call render() with <position> and measure it with the profiler of the
+     * processing context (if enabled).
+     */
+    int renderProfiled(int position);
+
+    Core* core = nullptr; // processing context. weak ref.
+
     bool useMipmaps = false; // TODO:
 
     std::string title;
@@ -294,6 +359,8 @@ protected:
 
     std::vector<std::pair<ProcInterface*, int>> subscribers;
 
+    Rect2d roi; // region of interest of the output (empty for the whole frame)
+
     ProcDelegate m_preProcessCallback;
     ProcDelegate m_postProcessCallback;
 
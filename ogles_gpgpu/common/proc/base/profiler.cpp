@@ -0,0 +1,453 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "profiler.h"
+#include "procinterface.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#pragma mark timer query entry points
+
+#if defined(OGLES_GPGPU_TIMER_QUERY) && defined(OGLES_GPGPU_ANDROID)
+// EXT_disjoint_timer_query is an extension on OpenGL ES 2.0: query the entry points at runtime
+#define OG_GL_TIMESTAMP GL_TIMESTAMP_EXT
+#define OG_GL_QUERY_RESULT GL_QUERY_RESULT_EXT
+#define OG_GL_QUERY_RESULT_AVAILABLE GL_QUERY_RESULT_AVAILABLE_EXT
+
+static PFNGLGENQUERIESEXTPROC ogGenQueries() {
+    static auto func = (PFNGLGENQUERIESEXTPROC)eglGetProcAddress("glGenQueriesEXT");
+    return func;
+}
+
+static PFNGLDELETEQUERIESEXTPROC ogDeleteQueries() {
+    static auto func = (PFNGLDELETEQUERIESEXTPROC)eglGetProcAddress("glDeleteQueriesEXT");
+    return func;
+}
+
+static PFNGLQUERYCOUNTEREXTPROC ogQueryCounter() {
+    static auto func = (PFNGLQUERYCOUNTEREXTPROC)eglGetProcAddress("glQueryCounterEXT");
+    return func;
+}
+
+static PFNGLGETQUERYOBJECTIVEXTPROC ogGetQueryObjectiv() {
+    static auto func = (PFNGLGETQUERYOBJECTIVEXTPROC)eglGetProcAddress("glGetQueryObjectivEXT");
+    return func;
+}
+
+static PFNGLGETQUERYOBJECTUI64VEXTPROC ogGetQueryObjectui64v() {
+    static auto func = (PFNGLGETQUERYOBJECTUI64VEXTPROC)eglGetProcAddress("glGetQueryObjectui64vEXT");
+    return func;
+}
+
+// timestamps are invalid if the GPU was disjoint (i.e. changed its clock) in between
+static bool ogGetDisjoint() {
+    GLint disjoint = 0;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    return disjoint != 0;
+}
+#elif defined(OGLES_GPGPU_TIMER_QUERY)
+#define OG_GL_TIMESTAMP GL_TIMESTAMP
+#define OG_GL_QUERY_RESULT GL_QUERY_RESULT
+#define OG_GL_QUERY_RESULT_AVAILABLE GL_QUERY_RESULT_AVAILABLE
+
+static PFNGLGENQUERIESPROC ogGenQueries() {
+    return glGenQueries;
+}
+
+static PFNGLDELETEQUERIESPROC ogDeleteQueries() {
+    return glDeleteQueries;
+}
+
+static PFNGLQUERYCOUNTERPROC ogQueryCounter() {
+    return glQueryCounter;
+}
+
+static PFNGLGETQUERYOBJECTIVPROC ogGetQueryObjectiv() {
+    return glGetQueryObjectiv;
+}
+
+static PFNGLGETQUERYOBJECTUI64VPROC ogGetQueryObjectui64v() {
+    return glGetQueryObjectui64v;
+}
+
+static bool ogGetDisjoint() {
+    return false;
+}
+#endif
+
+#pragma mark helper functions
+
+static const int kMaxPendingFrames = 4; // wait for the GPU times if more frames are pending
+
+// percentile <p> (0..1) of the values <v>
+static double getPercentile(const deque<double>& v, double p) {
+    if (v.empty()) {
+        return 0.0;
+    }
+
+    vector<double> sorted(v.begin(), v.end());
+    size_t i = min(sorted.size() - 1, (size_t)(p * (sorted.size() - 1) + 0.5));
+    nth_element(sorted.begin(), sorted.begin() + i, sorted.end());
+    return sorted[i];
+}
+
+static void addSample(deque<double>& v, double value, int maxSamples) {
+    v.push_back(value);
+    while ((int)v.size() > maxSamples) {
+        v.pop_front();
+    }
+}
+
+// escape <s> for a JSON string
+static string getJSONString(const string& s) {
+    stringstream ss;
+    ss << '"';
+    for (auto c : s) {
+        if (c == '"' || c == '\\') {
+            ss << '\\' << c;
+        } else if ((unsigned char)c < 0x20) {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", c);
+            ss << buf;
+        } else {
+            ss << c;
+        }
+    }
+    ss << '"';
+    return ss.str();
+}
+
+#pragma mark constructor/deconstructor
+
+Profiler::Profiler()
+    : enabled(false)
+    , useTimerQueries(true)
+    , inFrame(false)
+    , maxSamples(1000)
+    , maxTraceEvents(100000)
+    , numFrames(0)
+    , epoch(Clock::now()) {
+}
+
+Profiler::~Profiler() {
+    clear();
+}
+
+#pragma mark public methods
+
+void Profiler::setEnabled(bool enabled) {
+    if (this->enabled && !enabled) {
+        flush();
+    }
+
+    this->enabled = enabled;
+}
+
+bool Profiler::getSupportsTimerQueries() {
+#ifdef OGLES_GPGPU_TIMER_QUERY
+    const char* ext = (const char*)glGetString(GL_EXTENSIONS);
+#ifdef OGLES_GPGPU_ANDROID
+    return ext && strstr(ext, "GL_EXT_disjoint_timer_query") && ogQueryCounter() && ogGetQueryObjectui64v();
+#else
+    // core in OpenGL 3.3
+    int major = 0, minor = 0;
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (version && sscanf(version, "%d.%d", &major, &minor) == 2 && (major > 3 || (major == 3 && minor >= 3))) {
+        return true;
+    }
+    return ext && strstr(ext, "GL_ARB_timer_query");
+#endif
+#else
+    return false;
+#endif
+}
+
+bool Profiler::getUseTimerQueries() const {
+    static bool supported = getSupportsTimerQueries();
+    return useTimerQueries && supported;
+}
+
+void Profiler::beginFrame() {
+    if (!enabled) {
+        return;
+    }
+
+    current.clear();
+    open.clear();
+    inFrame = true;
+}
+
+void Profiler::endFrame() {
+    if (!enabled || !inFrame) {
+        return;
+    }
+
+    inFrame = false;
+
+    if (getUseTimerQueries()) {
+        pending.emplace_back(numFrames, current);
+        collect((int)pending.size() > kMaxPendingFrames);
+    } else {
+        record(current, numFrames, 0.0, vector<double>());
+    }
+
+    current.clear();
+    open.clear();
+    numFrames++;
+}
+
+void Profiler::begin(ProcInterface* proc) {
+    Sample s;
+    s.node = getNode(proc);
+    s.cpuMs = s.gpuMs = 0.0;
+    s.queries[0] = s.queries[1] = 0;
+    s.pending = false;
+
+    if (getUseTimerQueries()) {
+#ifdef OGLES_GPGPU_TIMER_QUERY
+        s.queries[0] = acquireQuery();
+        s.queries[1] = acquireQuery();
+        ogQueryCounter()(s.queries[0], OG_GL_TIMESTAMP);
+        s.pending = true;
+#endif
+    } else {
+        glFinish(); // do not measure previous commands
+    }
+
+    s.startTime = Clock::now();
+    s.cpuStartUs = getTimeUs();
+
+    open.push_back((int)current.size());
+    current.push_back(s);
+}
+
+void Profiler::end(ProcInterface* proc) {
+    Clock::time_point endTime = Clock::now();
+
+    // the innermost unfinished sample (nested procs are finished before)
+    if (open.empty() || nodes[current[open.back()].node].proc != proc) {
+        OG_LOGERR("Profiler", "end() without matching begin() for %s", proc->getProcName());
+        return;
+    }
+    Sample& s = current[open.back()];
+    open.pop_back();
+
+    s.cpuMs = chrono::duration<double, milli>(endTime - s.startTime).count();
+
+    if (s.pending) {
+#ifdef OGLES_GPGPU_TIMER_QUERY
+        ogQueryCounter()(s.queries[1], OG_GL_TIMESTAMP);
+#endif
+    } else {
+        glFinish();
+        s.gpuMs = chrono::duration<double, milli>(Clock::now() - s.startTime).count();
+    }
+
+    if (!inFrame && open.empty()) { // outermost call, but not between beginFrame() and endFrame()
+        inFrame = true;
+        endFrame();
+    }
+}
+
+void Profiler::flush() {
+    collect(true);
+}
+
+void Profiler::reset() {
+    flush();
+
+    nodes.clear();
+    nodeIndex.clear();
+    traceEvents.clear();
+    numFrames = 0;
+    epoch = Clock::now();
+}
+
+void Profiler::clear() {
+    reset();
+
+#ifdef OGLES_GPGPU_TIMER_QUERY
+    if (!allQueries.empty()) {
+        ogDeleteQueries()((GLsizei)allQueries.size(), &allQueries[0]);
+    }
+#endif
+
+    allQueries.clear();
+    freeQueries.clear();
+}
+
+vector<ProfilerStats> Profiler::getStats() const {
+    vector<ProfilerStats> stats;
+
+    for (auto& n : nodes) {
+        ProfilerStats s;
+        s.proc = n.proc;
+        s.name = n.name;
+        s.count = (int)n.cpuMs.size();
+        s.cpuP50 = getPercentile(n.cpuMs, 0.50);
+        s.cpuP95 = getPercentile(n.cpuMs, 0.95);
+        s.cpuP99 = getPercentile(n.cpuMs, 0.99);
+        s.gpuP50 = getPercentile(n.gpuMs, 0.50);
+        s.gpuP95 = getPercentile(n.gpuMs, 0.95);
+        s.gpuP99 = getPercentile(n.gpuMs, 0.99);
+        stats.push_back(s);
+    }
+
+    return stats;
+}
+
+string Profiler::getChromeTrace() const {
+    stringstream ss;
+    ss.precision(3);
+    ss << fixed;
+
+    ss << "{\"traceEvents\":[\n";
+    ss << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    ss << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+    for (auto& e : traceEvents) {
+        ss << ",\n{\"name\":" << getJSONString(nodes[e.node].name)
+           << ",\"cat\":\"" << (e.gpu ? "gpu" : "cpu") << "\""
+           << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << (e.gpu ? 2 : 1)
+           << ",\"ts\":" << e.tsUs
+           << ",\"dur\":" << e.durUs
+           << ",\"args\":{\"frame\":" << e.frame << "}}";
+    }
+
+    ss << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    return ss.str();
+}
+
+bool Profiler::writeChromeTrace(const string& path) const {
+    ofstream f(path.c_str(), ios::out | ios::binary);
+    if (!f) {
+        OG_LOGERR("Profiler", "could not open trace file %s", path.c_str());
+        return false;
+    }
+
+    f << getChromeTrace();
+
+    return f.good();
+}
+
+#pragma mark private methods
+
+int Profiler::getNode(ProcInterface* proc) {
+    auto it = nodeIndex.find(proc);
+    if (it != nodeIndex.end()) {
+        return it->second;
+    }
+
+    Node n;
+    n.proc = proc;
+    n.name = strlen(proc->getProcTitle()) ? proc->getProcTitle() : proc->getProcName();
+    nodes.push_back(n);
+
+    return nodeIndex[proc] = (int)nodes.size() - 1;
+}
+
+GLuint Profiler::acquireQuery() {
+    GLuint q = 0;
+
+    if (!freeQueries.empty()) {
+        q = freeQueries.back();
+        freeQueries.pop_back();
+    } else {
+#ifdef OGLES_GPGPU_TIMER_QUERY
+        ogGenQueries()(1, &q);
+        allQueries.push_back(q);
+#endif
+    }
+
+    return q;
+}
+
+void Profiler::collect(bool wait) {
+#ifdef OGLES_GPGPU_TIMER_QUERY
+    bool disjoint = !pending.empty() && ogGetDisjoint();
+
+    while (!pending.empty()) {
+        vector<Sample>& samples = pending.front().second;
+
+        // the last query of a frame is finished after all others
+        if (!wait && !samples.empty()) {
+            GLint available = 0;
+            ogGetQueryObjectiv()(samples.back().queries[1], OG_GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                break;
+            }
+        }
+
+        vector<double> gpuStartUs;
+        double gpuOffsetUs = 0.0;
+
+        for (auto& s : samples) {
+            GLuint64 t[2] = { 0, 0 };
+            ogGetQueryObjectui64v()(s.queries[0], OG_GL_QUERY_RESULT, &t[0]);
+            ogGetQueryObjectui64v()(s.queries[1], OG_GL_QUERY_RESULT, &t[1]);
+
+            freeQueries.push_back(s.queries[0]);
+            freeQueries.push_back(s.queries[1]);
+
+            s.gpuMs = (t[1] > t[0]) ? (t[1] - t[0]) * 1e-6 : 0.0;
+            s.pending = disjoint; // drop the GPU times
+
+            // align the GPU track to the submission of the first proc in the frame
+            gpuStartUs.push_back(t[0] * 1e-3);
+            if (gpuStartUs.size() == 1) {
+                gpuOffsetUs = s.cpuStartUs - gpuStartUs[0];
+            }
+        }
+
+        record(samples, pending.front().first, gpuOffsetUs, gpuStartUs);
+        pending.pop_front();
+    }
+#endif
+}
+
+void Profiler::record(const vector<Sample>& samples, int frame, double gpuOffsetUs, const vector<double>& gpuStartUs) {
+    for (size_t i = 0; i < samples.size(); i++) {
+        const Sample& s = samples[i];
+        Node& n = nodes[s.node];
+
+        addSample(n.cpuMs, s.cpuMs, maxSamples);
+        if (!s.pending) {
+            addSample(n.gpuMs, s.gpuMs, maxSamples);
+        }
+
+        if ((int)traceEvents.size() + 2 > maxTraceEvents) {
+            continue;
+        }
+
+        TraceEvent e;
+        e.node = s.node;
+        e.frame = frame;
+
+        e.gpu = false;
+        e.tsUs = s.cpuStartUs;
+        e.durUs = s.cpuMs * 1e3;
+        traceEvents.push_back(e);
+
+        if (!s.pending) {
+            e.gpu = true;
+            e.tsUs = (i < gpuStartUs.size()) ? gpuStartUs[i] + gpuOffsetUs : s.cpuStartUs;
+            e.durUs = s.gpuMs * 1e3;
+            traceEvents.push_back(e);
+        }
+    }
+}
+
+double Profiler::getTimeUs() const {
+    return chrono::duration<double, micro>(Clock::now() - epoch).count();
+}
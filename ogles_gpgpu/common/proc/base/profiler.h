@@ -0,0 +1,254 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Per-proc CPU/GPU time profiler.
+ */
+#ifndef OGLES_GPGPU_COMMON_PROC_PROFILER
+#define OGLES_GPGPU_COMMON_PROC_PROFILER
+
+#include "../../common_includes.h"
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// GPU timestamps can be queried (glQueryCounter() with GL_TIMESTAMP)?
+#if defined(OGLES_GPGPU_ANDROID) && defined(GL_EXT_disjoint_timer_query)
+#define OGLES_GPGPU_TIMER_QUERY 1
+#elif defined(OGLES_GPGPU_OPENGL) && !defined(__APPLE__) && defined(GL_TIMESTAMP)
+#define OGLES_GPGPU_TIMER_QUERY 1
+#endif
+
+namespace ogles_gpgpu {
+
+class ProcInterface;
+
+/**
+ * Timing statistics of one proc (times in milliseconds).
+ */
+struct ProfilerStats {
+    ProcInterface* proc = nullptr; // profiled proc. weak ref.
+    std::string name; // proc title or proc name
+    int count = 0; // number of samples
+    double cpuP50 = 0.0, cpuP95 = 0.0, cpuP99 = 0.0; // CPU submit time percentiles
+    double gpuP50 = 0.0, gpuP95 = 0.0, gpuP99 = 0.0; // GPU execution time percentiles
+};
+
+/**
+ * Profiler records the CPU time that is needed to submit the render commands of
+ * each proc and the GPU time that is needed to execute them. It is owned by Core
+ * and disabled by default. ProcInterface::process() calls begin() and end() around
+ * render().
+ *
+ * GPU times are measured with timestamp queries where available. The results are
+ * read back asynchronously at the end of a later frame, so that profiling does not
+ * stall the pipeline. Without timer queries, the render calls are bracketed with
+ * glFinish() and the GPU time is the wall time until the commands are finished.
+ *
+ * The last samples of each proc are aggregated to percentiles (getStats()) and
+ * all samples can be exported in the Chrome trace event format (chrome://tracing).
+ */
+class Profiler {
+public:
+    /**
+     * Constructor.
+     */
+    Profiler();
+
+    /**
+     * Deconstructor. Deletes the query objects.
+     */
+    ~Profiler();
+
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    /**
+     * Enable or disable profiling with <enabled>.
+     */
+    void setEnabled(bool enabled);
+
+    /**
+     * Returns true if profiling is enabled.
+     */
+    bool getEnabled() const {
+        return enabled;
+    }
+
+    /**
+     * Use timer queries (if supported) with <use>, else bracket with glFinish().
+     */
+    void setUseTimerQueries(bool use) {
+        useTimerQueries = use;
+    }
+
+    /**
+     * Returns true if GPU times are measured with timer queries.
+     * Must be called with a valid OpenGL context.
+     */
+    bool getUseTimerQueries() const;
+
+    /**
+     * Returns true if timer queries are supported by the current OpenGL context.
+     */
+    static bool getSupportsTimerQueries();
+
+    /**
+     * Keep the last <n> samples per proc for the percentiles.
+     */
+    void setMaxSamples(int n) {
+        maxSamples = n;
+    }
+
+    /**
+     * Record up to <n> trace events for the Chrome trace export.
+     */
+    void setMaxTraceEvents(int n) {
+        maxTraceEvents = n;
+    }
+
+    /**
+     * Start a new frame.
+     */
+    void beginFrame();
+
+    /**
+     * End a frame and collect the GPU times of finished frames.
+     */
+    void endFrame();
+
+    /**
+     * Start measuring the render() call of <proc>.
+     */
+    void begin(ProcInterface* proc);
+
+    /**
+     * Stop measuring the render() call of <proc>. Calls of begin() and end() may be
+     * nested (i.e. a proc that processes other procs in its render() call) and must
+     * be balanced.
+     */
+    void end(ProcInterface* proc);
+
+    /**
+     * Wait for all pending GPU times.
+     */
+    void flush();
+
+    /**
+     * Delete all samples and trace events. Keeps the query objects.
+     */
+    void reset();
+
+    /**
+     * Delete all samples, trace events and query objects.
+     */
+    void clear();
+
+    /**
+     * Return the number of profiled frames.
+     */
+    int getNumFrames() const {
+        return numFrames;
+    }
+
+    /**
+     * Return the statistics of all procs in the order they were first rendered.
+     */
+    std::vector<ProfilerStats> getStats() const;
+
+    /**
+     * Return the recorded samples as Chrome trace event JSON.
+     */
+    std::string getChromeTrace() const;
+
+    /**
+     * Write the Chrome trace event JSON to file <path>. Returns true on success.
+     */
+    bool writeChromeTrace(const std::string& path) const;
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Sample {
+        int node; // index into <nodes>
+        Clock::time_point startTime; // time at begin()
+        double cpuStartUs; // CPU time at begin() since <epoch>
+        double cpuMs; // CPU submit time
+        double gpuMs; // GPU execution time (if not pending)
+        GLuint queries[2]; // timestamp queries at begin() and end()
+        bool pending; // GPU time not read yet
+    };
+
+    struct Node {
+        ProcInterface* proc; // weak ref.
+        std::string name;
+        std::deque<double> cpuMs; // last CPU submit times
+        std::deque<double> gpuMs; // last GPU execution times
+    };
+
+    struct TraceEvent {
+        int node; // index into <nodes>
+        bool gpu; // GPU or CPU track
+        int frame; // frame number
+        double tsUs; // start time since <epoch>
+        double durUs; // duration
+    };
+
+    /**
+     * Return the node index of <proc>. Creates a new node if necessary.
+     */
+    int getNode(ProcInterface* proc);
+
+    /**
+     * Get a query object from the free list or create a new one.
+     */
+    GLuint acquireQuery();
+
+    /**
+     * Collect the GPU times of pending frames. If <wait> is true, all pending
+     * frames are read back, else only those that are finished.
+     */
+    void collect(bool wait);
+
+    /**
+     * Add the finished samples of frame <frame> to the statistics and trace.
+     * <gpuOffsetUs> maps GPU timestamps (converted to us) to CPU times.
+     */
+    void record(const std::vector<Sample>& samples, int frame, double gpuOffsetUs, const std::vector<double>& gpuStartUs);
+
+    /**
+     * Return the microseconds since <epoch>.
+     */
+    double getTimeUs() const;
+
+    bool enabled; // profiling enabled?
+    bool useTimerQueries; // use timer queries if supported?
+    bool inFrame; // between beginFrame() and endFrame()?
+
+    int maxSamples; // samples per node for the percentiles
+    int maxTraceEvents; // maximum number of trace events
+    int numFrames; // number of frames since reset()
+
+    Clock::time_point epoch; // reference time for the trace events
+
+    std::vector<Node> nodes; // profiled procs
+    std::unordered_map<ProcInterface*, int> nodeIndex; // proc -> index into <nodes>
+
+    std::vector<Sample> current; // samples of the current frame
+    std::vector<int> open; // indices into <current> of the unfinished (nested) render() calls
+    std::deque<std::pair<int, std::vector<Sample>>> pending; // frames with pending GPU times (frame number, samples)
+
+    std::vector<GLuint> freeQueries; // unused query objects
+    std::vector<GLuint> allQueries; // all query objects. strong refs.!
+
+    std::vector<TraceEvent> traceEvents; // recorded trace events
+};
+}
+
+#endif
@@ -0,0 +1,178 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "roiplanner.h"
+
+#include <algorithm>
+#include <cmath>
+
+BEGIN_OGLES_GPGPU
+
+void RoiPlanner::visit(ProcInterface* proc) {
+    Node& node = nodes[proc];
+    if (node.visited) {
+        return;
+    }
+    node.visited = true;
+
+    stack.push_back(proc);
+    for (auto& subscriber : proc->getSubscribers()) {
+        if (std::find(stack.begin(), stack.end(), subscriber.first) != stack.end()) {
+            // feedback loop: the output of the previous frame is read at any position
+            node.whole = true;
+            nodes[subscriber.first].whole = true;
+            continue;
+        }
+
+        visit(subscriber.first);
+    }
+    stack.pop_back();
+
+    order.push_back(proc);
+}
+
+int RoiPlanner::getConsumerHalo(int w, int h, ProcInterface* consumer, int need) {
+    // the halo of the consumer is given in its output pixels
+    const float scaleX = float(w) / float(std::max(consumer->getOutFrameW(), 1));
+    const float scaleY = float(h) / float(std::max(consumer->getOutFrameH(), 1));
+
+    int halo = int(std::ceil((need + consumer->getRoiHalo()) * std::max(scaleX, scaleY)));
+    if (scaleX != 1.0f || scaleY != 1.0f) {
+        halo += 1; // linear interpolation
+    }
+    return halo;
+}
+
+bool RoiPlanner::getIsWarping(ProcInterface* proc) {
+    const RenderOrientation o = proc->getOutputRenderOrientation();
+    return proc->getRoiHalo() < 0 || (o != RenderOrientationStd && o != RenderOrientationNone);
+}
+
+int RoiPlanner::plan(ProcInterface* root, const Rect2d& roi) {
+    assert(root);
+
+    nodes.clear();
+    order.clear();
+    stack.clear();
+
+    visit(root);
+
+    // clamp the region of interest to the input frame
+    const int inW = root->getInFrameW(), inH = root->getInFrameH();
+    const int x0 = std::max(roi.x, 0), y0 = std::max(roi.y, 0);
+    const int x1 = std::min(roi.x + roi.width, inW), y1 = std::min(roi.y + roi.height, inH);
+    const bool whole = (x1 <= x0 || y1 <= y0);
+
+    // procs after a proc that does not keep the geometry have no region of interest
+    for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        ProcInterface* proc = *it;
+        Node& node = nodes[proc];
+
+        if (getIsWarping(proc)) {
+            node.warped = true;
+        }
+
+        if (node.warped) {
+            for (auto& subscriber : proc->getSubscribers()) {
+                nodes[subscriber.first].warped = true;
+            }
+        }
+    }
+
+    // collect the halo that is read by the subscribers (which come first in <order>)
+    for (auto proc : order) {
+        Node& node = nodes[proc];
+        node.whole = node.whole || node.warped;
+
+        for (auto& subscriber : proc->getSubscribers()) {
+            ProcInterface* consumer = subscriber.first;
+            const Node& consumerNode = nodes[consumer];
+            if (consumerNode.whole) {
+                node.whole = true; // the whole input is read
+                break;
+            }
+
+            const int need = getConsumerHalo(proc->getOutFrameW(), proc->getOutFrameH(), consumer, consumerNode.need);
+            node.need = std::max(node.need, need);
+        }
+    }
+
+    int numRestricted = 0;
+    for (auto& it : nodes) {
+        ProcInterface* proc = it.first;
+        const Node& node = it.second;
+
+        if (whole || node.whole) {
+            proc->setRoi(Rect2d());
+            continue;
+        }
+
+        // scale the region of interest to the output frame and add the halo
+        const int outW = proc->getOutFrameW(), outH = proc->getOutFrameH();
+        const float scaleX = float(outW) / float(inW), scaleY = float(outH) / float(inH);
+        const int outX0 = std::max(int(std::floor(x0 * scaleX)) - node.need, 0);
+        const int outY0 = std::max(int(std::floor(y0 * scaleY)) - node.need, 0);
+        const int outX1 = std::min(int(std::ceil(x1 * scaleX)) + node.need, outW);
+        const int outY1 = std::min(int(std::ceil(y1 * scaleY)) + node.need, outH);
+
+        if (outX0 == 0 && outY0 == 0 && outX1 == outW && outY1 == outH) {
+            proc->setRoi(Rect2d()); // covers the whole frame
+            continue;
+        }
+
+        proc->setRoi(Rect2d(outX0, outY0, outX1 - outX0, outY1 - outY0));
+        numRestricted++;
+    }
+
+    OG_LOGINF("RoiPlanner", "%d of %d procs restricted to the region of interest", numRestricted, (int)nodes.size());
+
+    return numRestricted;
+}
+
+int RoiPlanner::getHalo(ProcInterface* root, ProcInterface* output) {
+    assert(root && output);
+
+    nodes.clear();
+    order.clear();
+    stack.clear();
+
+    visit(root);
+
+    // collect the halo on all paths to the output proc (subscribers come first in <order>)
+    for (auto proc : order) {
+        Node& node = nodes[proc];
+        node.reaches = (proc == output);
+
+        for (auto& subscriber : proc->getSubscribers()) {
+            ProcInterface* consumer = subscriber.first;
+            const Node& consumerNode = nodes[consumer];
+            if (!consumerNode.reaches) {
+                continue; // not needed for the output
+            }
+
+            node.reaches = true;
+            if (consumerNode.whole) {
+                node.whole = true;
+            } else {
+                const int need = getConsumerHalo(proc->getOutFrameW(), proc->getOutFrameH(), consumer, consumerNode.need);
+                node.need = std::max(node.need, need);
+            }
+        }
+
+        if (node.reaches && getIsWarping(proc)) {
+            node.whole = true;
+        }
+    }
+
+    const Node& rootNode = nodes[root];
+    if (!rootNode.reaches || rootNode.whole) {
+        return -1;
+    }
+
+    return getConsumerHalo(root->getInFrameW(), root->getInFrameH(), root, rootNode.need);
+}
+
+END_OGLES_GPGPU
@@ -0,0 +1,83 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Region of interest planner for filter graphs.
+ */
+#ifndef OGLES_GPGPU_COMMON_PROC_ROIPLANNER
+#define OGLES_GPGPU_COMMON_PROC_ROIPLANNER
+
+#include "../../common_includes.h"
+
+#include "procinterface.h"
+
+#include <map>
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+/**
+ * RoiPlanner restricts the procs of a filter graph (see ProcInterface::add()) to a region
+ * of interest of the input frame (see ProcInterface::setRoi()). The region is scaled to
+ * the output size of each proc and padded with the halo that its subscribers read around
+ * their own region (see ProcInterface::getRoiHalo()), so that the outputs inside the
+ * region are the same as for the whole frame.
+ *
+ * Procs that do not keep the geometry of their input (an output pixel may depend on any
+ * input pixel, or the render orientation is not RenderOrientationStd), procs in feedback
+ * loops, all procs that follow them and all procs whose output they read render the
+ * whole frame.
+ */
+class RoiPlanner {
+public:
+    /**
+     * Restrict the filter graph that starts at <root> to the region of interest <roi>
+     * of the input frame of <root> (in input pixels). An empty <roi> renders the whole
+     * frame. Must be called after the graph was prepared. Returns the number of procs
+     * that render a part of their output frame.
+     */
+    int plan(ProcInterface* root, const Rect2d& roi);
+
+    /**
+     * Return the halo (in input pixels of <root>) that is read around an input pixel to
+     * render the corresponding output pixel of <output>, or -1 if an output pixel of
+     * <output> may depend on any input pixel. Must be called after the graph was prepared.
+     */
+    int getHalo(ProcInterface* root, ProcInterface* output);
+
+private:
+    struct Node {
+        bool visited = false; // processing order known?
+        bool warped = false; // output does not keep the geometry of the graph input
+        bool whole = false; // renders the whole frame
+        bool reaches = false; // output is read (indirectly) by the output proc (see getHalo())
+        int need = 0; // halo (in output pixels) that is read by the subscribers
+    };
+
+    /**
+     * Find the processing order of <proc> and all of its subscribers.
+     */
+    void visit(ProcInterface* proc);
+
+    /**
+     * Return the halo in pixels of an output frame of size <w>x<h> that is read by <consumer>
+     * (which reads this frame) to render its region padded by <need>.
+     */
+    static int getConsumerHalo(int w, int h, ProcInterface* consumer, int need);
+
+    /**
+     * Returns true if the output of <proc> does not keep the geometry of its input.
+     */
+    static bool getIsWarping(ProcInterface* proc);
+
+    std::map<ProcInterface*, Node> nodes; // all procs of the graph
+    std::vector<ProcInterface*> order; // procs after all of their subscribers
+    std::vector<ProcInterface*> stack; // procs in the current processing path
+};
+
+END_OGLES_GPGPU
+
+#endif // OGLES_GPGPU_COMMON_PROC_ROIPLANNER
@@ -16,14 +16,22 @@ include(sugar_files)
 
 sugar_files(
     OGLES_GPGPU_SRCS
+    filterfusion.cpp
+    filterfusion.h
     filterprocbase.cpp
     filterprocbase.h
+    memoryplanner.cpp
+    memoryplanner.h
     multipassproc.cpp
     multipassproc.h
     procbase.cpp
     procbase.h
+    profiler.cpp
+    profiler.h
     procinterface.cpp
     procinterface.h
+    roiplanner.cpp
+    roiplanner.h
     multiprocinterface.cpp
     multiprocinterface.h
     )
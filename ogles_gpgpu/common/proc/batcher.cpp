@@ -0,0 +1,167 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "batcher.h"
+#include "base/roiplanner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+BEGIN_OGLES_GPGPU
+
+Batcher::Batcher(void* glContext)
+    : video(glContext) {
+}
+
+void Batcher::set(ProcInterface* r, ProcInterface* o) {
+    root = r;
+    outputProc = o;
+    imageSize = Size2d(); // find the halo again
+    video.set(root);
+    video.setOutput(outputProc, [this](const Size2d& size, const void* pixels, size_t rowStride) {
+        onOutput(size, pixels, rowStride);
+    });
+}
+
+bool Batcher::operator()(const Size2d& size, const std::vector<const void*>& images, size_t rowStride, GLenum inputPixFormat) {
+    assert(root && outputProc);
+
+    crops.clear();
+    numAtlases = 0;
+
+    if (inputPixFormat == 0) {
+        OG_LOGERR("Batcher", "YUV input can not be batched");
+        return false;
+    }
+
+    if (images.empty()) {
+        return true;
+    }
+
+    // the halo and the output scale of the graph are found for a single image
+    if (size != imageSize) {
+        video.configure(size, inputPixFormat);
+        halo = RoiPlanner().getHalo(root, outputProc);
+        outputScaleX = float(outputProc->getOutFrameW()) / float(size.width);
+        outputScaleY = float(outputProc->getOutFrameH()) / float(size.height);
+        imageSize = size;
+    }
+
+    if (halo < 0) {
+        OG_LOGERR("Batcher", "the output of %s depends on the whole input", outputProc->getProcName());
+        return false;
+    }
+
+    usedGutter = (gutter < 0) ? halo : gutter;
+
+    // cells of a downscaled output start at multiples of the scale factor
+    const int align = std::max(std::max(int(std::round(1.f / outputScaleX)), int(std::round(1.f / outputScaleY))), 1);
+
+    // otherwise the output samples of an image in the atlas are shifted against those of the image alone
+    if (size.width % align || size.height % align) {
+        OG_LOGERR("Batcher", "image size %dx%d must be a multiple of the output scale 1/%d", size.width, size.height, align);
+        return false;
+    }
+
+    cellOffset = (usedGutter + align - 1) / align * align;
+    cellSize.width = (size.width + 2 * cellOffset + align - 1) / align * align;
+    cellSize.height = (size.height + 2 * cellOffset + align - 1) / align * align;
+
+    GLint maxTexSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexSize);
+    const int limit = (maxAtlasSize > 0) ? std::min(maxAtlasSize, int(maxTexSize)) : int(maxTexSize);
+
+    const int maxColumns = limit / cellSize.width, maxRows = limit / cellSize.height;
+    if (maxColumns == 0 || maxRows == 0) {
+        OG_LOGERR("Batcher", "image size %dx%d with a gutter of %d pixels exceeds the atlas size %d", size.width, size.height, usedGutter, limit);
+        return false;
+    }
+
+    // an atlas is about square (all atlases of a batch have the same size)
+    const int numImages = int(images.size());
+    columns = std::min(int(std::ceil(std::sqrt(float(numImages)))), maxColumns);
+    const int rows = std::min((numImages + columns - 1) / columns, maxRows);
+    imagesPerAtlas = columns * rows;
+
+    atlasSize = Size2d(columns * cellSize.width, rows * cellSize.height);
+    atlas.resize(size_t(atlasSize.width) * atlasSize.height * 4);
+    video.configure(atlasSize, inputPixFormat);
+
+    outputSize = Size2d(outputProc->getOutFrameW(), outputProc->getOutFrameH());
+    numAtlases = (numImages + imagesPerAtlas - 1) / imagesPerAtlas;
+    outputs.resize(numAtlases);
+
+    const size_t inputRowStride = (rowStride > 0) ? rowStride : size_t(size.width) * 4;
+    const int outW = int(std::round(size.width * outputScaleX)), outH = int(std::round(size.height * outputScaleY));
+
+    for (int a = 0; a < numAtlases; a++) {
+        const int first = a * imagesPerAtlas, last = std::min(first + imagesPerAtlas, numImages);
+        for (int i = first; i < last; i++) {
+            const int x = ((i - first) % columns) * cellSize.width, y = ((i - first) / columns) * cellSize.height;
+            fillCell(x, y, static_cast<const unsigned char*>(images[i]), inputRowStride);
+
+            const int outX = int(std::round((x + cellOffset) * outputScaleX));
+            const int outY = int(std::round((y + cellOffset) * outputScaleY));
+            crops.emplace_back(outX, outY, outW, outH);
+        }
+
+        pendingAtlases.push_back(a);
+        video({ atlasSize, atlas.data(), true, 0, inputPixFormat });
+    }
+
+    // deliver the atlases in flight
+    video.flush();
+
+    return true;
+}
+
+void Batcher::fillCell(int x, int y, const unsigned char* src, size_t rowStride) {
+    const int right = cellSize.width - cellOffset - imageSize.width;
+    for (int row = 0; row < cellSize.height; row++) {
+        // gutter rows replicate the first or the last row of the image
+        const int srcRow = std::min(std::max(row - cellOffset, 0), imageSize.height - 1);
+        const unsigned char* s = src + srcRow * rowStride;
+        unsigned char* d = &atlas[(size_t(y + row) * atlasSize.width + x) * 4];
+
+        for (int i = 0; i < cellOffset; i++, d += 4) {
+            memcpy(d, s, 4);
+        }
+        memcpy(d, s, size_t(imageSize.width) * 4);
+        d += imageSize.width * 4;
+        for (int i = 0; i < right; i++, d += 4) {
+            memcpy(d, s + (imageSize.width - 1) * 4, 4);
+        }
+    }
+}
+
+void Batcher::onOutput(const Size2d& size, const void* pixels, size_t rowStride) {
+    assert(!pendingAtlases.empty());
+
+    std::vector<unsigned char>& out = outputs[pendingAtlases.front()];
+    pendingAtlases.pop_front();
+
+    out.resize(size_t(size.width) * size.height * 4);
+    const unsigned char* src = static_cast<const unsigned char*>(pixels);
+    for (int y = 0; y < size.height; y++) {
+        memcpy(&out[size_t(y) * size.width * 4], src + y * rowStride, size_t(size.width) * 4);
+    }
+}
+
+Batcher::View Batcher::getResult(int index) const {
+    assert(index >= 0 && index < int(crops.size()));
+
+    const Rect2d& crop = crops[index];
+    const std::vector<unsigned char>& out = outputs[getAtlasIndex(index)];
+
+    View view;
+    view.pixels = &out[(size_t(crop.y) * outputSize.width + crop.x) * 4];
+    view.size = Size2d(crop.width, crop.height);
+    view.rowStride = size_t(outputSize.width) * 4;
+    return view;
+}
+
+END_OGLES_GPGPU
@@ -0,0 +1,195 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Batched processing of many small images in a texture atlas.
+ */
+#ifndef OGLES_GPGPU_COMMON_BATCHER
+#define OGLES_GPGPU_COMMON_BATCHER
+
+#include "../common_includes.h"
+#include "video.h"
+
+#include <deque>
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+/**
+ * Batcher processes many images of the same size with a filter graph in one pass. The
+ * images are packed into the cells of an atlas texture (in rows, as the levels of a
+ * PyramidProc are packed into its output) and each cell is padded by a gutter that is
+ * filled with the replicated border pixels of its image. The output of the output proc
+ * is read back once per atlas and each image's result is returned as a view into it.
+ *
+ * By default the gutter is the halo of the graph (see RoiPlanner::getHalo()), so output
+ * pixels are not influenced by neighbouring images. Pixels that are farther than the
+ * halo from the image border are the same as for processing the image alone; closer to
+ * the border, the replicated gutter is an approximation for chained filters (each filter
+ * processed alone clamps its own input instead of the graph input). If the graph
+ * downscales the output, the image size must be a multiple of the scale factor, so that
+ * the output samples of each image are the same as in the atlas.
+ *
+ * If the images do not fit into one atlas of at most GL_MAX_TEXTURE_SIZE (or a given
+ * size), several atlases of the same size are processed, so the graph is prepared once.
+ */
+class Batcher {
+public:
+    /**
+     * Result of one image: its output pixels in the output of its atlas.
+     */
+    struct View {
+        const unsigned char* pixels = nullptr; // first pixel (4 bytes per pixel)
+        Size2d size; // output size of the image
+        size_t rowStride = 0; // bytes per row of <pixels>
+    };
+
+    /**
+     * Constructor. Processing is done by a VideoSource in the current OpenGL context
+     * or in <glContext> (see VideoSource::init()).
+     */
+    Batcher(void* glContext = nullptr);
+
+    /**
+     * Set the filter graph that starts at <root>. The output of <output> is read back.
+     */
+    void set(ProcInterface* root, ProcInterface* output);
+
+    /**
+     * Set the gutter around each image in input pixels. With -1 (default), the gutter is
+     * the halo of the filter graph.
+     */
+    void setGutter(int g) {
+        gutter = g;
+    }
+
+    /**
+     * Get the gutter (-1 for the halo of the filter graph).
+     */
+    int getGutter() const {
+        return gutter;
+    }
+
+    /**
+     * Limit the atlas to <size>x<size> pixels. With 0 (default), the limit is
+     * GL_MAX_TEXTURE_SIZE.
+     */
+    void setMaxAtlasSize(int size) {
+        maxAtlasSize = size;
+    }
+
+    /**
+     * Get the atlas size limit (0 for GL_MAX_TEXTURE_SIZE).
+     */
+    int getMaxAtlasSize() const {
+        return maxAtlasSize;
+    }
+
+    /**
+     * Process the images <images> of size <size> with <rowStride> bytes per row (0: tightly
+     * packed) and the 4 channel pixel format <inputPixFormat>. Returns false if the images
+     * can not be batched for the filter graph.
+     */
+    bool operator()(const Size2d& size, const std::vector<const void*>& images, size_t rowStride = 0, GLenum inputPixFormat = DFLT_PIX_FORMAT);
+
+    /**
+     * Get the number of images of the last batch.
+     */
+    int getNumImages() const {
+        return int(crops.size());
+    }
+
+    /**
+     * Get the result of image <index> of the last batch. The view is valid until the next
+     * batch is processed.
+     */
+    View getResult(int index) const;
+
+    /**
+     * Get the output region of each image in the output of its atlas (see getAtlasIndex()).
+     */
+    const std::vector<Rect2d>& getCrops() const {
+        return crops;
+    }
+
+    /**
+     * Get the index of the atlas that contains image <index>.
+     */
+    int getAtlasIndex(int index) const {
+        return index / imagesPerAtlas;
+    }
+
+    /**
+     * Get the size of the atlases of the last batch (in input pixels).
+     */
+    const Size2d& getAtlasSize() const {
+        return atlasSize;
+    }
+
+    /**
+     * Get the number of atlases of the last batch.
+     */
+    int getNumAtlases() const {
+        return numAtlases;
+    }
+
+    /**
+     * Get the gutter (in input pixels) of the last batch.
+     */
+    int getUsedGutter() const {
+        return usedGutter;
+    }
+
+    /**
+     * Get the VideoSource that processes the atlases (i.e. to set its options).
+     */
+    VideoSource& getVideoSource() {
+        return video;
+    }
+
+private:
+    /**
+     * Copy image <src> with <rowStride> bytes per row to the atlas cell at <x>,<y> and
+     * fill the gutter of the cell with its replicated border pixels.
+     */
+    void fillCell(int x, int y, const unsigned char* src, size_t rowStride);
+
+    /**
+     * Copy the output of the oldest pending atlas.
+     */
+    void onOutput(const Size2d& size, const void* pixels, size_t rowStride);
+
+    VideoSource video;
+    ProcInterface* root = nullptr; // first proc of the filter graph. weak ref.
+    ProcInterface* outputProc = nullptr; // weak ref.
+
+    int gutter = -1;
+    int maxAtlasSize = 0;
+
+    Size2d imageSize; // input size of each image
+    Size2d cellSize; // image size incl. the gutters on both sides
+    int cellOffset = 0; // position of the image in its cell
+    int columns = 0;
+    int imagesPerAtlas = 1;
+
+    Size2d atlasSize;
+    int numAtlases = 0;
+    int halo = 0; // halo of the graph for <imageSize>
+    float outputScaleX = 1.f, outputScaleY = 1.f; // output size / input size of an image
+    int usedGutter = 0;
+
+    std::vector<unsigned char> atlas; // input pixels of the current atlas
+
+    std::deque<int> pendingAtlases; // atlases in flight (in order of processing)
+
+    std::vector<std::vector<unsigned char>> outputs; // output pixels of each atlas
+    Size2d outputSize; // output size of an atlas
+    std::vector<Rect2d> crops;
+};
+
+END_OGLES_GPGPU
+
+#endif // OGLES_GPGPU_COMMON_BATCHER
@@ -44,7 +44,7 @@ int Disp::render(int position) {
     OG_LOGINF(getProcName(), "input tex %d, target %d, framebuffer of size %dx%d", texId, texTarget, outFrameW, outFrameH);
 
     filterRenderPrepare();
-    glViewport(0, 0, outFrameW * resolutionX, outFrameH * resolutionY); // override
+    getGLState().viewport(0, 0, outFrameW * resolutionX, outFrameH * resolutionY); // override
     Tools::checkGLErr(getProcName(), "render prepare");
 
     filterRenderSetCoords();
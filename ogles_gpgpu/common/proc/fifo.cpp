@@ -77,11 +77,26 @@ FifoProc::~FifoProc() {
     procPasses.clear();
 }
 
+void FifoProc::setCore(Core* c) {
+    ProcInterface::setCore(c);
+    for (auto& it : procPasses) {
+        it->setCore(c);
+    }
+}
+
 void FifoProc::addWithDelay(ProcInterface* filter, int position, int time) {
     assert(time >= 0 && time < size());
     delayedSubscribers[time].emplace_back(filter, position);
 }
 
+std::vector<std::pair<ProcInterface*, int>> FifoProc::getSubscribers() const {
+    auto result = ProcInterface::getSubscribers();
+    for (auto& it : delayedSubscribers) {
+        result.insert(result.end(), it.begin(), it.end());
+    }
+    return result;
+}
+
 void FifoProc::prepare(int inW, int inH, int index, int position) {
     assert(position == 0);
     ProcInterface::prepare(inW, inH, index, position);
@@ -89,6 +104,7 @@ void FifoProc::prepare(int inW, int inH, int index, int position) {
     for (int i = 0; i < delayedSubscribers.size(); i++) {
         for (auto& subscriber : delayedSubscribers[i]) {
             // At startup we have to initialize with our main processor output
+            shareCore(subscriber.first);
             subscriber.first->prepare(getOutFrameW(), getOutFrameH(), index + 1, subscriber.second);
             subscriber.first->useTexture(getOutputTexId(), getTextureUnit(), GL_TEXTURE_2D, subscriber.second);
         }
@@ -136,7 +152,7 @@ ProcInterface* FifoProc::getOutputFilter() const {
 #pragma mark ProcInterface methods
 
 int FifoProc::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
-    m_inputIndex = m_outputIndex = m_count = 0;
+    m_inputIndex = m_outputIndex = m_count = m_numCopies = 0;
     int num = 0;
     for (auto& it : procPasses) {
         num += it->init(inW, inH, num, prepareForExternalInput);
@@ -145,7 +161,7 @@ int FifoProc::init(int inW, int inH, unsigned int order, bool prepareForExternal
 }
 
 int FifoProc::reinit(int inW, int inH, bool prepareForExternalInput) {
-    m_inputIndex = m_outputIndex = m_count = 0;
+    m_inputIndex = m_outputIndex = m_count = m_numCopies = 0;
     int num = 0;
     for (auto& it : procPasses) {
         num += it->reinit(inW, inH, prepareForExternalInput);
@@ -157,12 +173,33 @@ void FifoProc::cleanup() {
     for (auto& it : procPasses) {
         it->cleanup();
     }
+
+    m_slotTextures.clear();
+    m_spareTex = 0;
 }
 
 void FifoProc::createFBOTex(bool genMipmap) {
     for (auto& it : procPasses) {
         it->createFBOTex(genMipmap);
     }
+
+    m_slotTextures.clear();
+    m_spareTex = 0;
+
+    if (m_producer) {
+        const int w = getOutFrameW(), h = getOutFrameH();
+        if (m_producer->getOutFrameW() != w || m_producer->getOutFrameH() != h) {
+            OG_LOGERR(getProcName(), "producer output size differs from the slot size, input frames will be copied");
+            return;
+        }
+
+        // the slots and the producer share the textures of the pool (plus a spare texture for the next frame)
+        for (auto& it : procPasses) {
+            static_cast<ProcBase*>(it)->setOutputTex(m_slotTextures.acquire(w, h));
+        }
+        m_spareTex = m_slotTextures.acquire(w, h);
+        m_producer->setOutputTex(m_spareTex);
+    }
 }
 
 // 0 : [0][ ][ ]
@@ -195,7 +232,19 @@ int FifoProc::render(int position) {
         m_outputIndex = modulo(m_inputIndex + 1, size());
     }
 
-    getInputFilter()->render();
+    auto input = static_cast<ProcBase*>(getInputFilter());
+    if (m_spareTex && input->getInputTexId() == m_spareTex) {
+        // the producer rendered into the spare texture: it becomes the input slot, and the
+        // texture of the input slot (the dropped frame) is the render target for the next frame
+        // (the producer keeps its output until then, so it can still be read)
+        const GLuint slotTex = input->getOutputTexId();
+        input->setOutputTex(m_spareTex);
+        m_spareTex = slotTex;
+        m_producer->setNextOutputTex(m_spareTex);
+    } else {
+        input->render();
+        m_numCopies++;
+    }
 
     m_count = std::min(m_count + 1, int(size()));
     m_inputIndex = modulo(m_inputIndex + 1, size());
@@ -223,3 +272,11 @@ void FifoProc::setOutputSize(int outW, int outH) {
         it->setOutputSize(outW, outH);
     }
 }
+
+// All slots store the same region
+void FifoProc::setRoi(const Rect2d& roi) {
+    ProcInterface::setRoi(roi);
+    for (auto& it : procPasses) {
+        it->setRoi(roi);
+    }
+}
@@ -12,9 +12,12 @@
 #include "../common_includes.h"
 #include "base/multiprocinterface.h"
 #include "ogles_gpgpu/common/gl/fbo.h"
+#include "ogles_gpgpu/common/gl/texture_pool.h"
 
 BEGIN_OGLES_GPGPU
 
+class ProcBase;
+
 class FifoProc : public MultiProcInterface {
 public:
     FifoProc(int size = 2);
@@ -26,6 +29,7 @@ public:
     virtual const char* getProcName() {
         return "FifoProc";
     }
+    virtual void setCore(Core* c);
     virtual void createFBOTex(bool genMipmap);
     virtual int render(int position = 0);
     virtual void useTexture(GLuint id, GLuint useTexUnit = 1, GLenum target = GL_TEXTURE_2D, int position = 0);
@@ -37,6 +41,7 @@ public:
     }
     virtual void setOutputSize(float scaleFactor);
     virtual void setOutputSize(int outW, int outH);
+    virtual void setRoi(const Rect2d& roi);
 
     virtual ProcInterface* getInputFilter() const;
     virtual ProcInterface* getOutputFilter() const;
@@ -50,6 +55,11 @@ public:
 
     virtual void addWithDelay(ProcInterface* filter, int position = 0, int time = 0);
 
+    /**
+     * Return all subscribers including the delayed ones.
+     */
+    virtual std::vector<std::pair<ProcInterface*, int>> getSubscribers() const;
+
     /**
      * Return te list of processor instances of each pass of this multipass processor.
      */
@@ -66,6 +76,33 @@ public:
         return m_count;
     }
 
+    /**
+     * Rotate the slots by texture handle instead of copying each input frame:
+     * <producer> (the input of this FIFO) renders directly into the texture of
+     * the next slot. The output texture of <producer> is the newest slot until
+     * <producer> renders the next frame, so its output can still be read (i.e.
+     * as the output of a VideoSource). An input that is not rendered into the
+     * next slot is copied. nullptr restores the copy mode. Must be called
+     * before prepare().
+     */
+    void setProducer(ProcBase* producer) {
+        m_producer = producer;
+    }
+
+    /**
+     * Get the producer that renders into the slots (nullptr in copy mode).
+     */
+    ProcBase* getProducer() const {
+        return m_producer;
+    }
+
+    /**
+     * Return the number of input frames that were copied into a slot.
+     */
+    int getNumCopies() const {
+        return m_numCopies;
+    }
+
 protected:
     virtual void prepare(int inW, int inH, int index = 0, int position = 0);
     virtual void process(int position, Logger logger = {});
@@ -78,6 +115,11 @@ protected:
     std::vector<std::vector<FilterTarget>> delayedSubscribers;
 
     std::vector<ProcInterface*> procPasses; // holds all instances to the single processing passes. strong ref!
+
+    ProcBase* m_producer = nullptr; // renders into <m_spareTex> in rotation mode. weak ref.
+    TexturePool m_slotTextures; // textures of the slots and the spare texture in rotation mode
+    GLuint m_spareTex = 0; // next render target of <m_producer>
+    int m_numCopies = 0;
 };
 
 typedef FifoProc FIFOPRoc;
@@ -32,6 +32,13 @@ public:
         return "Filter3x3Proc";
     }
 
+    /**
+     * A 3x3 neighbourhood is read.
+     */
+    virtual int getRoiHalo() const {
+        return 1;
+    }
+
     /**
      * Get the fragment shader source.
      */
@@ -18,8 +18,12 @@
 #include "ixyt.h"
 #include "median.h"
 #include "nms.h"
+#include "pyramid.h"
 #include "tensor.h"
 
+#include "../core.h"
+
+#include <algorithm>
 #include <limits>
 
 BEGIN_OGLES_GPGPU
@@ -202,7 +206,9 @@ FlowPipeline::FlowPipeline(float tau, float strength, bool doGray) {
     procPasses.push_back(&m_pImpl->gaussProc);
     procPasses.push_back(&m_pImpl->flowProc);
 };
-FlowPipeline::~FlowPipeline() {}
+FlowPipeline::~FlowPipeline() {
+    procPasses.clear(); // passes are owned by m_pImpl
+}
 float FlowPipeline::getStrength() const {
     return m_pImpl->flowProc.getStrength();
 }
@@ -493,4 +499,459 @@ int Flow2Pipeline::reinit(int inW, int inH, bool prepareForExternalInput) {
     return 0;
 }
 
+// =========================================
+// ======= Pyramidal Lucas-Kanade flow ======
+// =========================================
+
+// The flow is stored in 16 bit fixed point: [u_hi u_lo v_hi v_lo] for -range..range pixels
+// clang-format off
+#define OGLES_GPGPU_FLOW_CODEC_FUNC OG_TO_STR(                                  \
+ const float range = 64.0;                                                      \
+                                                                                \
+ vec2 decode(vec4 c)                                                            \
+ {                                                                              \
+     vec2 v = (c.xz * 65280.0 + c.yw * 255.0) / 65535.0;                        \
+     return (v * 2.0 - 1.0) * range;                                            \
+ }                                                                              \
+                                                                                \
+ vec4 encode(vec2 d)                                                            \
+ {                                                                              \
+     vec2 v = floor(clamp(d / range * 0.5 + 0.5, 0.0, 1.0) * 65535.0 + 0.5);    \
+     vec2 hi = floor(v / 256.0);                                                \
+     vec2 lo = v - hi * 256.0;                                                  \
+     return vec4(hi.x, lo.x, hi.y, lo.y) / 255.0;                               \
+ }                                                                              \
+)
+// clang-format on
+
+// clang-format off
+#define OGLES_GPGPU_FLOW_FETCH_FUNC OG_TO_STR(                                  \
+ uniform vec2 uInputSize;                                                       \
+                                                                                \
+ vec4 fetch(sampler2D tex, vec2 p, vec4 rect)                                   \
+ {                                                                              \
+     p = clamp(p, rect.xy + 0.5, rect.xy + rect.zw - 0.5);                      \
+     return texture2D(tex, p / uInputSize);                                     \
+ }                                                                              \
+)
+// clang-format on
+
+// intensity and central differences of a level
+// clang-format off
+static const char* fshaderGradSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OGLES_GPGPU_FLOW_FETCH_FUNC
+OG_TO_STR(
+ uniform sampler2D uInputTex;
+ uniform vec4 uInputRect;
+ varying vec2 vTexCoord;
+
+ void main()
+ {
+     vec2 p = uInputRect.xy + vTexCoord * uInputRect.zw;
+     vec2 dx = vec2(1.0, 0.0);
+     vec2 dy = vec2(0.0, 1.0);
+     float I = fetch(uInputTex, p, uInputRect).r;
+     float Ix = (fetch(uInputTex, p + dx, uInputRect).r - fetch(uInputTex, p - dx, uInputRect).r) * 0.5;
+     float Iy = (fetch(uInputTex, p + dy, uInputRect).r - fetch(uInputTex, p - dy, uInputRect).r) * 0.5;
+     gl_FragColor = vec4(I, Ix + 0.5, Iy + 0.5, 1.0);
+ });
+// clang-format on
+
+// One Lucas-Kanade iteration of a level:
+//
+// [ A C; C B ] * [ du dv ]' = [ X Y ]' with the sums over the window of
+// A = Ix*Ix, B = Iy*Iy, C = Ix*Iy, X = Ix*e, Y = Iy*e and e = I(p) - J(p + d)
+//
+// for the previous level I (with the gradients Ix, Iy) and the current level J.
+// The flow d is initialized with the flow of this level (uFlowScale = 1), with the
+// upsampled flow of the next coarser level (uFlowScale ~ 2) or with 0 (uFlowScale = 0).
+// clang-format off
+static const char* fshaderLkSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OGLES_GPGPU_FLOW_FETCH_FUNC
+OGLES_GPGPU_FLOW_CODEC_FUNC
+OG_TO_STR(
+ uniform sampler2D uInputTex; // [I; Ix; Iy] of the previous frame
+ uniform sampler2D uCurTex;
+ uniform sampler2D uFlowTex;
+ uniform vec4 uInputRect;
+ uniform vec4 uFlowRect;
+ uniform vec2 uFlowScale;
+ uniform float uTau;
+ varying vec2 vTexCoord;
+
+ const int wSize = 3;
+
+ vec2 flowAt(vec2 p)
+ {
+     vec2 f = uFlowRect.xy + p - 0.5;
+     vec2 i = floor(f) + 0.5;
+     vec2 t = f - floor(f);
+     vec2 f00 = decode(fetch(uFlowTex, i, uFlowRect));
+     vec2 f10 = decode(fetch(uFlowTex, i + vec2(1.0, 0.0), uFlowRect));
+     vec2 f01 = decode(fetch(uFlowTex, i + vec2(0.0, 1.0), uFlowRect));
+     vec2 f11 = decode(fetch(uFlowTex, i + vec2(1.0, 1.0), uFlowRect));
+     return mix(mix(f00, f10, t.x), mix(f01, f11, t.x), t.y);
+ }
+
+ void main()
+ {
+     vec2 q = vTexCoord * uInputRect.zw;
+     vec2 d = vec2(0.0);
+     if (uFlowScale.x > 0.0) {
+         d = flowAt(q / uFlowScale) * uFlowScale;
+     }
+
+     vec2 p = uInputRect.xy + q;
+     float A = 0.0;
+     float B = 0.0;
+     float C = 0.0;
+     float X = 0.0;
+     float Y = 0.0;
+     for(int y=-wSize; y<=wSize; y++)
+     {
+         for(int x=-wSize; x<=wSize; x++)
+         {
+             vec2 o = vec2(float(x), float(y));
+             vec4 g = fetch(uInputTex, p + o, uInputRect);
+             float Ix = g.g - 0.5;
+             float Iy = g.b - 0.5;
+             float e = g.r - fetch(uCurTex, p + o + d, uInputRect).r;
+             A += Ix * Ix;
+             B += Iy * Iy;
+             C += Ix * Iy;
+             X += Ix * e;
+             Y += Iy * e;
+         }
+     }
+
+     // smaller eigenvalue of the mean tensor
+     float n = float((2 * wSize + 1) * (2 * wSize + 1));
+     float T1 = (A + B) / (2.0 * n);
+     float T2 = sqrt(4.0 * C * C + (A - B) * (A - B)) / (2.0 * n);
+     if (T1 - T2 > uTau) {
+         d += vec2(X * B - C * Y, A * Y - C * X) / (A * B - C * C);
+     }
+
+     gl_FragColor = encode(d);
+ });
+// clang-format on
+
+// clang-format off
+const char *PyramidFlowProc::fshaderFlowSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OGLES_GPGPU_FLOW_CODEC_FUNC
+OG_TO_STR(
+ varying vec2 textureCoordinate;
+ uniform sampler2D inputImageTexture;
+
+ uniform vec4 flowRect;
+ uniform vec2 flowSize;
+ uniform float strength;
+
+ void main()
+ {
+     vec2 p = flowRect.xy + textureCoordinate * flowRect.zw;
+     vec2 d = decode(texture2D(inputImageTexture, p / flowSize));
+     gl_FragColor = vec4(clamp((strength * d + 1.0) / 2.0, 0.0, 1.0), 0.0, 1.0);
+ });
+// clang-format on
+
+PyramidFlowProc::PyramidFlowProc(const PyramidProc* pyramid, int iterations, float tau, float strength)
+    : m_pyramid(pyramid)
+    , m_iterations(iterations)
+    , tau(tau)
+    , strength(strength) {
+}
+
+PyramidFlowProc::~PyramidFlowProc() {
+    releaseLevels();
+}
+
+int PyramidFlowProc::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
+    assert(m_pyramid && !m_pyramid->getLevelCrops().empty());
+
+    const Rect2d& first = m_pyramid->getLevelCrops().front();
+    FilterProcBase::setOutputSize(first.width, first.height);
+
+    int result = TwoInputProc::init(inW, inH, order, prepareForExternalInput);
+
+    createLevelShader(m_gradShader, fshaderGradSrc);
+    createLevelShader(m_lkShader, fshaderLkSrc);
+    createLevels();
+
+    return result;
+}
+
+int PyramidFlowProc::reinit(int inW, int inH, bool prepareForExternalInput) {
+    const Rect2d& first = m_pyramid->getLevelCrops().front();
+    FilterProcBase::setOutputSize(first.width, first.height);
+
+    int result = TwoInputProc::reinit(inW, inH, prepareForExternalInput);
+
+    if (!m_lkShader.shader) {
+        createLevelShader(m_gradShader, fshaderGradSrc);
+        createLevelShader(m_lkShader, fshaderLkSrc);
+    }
+    createLevels();
+
+    return result;
+}
+
+void PyramidFlowProc::cleanup() {
+    releaseLevels();
+
+    m_gradShader.shader.reset();
+    m_lkShader.shader.reset();
+
+    TwoInputProc::cleanup();
+}
+
+void PyramidFlowProc::filterShaderSetup(const char* vShaderSrc, const char* fShaderSrc, GLenum target) {
+    ProcBase::createShader(vShaderSrc, fShaderSrc, target);
+    shParamAPos = shader->getParam(ATTR, "position");
+    shParamATexCoord = shader->getParam(ATTR, "inputTextureCoordinate");
+}
+
+void PyramidFlowProc::getUniforms() {
+    FilterProcBase::getUniforms(); // the inputs are only read by the level shaders
+    shParamUInputTex = shader->getParam(UNIF, "inputImageTexture");
+    shParamUFlowRect = shader->getParam(UNIF, "flowRect");
+    shParamUFlowSize = shader->getParam(UNIF, "flowSize");
+    shParamUStrength = shader->getParam(UNIF, "strength");
+}
+
+void PyramidFlowProc::setUniforms() {
+    TwoInputProc::setUniforms();
+
+    const Rect2d& first = m_pyramid->getLevelCrops().front();
+    glUniform4f(shParamUFlowRect, float(first.x), float(first.y), float(first.width), float(first.height));
+    glUniform2f(shParamUFlowSize, float(inFrameW), float(inFrameH));
+    glUniform1f(shParamUStrength, strength);
+}
+
+void PyramidFlowProc::createLevels() {
+    releaseLevels();
+
+    // the gradients and the flow have the layout of the input pyramid
+    m_gradFBO = new FBO(core);
+    m_gradFBO->setGLTexUnit(1);
+    m_gradFBO->createAttachedTex(inFrameW, inFrameH, false);
+
+    for (auto& flowFBO : m_flowFBO) {
+        flowFBO = new FBO(core);
+        flowFBO->setGLTexUnit(1);
+        flowFBO->createAttachedTex(inFrameW, inFrameH, false);
+
+        // the fixed point flow must not be interpolated
+        glBindTexture(GL_TEXTURE_2D, flowFBO->getAttachedTexId());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    }
+
+    OG_LOGINF(getProcName(), "%d levels with %d iterations", int(m_pyramid->getLevelCrops().size()), m_iterations);
+}
+
+void PyramidFlowProc::releaseLevels() {
+    delete m_gradFBO;
+    m_gradFBO = nullptr;
+
+    for (auto& flowFBO : m_flowFBO) {
+        delete flowFBO;
+        flowFBO = nullptr;
+    }
+}
+
+void PyramidFlowProc::createLevelShader(LevelShader& levelShader, const char* fshSrc) {
+    if (core) {
+        levelShader.shader = core->getShaderCache().acquire(vshaderDefault, fshSrc);
+    } else {
+        levelShader.shader = std::make_shared<Shader>();
+        levelShader.shader->buildFromSrc(vshaderDefault, fshSrc);
+    }
+
+    assert(levelShader.shader->getProgramId() > 0);
+
+    const Shader& sh = *levelShader.shader;
+    levelShader.shParamAPos = sh.getParam(ATTR, "aPos");
+    levelShader.shParamATexCoord = sh.getParam(ATTR, "aTexCoord");
+    levelShader.shParamUInputTex = sh.getParam(UNIF, "uInputTex");
+    levelShader.shParamUInputSize = sh.getParam(UNIF, "uInputSize");
+    levelShader.shParamUInputRect = sh.getParam(UNIF, "uInputRect");
+    if (fshSrc == fshaderLkSrc) {
+        levelShader.shParamUCurTex = sh.getParam(UNIF, "uCurTex");
+        levelShader.shParamUFlowTex = sh.getParam(UNIF, "uFlowTex");
+        levelShader.shParamUFlowRect = sh.getParam(UNIF, "uFlowRect");
+        levelShader.shParamUFlowScale = sh.getParam(UNIF, "uFlowScale");
+        levelShader.shParamUTau = sh.getParam(UNIF, "uTau");
+    }
+}
+
+void PyramidFlowProc::filterRenderPrepare() {
+    GLStateCache& glState = getGLState();
+
+    const std::vector<Rect2d>& crops = m_pyramid->getLevelCrops();
+    const int levels = int(crops.size());
+    const GLuint flowUnit = texUnit + 2;
+
+    // intensity and gradients of the previous pyramid
+    texUnit2 = texUnit + 1;
+    m_gradFBO->bind();
+    for (const auto& c : crops) {
+        setLevel(m_gradShader, texId2, texUnit2, c, c);
+        drawLevel(m_gradShader);
+    }
+
+    // coarse to fine: each pass renders the flow of a level from the other flow texture
+    const GLuint gradTex = m_gradFBO->getAttachedTexId();
+    const int iterations = std::max(m_iterations, 1);
+    int src = 0;
+    for (int level = levels - 1; level >= 0; level--) {
+        for (int i = 0; i < iterations; i++) {
+            const bool isCoarse = (i == 0);
+            const Rect2d& flowRect = (isCoarse && level + 1 < levels) ? crops[level + 1] : crops[level];
+
+            float scaleX = 1.f, scaleY = 1.f;
+            if (isCoarse) {
+                scaleX = (level + 1 < levels) ? float(crops[level].width) / float(flowRect.width) : 0.f;
+                scaleY = (level + 1 < levels) ? float(crops[level].height) / float(flowRect.height) : 0.f;
+            }
+
+            m_flowFBO[1 - src]->bind();
+            setLevel(m_lkShader, gradTex, texUnit2, crops[level], crops[level]);
+
+            glState.bindTexture(texUnit, texTarget, texId);
+            glUniform1i(m_lkShader.shParamUCurTex, texUnit);
+            glState.bindTexture(flowUnit, GL_TEXTURE_2D, m_flowFBO[src]->getAttachedTexId());
+            glUniform1i(m_lkShader.shParamUFlowTex, flowUnit);
+            glUniform4f(m_lkShader.shParamUFlowRect, float(flowRect.x), float(flowRect.y), float(flowRect.width), float(flowRect.height));
+            glUniform2f(m_lkShader.shParamUFlowScale, scaleX, scaleY);
+            glUniform1f(m_lkShader.shParamUTau, tau);
+
+            drawLevel(m_lkShader);
+            src = 1 - src;
+        }
+    }
+    m_flowIndex = src;
+    m_flowFBO[src]->unbind();
+    Tools::checkGLErr(getProcName(), "render levels");
+
+    // the output shader reads the flow of the first level
+    glState.useProgram(shader->getProgramId());
+    glState.viewport(0, 0, outFrameW, outFrameH);
+    glState.bindTexture(texUnit, GL_TEXTURE_2D, m_flowFBO[m_flowIndex]->getAttachedTexId());
+    glUniform1i(shParamUInputTex, texUnit);
+}
+
+void PyramidFlowProc::setLevel(const LevelShader& levelShader, GLuint tex, GLuint unit, const Rect2d& src, const Rect2d& dst) {
+    GLStateCache& glState = getGLState();
+
+    glState.useProgram(levelShader.shader->getProgramId());
+    glState.viewport(dst.x, dst.y, dst.width, dst.height);
+    glState.bindTexture(unit, GL_TEXTURE_2D, tex);
+
+    glUniform1i(levelShader.shParamUInputTex, unit);
+    glUniform2f(levelShader.shParamUInputSize, float(inFrameW), float(inFrameH));
+    glUniform4f(levelShader.shParamUInputRect, float(src.x), float(src.y), float(src.width), float(src.height));
+}
+
+void PyramidFlowProc::drawLevel(const LevelShader& levelShader) {
+    GLStateCache& glState = getGLState();
+
+    filterRenderSetQuad(levelShader.shParamAPos, levelShader.shParamATexCoord, RenderOrientationStd);
+    filterRenderDraw();
+
+    glState.disableVertexAttribArray(levelShader.shParamAPos);
+    glState.disableVertexAttribArray(levelShader.shParamATexCoord);
+}
+
+// =========================================
+
+struct PyramidFlowPipeline::Impl {
+    Impl(int levels, int iterations, float tau, float strength, bool doGray)
+        : levels(levels)
+        , pyramidProc(levels)
+        , flowProc(&pyramidProc, iterations, tau, strength) {
+        if (!doGray) {
+            grayProc.setGrayscaleConvType(GRAYSCALE_INPUT_CONVERSION_NONE);
+        }
+
+        pyramidProc.setMode(PyramidProc::GAUSSIAN);
+
+        {
+            // the previous pyramid is delayed by the fifo
+            grayProc.add(&pyramidProc);
+            pyramidProc.add(&flowProc, 0);
+            pyramidProc.add(&fifoProc);
+            fifoProc.add(&flowProc, 1);
+        }
+    }
+
+    int levels = 4;
+
+    GrayscaleProc grayProc;
+    PyramidProc pyramidProc;
+    FifoProc fifoProc;
+    PyramidFlowProc flowProc;
+};
+
+PyramidFlowPipeline::PyramidFlowPipeline(int levels, int iterations, float tau, float strength, bool doGray) {
+    m_pImpl = std::unique_ptr<Impl>(new Impl(levels, iterations, tau, strength, doGray));
+
+    procPasses.push_back(&m_pImpl->grayProc);
+    procPasses.push_back(&m_pImpl->pyramidProc);
+    procPasses.push_back(&m_pImpl->fifoProc);
+    procPasses.push_back(&m_pImpl->flowProc);
+}
+
+PyramidFlowPipeline::~PyramidFlowPipeline() {
+    procPasses.clear(); // passes are owned by m_pImpl
+}
+
+float PyramidFlowPipeline::getStrength() const {
+    return m_pImpl->flowProc.getStrength();
+}
+
+void PyramidFlowPipeline::setIterations(int iterations) {
+    m_pImpl->flowProc.setIterations(iterations);
+}
+
+int PyramidFlowPipeline::getIterations() const {
+    return m_pImpl->flowProc.getIterations();
+}
+
+int PyramidFlowPipeline::getLevels() const {
+    return m_pImpl->levels;
+}
+
+ProcInterface* PyramidFlowPipeline::getInputFilter() const {
+    return &m_pImpl->grayProc;
+}
+
+ProcInterface* PyramidFlowPipeline::getOutputFilter() const {
+    return &m_pImpl->flowProc;
+}
+
+int PyramidFlowPipeline::render(int position) {
+    getInputFilter()->process(position);
+    return 0;
+}
+
+int PyramidFlowPipeline::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
+    getInputFilter()->prepare(inW, inH, 0, std::numeric_limits<int>::max(), 0);
+    return 0;
+}
+
+int PyramidFlowPipeline::reinit(int inW, int inH, bool prepareForExternalInput) {
+    getInputFilter()->prepare(inW, inH, 0, std::numeric_limits<int>::max(), 0);
+    return 0;
+}
+
 END_OGLES_GPGPU
@@ -27,6 +27,13 @@ public:
     virtual const char* getProcName() {
         return "FlowProc";
     }
+
+    /**
+     * A 11x11 neighbourhood is read.
+     */
+    virtual int getRoiHalo() const {
+        return 5;
+    }
     virtual void filterShaderSetup(const char* vShaderSrc, const char* fShaderSrc, GLenum target);
     virtual void getUniforms();
     virtual void setUniforms();
@@ -190,6 +197,188 @@ protected:
 typedef Flow2Pipeline FlowOptPipeline;
 //typedef FlowPipeline FlowOptPipeline;
 
+class PyramidProc;
+
+//##########################################################################
+//  PYRAMID (current)  ====================================+
+//                                                         | => LK per level => FLOW
+//  PYRAMID (previous) => [I; Ix; Iy] =====================+    (coarse to fine)
+//##########################################################################
+
+/**
+ * Coarse-to-fine Lucas-Kanade flow from the flat pyramids of the current (input 0) and
+ * the previous frame (input 1) with the level layout of <pyramid>. Starting at the
+ * coarsest level, each level is initialized with the linearly upsampled flow of the
+ * next coarser level and refined in <iterations> passes, each of which warps the
+ * current level by the flow and solves the 7x7 structure tensor of the previous level
+ * (with its gradients) for the update. Windows with a smaller eigenvalue than <tau>
+ * (of the mean tensor, for intensities in [0, 1]) are not updated.
+ *
+ * The flow between the levels is kept in 16 bit fixed point (two channels per axis,
+ * clamped to +/-64 pixels of the level), so no readback is needed. The output has the
+ * size of the first level with (strength * flow + 1) / 2 in the rg channels as the
+ * output of FlowProc, where the flow (in pixels) points from the previous to the current
+ * frame.
+ */
+class PyramidFlowProc : public TwoInputProc {
+public:
+    PyramidFlowProc(const PyramidProc* pyramid, int iterations = 3, float tau = 0.00001f, float strength = 0.0625f);
+    virtual ~PyramidFlowProc();
+    virtual const char* getProcName() {
+        return "PyramidFlowProc";
+    }
+
+    /**
+     * The flow of each pixel depends on the whole input.
+     */
+    virtual int getRoiHalo() const {
+        return -1;
+    }
+
+    virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput = false);
+    virtual int reinit(int inW, int inH, bool prepareForExternalInput = false);
+    virtual void cleanup();
+
+    virtual void filterShaderSetup(const char* vShaderSrc, const char* fShaderSrc, GLenum target);
+    virtual void getUniforms();
+    virtual void setUniforms();
+
+    /**
+     * Set the number of refinement passes per level.
+     */
+    void setIterations(int iterations) {
+        m_iterations = iterations;
+    }
+    int getIterations() const {
+        return m_iterations;
+    }
+
+    float getStrength() const {
+        return strength;
+    }
+    float getTau() const {
+        return tau;
+    }
+
+private:
+    struct LevelShader {
+        std::shared_ptr<Shader> shader; // shared program, strong ref.!
+        GLint shParamAPos;
+        GLint shParamATexCoord;
+        GLint shParamUInputTex;
+        GLint shParamUInputSize;
+        GLint shParamUInputRect;
+        GLint shParamUCurTex = -1;
+        GLint shParamUFlowTex = -1;
+        GLint shParamUFlowRect = -1;
+        GLint shParamUFlowScale = -1;
+        GLint shParamUTau = -1;
+    };
+
+    virtual const char* getFragmentShaderSource() {
+        return fshaderFlowSrc;
+    }
+    virtual const char* getVertexShaderSource() {
+        return vshaderGPUImage;
+    }
+
+    /**
+     * Render the gradients and the flow of all levels, then bind the flow of the
+     * first level as input of the output shader.
+     */
+    virtual void filterRenderPrepare();
+
+    /**
+     * Create the program <levelShader> for fragment shader <fshSrc>.
+     */
+    void createLevelShader(LevelShader& levelShader, const char* fshSrc);
+
+    /**
+     * Create the gradient and flow textures with the size of the input pyramid.
+     */
+    void createLevels();
+
+    /**
+     * Release the gradient and flow textures.
+     */
+    void releaseLevels();
+
+    /**
+     * Set up <levelShader> to render rectangle <dst> from rectangle <src> of the
+     * pyramid texture <tex> (at texture unit <unit>).
+     */
+    void setLevel(const LevelShader& levelShader, GLuint tex, GLuint unit, const Rect2d& src, const Rect2d& dst);
+
+    /**
+     * Draw the quad of the current level.
+     */
+    void drawLevel(const LevelShader& levelShader);
+
+    const PyramidProc* m_pyramid = nullptr; // level layout of the inputs. weak ref.
+    int m_iterations = 3;
+
+    LevelShader m_gradShader;
+    LevelShader m_lkShader;
+
+    FBO* m_gradFBO = nullptr; // intensity and gradients of the previous pyramid. strong ref.!
+    FBO* m_flowFBO[2] = { nullptr, nullptr }; // flow of the levels (ping-pong). strong ref.!
+    int m_flowIndex = 0; // flow texture with the flow of the first level
+
+    GLint shParamUFlowRect;
+    GLint shParamUFlowSize;
+
+    GLint shParamUTau;
+    GLfloat tau = 0.00001f;
+
+    GLint shParamUStrength;
+    GLfloat strength = 0.0625f;
+
+    static const char* fshaderFlowSrc; // fragment shader source
+};
+
+/**
+ * Pyramidal flow of the input to the previous input: both frames are reduced to a
+ * Gaussian PyramidProc with <levels> levels (the previous one is kept in a FifoProc)
+ * and a PyramidFlowProc estimates the flow from the coarsest to the first level, so
+ * that motions of up to about 2^(levels - 1) times the window radius are tracked.
+ */
+class PyramidFlowPipeline : public MultiPassProc {
+public:
+    PyramidFlowPipeline(int levels = 4, int iterations = 3, float tau = 0.00001f, float strength = 0.0625f, bool doGray = false);
+    virtual ~PyramidFlowPipeline();
+
+    virtual float getStrength() const;
+
+    /**
+     * Set the number of refinement passes per level.
+     */
+    void setIterations(int iterations);
+    int getIterations() const;
+
+    /**
+     * Get the number of pyramid levels.
+     */
+    int getLevels() const;
+
+    virtual ProcInterface* getInputFilter() const;
+    virtual ProcInterface* getOutputFilter() const;
+
+    /**
+     * Return the processors name.
+     */
+    virtual const char* getProcName() {
+        return "PyramidFlowPipeline";
+    }
+
+    virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput = false);
+    virtual int reinit(int inW, int inH, bool prepareForExternalInput = false);
+    virtual int render(int position);
+
+protected:
+    struct Impl;
+    std::unique_ptr<Impl> m_pImpl;
+};
+
 END_OGLES_GPGPU
 
 #endif // OGLES_GPGPU_COMMON_PROC_FLOW
@@ -32,6 +32,13 @@ public:
         return "GainProc";
     }
 
+    /**
+     * Point-wise filter (can be fused).
+     */
+    virtual bool getIsPointwise() const {
+        return true;
+    }
+
     /**
      * Set the gain coefficient.
      */
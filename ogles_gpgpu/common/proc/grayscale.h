@@ -49,6 +49,13 @@ public:
         return "GrayscaleProc";
     }
 
+    /**
+     * Point-wise filter (can be fused).
+     */
+    virtual bool getIsPointwise() const {
+        return true;
+    }
+
     /**
      * Make this a noop/pass-through shader.
      */
@@ -0,0 +1,361 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "histogram.h"
+#include "../common_includes.h"
+#include "../core.h"
+
+#include <sstream>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+// maximum number of pixels per slot (an RGBA8 channel counts up to 255)
+static const int kSlotPixels = 255;
+
+// maximum width of the scatter target
+static const int kMaxScatterWidth = 4096;
+
+// clang-format off
+const char *HistogramProc::vshaderScatterSrc = OG_TO_STR(
+attribute vec4 aPoint;
+uniform sampler2D uInputTex;
+uniform vec2 uInputSize;
+uniform vec2 uScatterSize;
+uniform vec4 uChannel;
+uniform float uBins;
+void main()
+{
+    // aPoint: input pixel (xy) and the first bin of its slot in the scatter target (zw)
+    float value = floor(dot(texture2D(uInputTex, (aPoint.xy + 0.5) / uInputSize), uChannel) * 255.0 + 0.5);
+    float bin = floor(value * uBins / 256.0);
+    vec2 p = (vec2(aPoint.z + bin, aPoint.w) + 0.5) / uScatterSize;
+    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+    gl_PointSize = 1.0;
+}
+);
+// clang-format on
+
+// clang-format off
+const char *HistogramProc::fshaderScatterSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision mediump float;)
+#endif
+OG_TO_STR(
+ uniform vec4 uChannel;
+
+ void main()
+ {
+     gl_FragColor = uChannel / 255.0;
+ }
+);
+// clang-format on
+
+// clang-format off
+const char *HistogramProc::fshaderReduceBodySrc = OG_TO_STR(
+ uniform sampler2D uInputTex;
+ uniform vec2 uScatterSize;
+ uniform float uBins;
+ uniform float uSlotsPerRow;
+ uniform float uNumChannels;
+ uniform vec4 uChannel;
+ varying vec2 vTexCoord;
+ uniform vec2 uSize;
+
+ vec4 encodeCount(float v)
+ {
+     vec4 b = floor(vec4(v, v / 256.0, v / 65536.0, v / 16777216.0));
+     return mod(b, 256.0) / 255.0;
+ }
+
+ void main()
+ {
+     vec2 t = floor(vTexCoord * uSize);
+     float tile = floor((t.y + 0.5) / uNumChannels);
+     float c = t.y - tile * uNumChannels;
+     vec4 mask = (uNumChannels > 1.5) ? vec4(equal(vec4(c), vec4(0.0, 1.0, 2.0, 3.0))) : uChannel;
+
+     float slot = tile * float(kSlotsPerTile);
+     float sum = 0.0;
+     for (int i = 0; i < kSlotsPerTile; i++) {
+         float row = floor((slot + 0.5) / uSlotsPerRow);
+         vec2 p = vec2((slot - row * uSlotsPerRow) * uBins + t.x, row);
+         sum += dot(floor(texture2D(uInputTex, (p + 0.5) / uScatterSize) * 255.0 + 0.5), mask);
+         slot += 1.0;
+     }
+
+     gl_FragColor = encodeCount(sum);
+});
+// clang-format on
+
+#pragma mark constructor/deconstructor
+
+HistogramProc::HistogramProc(int bins, int tilesX, int tilesY)
+    : bins(bins)
+    , tilesX(tilesX)
+    , tilesY(tilesY) {
+    assert(bins > 0 && bins <= 256);
+    assert(tilesX > 0 && tilesY > 0);
+}
+
+HistogramProc::~HistogramProc() {
+    releaseScatter();
+}
+
+#pragma mark public methods
+
+int HistogramProc::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
+    GLint vertexTexUnits = 0;
+    glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &vertexTexUnits);
+    if (vertexTexUnits < 1) {
+        OG_LOGERR(getProcName(), "no texture access in vertex shaders");
+    }
+
+    FilterProcBase::setOutputSize(bins, getNumHistograms());
+
+    createLayout(inW, inH);
+
+    int result = FilterProcBase::init(inW, inH, order, prepareForExternalInput);
+
+    // the output is not an image: read it back without swizzling
+    fbo->getMemTransfer()->setOutputPixelFormat(GL_RGBA);
+
+    createScatterShader();
+    createScatter();
+
+    return result;
+}
+
+int HistogramProc::reinit(int inW, int inH, bool prepareForExternalInput) {
+    int result = FilterProcBase::reinit(inW, inH, prepareForExternalInput);
+
+    if (createLayout(inW, inH)) {
+        shader.reset(); // recreate with the new slot count
+        filterShaderSetup(vshaderDefault, fshaderReduceSrc.c_str(), texTarget);
+        getUniforms();
+    }
+
+    createScatter();
+
+    return result;
+}
+
+void HistogramProc::cleanup() {
+    releaseScatter();
+
+    scatterShader.reset();
+
+    FilterProcBase::cleanup();
+}
+
+int HistogramProc::render(int position) {
+    OG_LOGINF(getProcName(), "input tex %d, %d points into %d slots per tile", texId, numPoints, slotsPerTile);
+
+    assert(texTarget == GL_TEXTURE_2D);
+
+    renderScatter();
+    Tools::checkGLErr(getProcName(), "render scatter");
+
+    return FilterProcBase::render(position);
+}
+
+void HistogramProc::getHistograms(std::vector<unsigned int>& counts) const {
+    FrameDelegate delegate = [&](const Size2d& size, const void* pixels, size_t rowStride) {
+        getHistograms(size, pixels, rowStride, counts);
+    };
+
+    getResultData(delegate);
+    getMemTransferObj()->flushReadback(); // in case of multiple readback buffers
+}
+
+void HistogramProc::getHistograms(const Size2d& size, const void* pixels, size_t rowStride, std::vector<unsigned int>& counts) {
+    counts.resize(size.width * size.height);
+    for (int y = 0; y < size.height; y++) {
+        const unsigned char* row = static_cast<const unsigned char*>(pixels) + y * rowStride;
+        for (int x = 0; x < size.width; x++) {
+            const unsigned char* c = row + x * 4;
+            counts[y * size.width + x] = c[0] | (c[1] << 8) | (c[2] << 16) | ((unsigned int)c[3] << 24);
+        }
+    }
+}
+
+#pragma mark private methods
+
+void HistogramProc::getUniforms() {
+    FilterProcBase::getUniforms();
+
+    shParamUScatterSize = shader->getParam(UNIF, "uScatterSize");
+    shParamUBins = shader->getParam(UNIF, "uBins");
+    shParamUSlotsPerRow = shader->getParam(UNIF, "uSlotsPerRow");
+    shParamUNumChannels = shader->getParam(UNIF, "uNumChannels");
+    shParamUChannel = shader->getParam(UNIF, "uChannel");
+    shParamUSize = shader->getParam(UNIF, "uSize");
+}
+
+void HistogramProc::setUniforms() {
+    FilterProcBase::setUniforms();
+
+    // the output pass reads the slots instead of the input
+    getGLState().bindTexture(texUnit, GL_TEXTURE_2D, scatterFBO->getAttachedTexId());
+
+    glUniform2f(shParamUScatterSize, float(scatterFBO->getTexWidth()), float(scatterFBO->getTexHeight()));
+    glUniform1f(shParamUBins, float(bins));
+    glUniform1f(shParamUSlotsPerRow, float(slotsPerRow));
+    glUniform1f(shParamUNumChannels, float(getNumChannels()));
+    glUniform4f(shParamUChannel, channel == 0, channel == 1, channel == 2, channel == 3);
+    glUniform2f(shParamUSize, float(outFrameW), float(outFrameH));
+}
+
+bool HistogramProc::createLayout(int inW, int inH) {
+    tileW = (inW + tilesX - 1) / tilesX;
+    tileH = (inH + tilesY - 1) / tilesY;
+
+    GLint maxTexSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexSize);
+    slotsPerRow = std::max(1, std::min(int(maxTexSize), kMaxScatterWidth) / bins);
+
+    const int n = (tileW * tileH + kSlotPixels - 1) / kSlotPixels;
+    if (n == slotsPerTile) {
+        return false;
+    }
+
+    slotsPerTile = n;
+
+    // the loop count of the output pass must be a constant
+    std::stringstream ss;
+#if defined(OGLES_GPGPU_OPENGLES)
+    ss << "precision highp float;\n";
+#endif
+    ss << "const int kSlotsPerTile = " << slotsPerTile << ";\n";
+    ss << fshaderReduceBodySrc;
+    fshaderReduceSrc = ss.str();
+
+    return true;
+}
+
+void HistogramProc::createScatter() {
+    const int numSlots = slotsPerTile * tilesX * tilesY;
+    const int w = std::min(numSlots, slotsPerRow) * bins;
+    const int h = (numSlots + slotsPerRow - 1) / slotsPerRow;
+
+    if (!scatterFBO) {
+        scatterFBO = new FBO(core);
+        scatterFBO->setGLTexUnit(1);
+    } else {
+        scatterFBO->destroyAttachedTex();
+    }
+
+    scatterFBO->createAttachedTex(w, h, false);
+
+    // counts must not be interpolated
+    glBindTexture(GL_TEXTURE_2D, scatterFBO->getAttachedTexId());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+    // a point per input pixel: the pixel and the first bin of its slot, tile by tile
+    std::vector<GLushort> points;
+    points.reserve(inFrameW * inFrameH * 4);
+    for (int ty = 0; ty < tilesY; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            int slot = (ty * tilesX + tx) * slotsPerTile, n = 0;
+            for (int y = ty * tileH; y < std::min((ty + 1) * tileH, inFrameH); y++) {
+                for (int x = tx * tileW; x < std::min((tx + 1) * tileW, inFrameW); x++) {
+                    points.push_back(GLushort(x));
+                    points.push_back(GLushort(y));
+                    points.push_back(GLushort((slot % slotsPerRow) * bins));
+                    points.push_back(GLushort(slot / slotsPerRow));
+
+                    if (++n == kSlotPixels) {
+                        slot++;
+                        n = 0;
+                    }
+                }
+            }
+        }
+    }
+
+    numPoints = int(points.size() / 4);
+
+    GLStateCache& glState = getGLState();
+
+    if (!pointsBuffer) {
+        glGenBuffers(1, &pointsBuffer);
+    }
+
+    glState.bindArrayBuffer(pointsBuffer);
+    glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(GLushort), &points[0], GL_STATIC_DRAW);
+    glState.bindArrayBuffer(0);
+
+    Tools::checkGLErr(getProcName(), "create scatter");
+
+    OG_LOGINF(getProcName(), "%d points, %d slots per tile, scatter target %dx%d", numPoints, slotsPerTile, w, h);
+}
+
+void HistogramProc::releaseScatter() {
+    delete scatterFBO;
+    scatterFBO = nullptr;
+
+    if (pointsBuffer) {
+        glDeleteBuffers(1, &pointsBuffer);
+        pointsBuffer = 0;
+    }
+
+    numPoints = 0;
+}
+
+void HistogramProc::createScatterShader() {
+    if (core) {
+        scatterShader = core->getShaderCache().acquire(vshaderScatterSrc, fshaderScatterSrc);
+    } else {
+        scatterShader = make_shared<Shader>();
+        scatterShader->buildFromSrc(vshaderScatterSrc, fshaderScatterSrc);
+    }
+
+    assert(scatterShader->getProgramId() > 0);
+
+    shParamScatterAPoint = scatterShader->getParam(ATTR, "aPoint");
+    shParamScatterUInputTex = scatterShader->getParam(UNIF, "uInputTex");
+    shParamScatterUInputSize = scatterShader->getParam(UNIF, "uInputSize");
+    shParamScatterUScatterSize = scatterShader->getParam(UNIF, "uScatterSize");
+    shParamScatterUChannel = scatterShader->getParam(UNIF, "uChannel");
+    shParamScatterUBins = scatterShader->getParam(UNIF, "uBins");
+}
+
+void HistogramProc::renderScatter() {
+    GLStateCache& glState = getGLState();
+
+    scatterFBO->bind();
+    glState.viewport(0, 0, scatterFBO->getTexWidth(), scatterFBO->getTexHeight());
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // all channels count
+    glClear(GL_COLOR_BUFFER_BIT);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f); // default of Core::init()
+
+    glState.useProgram(scatterShader->getProgramId());
+    glState.bindTexture(texUnit, texTarget, texId);
+    glUniform1i(shParamScatterUInputTex, texUnit);
+    glUniform2f(shParamScatterUInputSize, float(inFrameW), float(inFrameH));
+    glUniform2f(shParamScatterUScatterSize, float(scatterFBO->getTexWidth()), float(scatterFBO->getTexHeight()));
+    glUniform1f(shParamScatterUBins, float(bins));
+
+    glState.bindArrayBuffer(pointsBuffer);
+    glState.vertexAttribArray(shParamScatterAPoint, 4, GL_UNSIGNED_SHORT, GL_FALSE, 0, 0);
+
+    // each point adds 1 to its bin
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+
+    for (int c = 0; c < 4; c++) {
+        if (perChannel || c == channel) {
+            glUniform4f(shParamScatterUChannel, c == 0, c == 1, c == 2, c == 3);
+            glDrawArrays(GL_POINTS, 0, numPoints);
+        }
+    }
+
+    glDisable(GL_BLEND);
+
+    glState.disableVertexAttribArray(shParamScatterAPoint);
+    scatterFBO->unbind();
+}
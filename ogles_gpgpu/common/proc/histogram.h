@@ -0,0 +1,256 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * GPGPU histogram processor.
+ */
+#ifndef OGLES_GPGPU_COMMON_PROC_HISTOGRAM
+#define OGLES_GPGPU_COMMON_PROC_HISTOGRAM
+
+#include "../common_includes.h"
+#include "base/filterprocbase.h"
+
+#include <string>
+#include <vector>
+
+namespace ogles_gpgpu {
+
+/**
+ * HistogramProc computes intensity histograms of the input on the GPU, so that
+ * only the bins have to be read back instead of the whole frame (i.e. for
+ * exposure control or threshold selection on the output of GrayscaleProc).
+ *
+ * Each input pixel is scattered as a point into its bin of a render target with
+ * additive blending (the input is sampled in the vertex shader). An RGBA8 target
+ * can only count up to 255, so the pixels are scattered into partial histograms
+ * ("slots") of at most 255 pixels each. The output pass sums up the slots of
+ * each histogram.
+ *
+ * Either a single channel (see setChannel()) or all four channels (see
+ * setPerChannel()) are counted, optionally for each of <tilesX>x<tilesY> tiles
+ * of the input. Input values are quantized to 8 bit and mapped to <bins> bins.
+ *
+ * Output layout: one histogram per row with <bins> texels, ordered by tile
+ * (row-major, starting at the first input row) and by channel. Each texel holds
+ * the count of a bin as 32 bit integer.
+ *
+ * Requires vertex shader texture access (GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS > 0).
+ */
+class HistogramProc : public FilterProcBase {
+public:
+    /**
+     * Constructor for histograms with <bins> bins (1 to 256) for each of
+     * <tilesX>x<tilesY> tiles of the input.
+     */
+    HistogramProc(int bins = 256, int tilesX = 1, int tilesY = 1);
+
+    /**
+     * Deconstructor.
+     */
+    virtual ~HistogramProc();
+
+    /**
+     * Return the processors name.
+     */
+    virtual const char* getProcName() {
+        return "HistogramProc";
+    }
+
+    /**
+     * The output depends on the whole input.
+     */
+    virtual int getRoiHalo() const {
+        return -1;
+    }
+
+    /**
+     * Init the processor for input frames of size <inW>x<inH> which is at
+     * position <order> in the processing pipeline.
+     */
+    virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput = false);
+
+    /**
+     * Reinitialize the proc for a different input frame size of <inW>x<inH>.
+     */
+    virtual int reinit(int inW, int inH, bool prepareForExternalInput = false);
+
+    /**
+     * Cleanup processor's resources.
+     */
+    virtual void cleanup();
+
+    /**
+     * Scatter the input and render the histograms.
+     */
+    virtual int render(int position = 0);
+
+    /**
+     * Count input channel <channel> (0 = red, ..., 3 = alpha) if there is a
+     * single histogram per tile.
+     */
+    void setChannel(int channel) {
+        assert(channel >= 0 && channel < 4);
+        this->channel = channel;
+    }
+
+    /**
+     * Get the input channel that is counted.
+     */
+    int getChannel() const {
+        return channel;
+    }
+
+    /**
+     * Compute a histogram for each of the four input channels (<perChannel> is
+     * true) or only for the channel set by setChannel(). Must be called before init().
+     */
+    void setPerChannel(bool perChannel) {
+        this->perChannel = perChannel;
+    }
+
+    /**
+     * Returns true if a histogram is computed for each input channel.
+     */
+    bool getPerChannel() const {
+        return perChannel;
+    }
+
+    /**
+     * Get the number of bins.
+     */
+    int getBins() const {
+        return bins;
+    }
+
+    /**
+     * Get the number of tiles in x direction.
+     */
+    int getTilesX() const {
+        return tilesX;
+    }
+
+    /**
+     * Get the number of tiles in y direction.
+     */
+    int getTilesY() const {
+        return tilesY;
+    }
+
+    /**
+     * Get the number of histograms (tiles times channels).
+     */
+    int getNumHistograms() const {
+        return tilesX * tilesY * getNumChannels();
+    }
+
+    /**
+     * Read the output and decode the histograms to <counts>: bin b of histogram
+     * h (see getNumHistograms()) is at <counts>[h * bins + b].
+     */
+    void getHistograms(std::vector<unsigned int>& counts) const;
+
+    /**
+     * Decode the histograms from the output <pixels> of size <size> with
+     * <rowStride> bytes per row (i.e. passed to a FrameDelegate) to <counts>.
+     * The output is read back as GL_RGBA.
+     */
+    static void getHistograms(const Size2d& size, const void* pixels, size_t rowStride, std::vector<unsigned int>& counts);
+
+private:
+    /**
+     * Output size is defined by the number of histograms.
+     */
+    virtual void setOutputSize(float scaleFactor) {}
+
+    /**
+     * Get the fragment shader source.
+     */
+    virtual const char* getFragmentShaderSource() {
+        return fshaderReduceSrc.c_str();
+    }
+
+    /**
+     * Get uniform indices.
+     */
+    virtual void getUniforms();
+
+    /**
+     * Set uniforms.
+     */
+    virtual void setUniforms();
+
+    /**
+     * Get the number of histograms per tile.
+     */
+    int getNumChannels() const {
+        return perChannel ? 4 : 1;
+    }
+
+    /**
+     * Calculate the slot layout for input size <inW>x<inH>. Returns true if the
+     * number of slots per tile changed (the output shader must be recreated).
+     */
+    bool createLayout(int inW, int inH);
+
+    /**
+     * Create the scatter target and the points of the input pixels.
+     */
+    void createScatter();
+
+    /**
+     * Release the scatter target and the points.
+     */
+    void releaseScatter();
+
+    /**
+     * Create the scatter program.
+     */
+    void createScatterShader();
+
+    /**
+     * Scatter the input pixels into the slots.
+     */
+    void renderScatter();
+
+    static const char* vshaderScatterSrc; // vertex shader source of the scatter pass
+    static const char* fshaderScatterSrc; // fragment shader source of the scatter pass
+    static const char* fshaderReduceBodySrc; // fragment shader source of the output (without the slot count)
+
+    std::string fshaderReduceSrc; // fragment shader source of the output
+
+    int bins;
+    int tilesX;
+    int tilesY;
+
+    int channel = 0;
+    bool perChannel = false;
+
+    int tileW = 0, tileH = 0; // tile size in pixels (the last tiles may be smaller)
+    int slotsPerTile = 0; // number of slots per tile
+    int slotsPerRow = 0; // number of slots in a row of the scatter target
+
+    FBO* scatterFBO = nullptr; // scatter target with the slots. strong ref.!
+    GLuint pointsBuffer = 0; // array buffer with a point per input pixel
+    int numPoints = 0;
+
+    std::shared_ptr<Shader> scatterShader; // shared program, strong ref.!
+    GLint shParamScatterAPoint;
+    GLint shParamScatterUInputTex;
+    GLint shParamScatterUInputSize;
+    GLint shParamScatterUScatterSize;
+    GLint shParamScatterUChannel;
+    GLint shParamScatterUBins;
+
+    GLint shParamUScatterSize;
+    GLint shParamUBins;
+    GLint shParamUSlotsPerRow;
+    GLint shParamUNumChannels;
+    GLint shParamUChannel;
+    GLint shParamUSize;
+};
+}
+
+#endif
@@ -0,0 +1,423 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "histopyramid.h"
+#include "../common_includes.h"
+#include "../core.h"
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+// maximum number of levels (loop count of the traversal in fshaderTraverseSrc)
+static const int kMaxLevels = 16;
+
+// count encoding: 32 bit integer in the RGBA8 channels (exact up to 2^24 with highp floats)
+// clang-format off
+#define OGLES_GPGPU_HISTOPYRAMID_COUNT_FUNCS OG_TO_STR(                         \
+ float decodeCount(vec4 c)                                                      \
+ {                                                                              \
+     return dot(floor(c * 255.0 + 0.5), vec4(1.0, 256.0, 65536.0, 16777216.0)); \
+ }                                                                              \
+                                                                                \
+ vec4 encodeCount(float v)                                                      \
+ {                                                                              \
+     vec4 b = floor(vec4(v, v / 256.0, v / 65536.0, v / 16777216.0));           \
+     return mod(b, 256.0) / 255.0;                                              \
+ }                                                                              \
+)
+// clang-format on
+
+// clang-format off
+#define OGLES_GPGPU_HISTOPYRAMID_KEYPOINT_FUNC OG_TO_STR(                       \
+ uniform sampler2D uInputTex;                                                   \
+ uniform vec2 uInputSize;                                                       \
+ uniform vec4 uChannel;                                                         \
+ uniform float uThreshold;                                                      \
+                                                                                \
+ float isKeypoint(vec2 p)                                                       \
+ {                                                                              \
+     vec2 inside = step(p + 1.0, uInputSize);                                   \
+     float value = dot(texture2D(uInputTex, (p + 0.5) / uInputSize), uChannel); \
+     return (value > uThreshold) ? inside.x * inside.y : 0.0;                   \
+ }                                                                              \
+)
+// clang-format on
+
+// clang-format off
+const char *HistoPyramidProc::fshaderBaseSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OGLES_GPGPU_HISTOPYRAMID_COUNT_FUNCS
+OGLES_GPGPU_HISTOPYRAMID_KEYPOINT_FUNC
+OG_TO_STR(
+ varying vec2 vTexCoord;
+ uniform vec2 uSize;
+
+ void main()
+ {
+     vec2 p = floor(vTexCoord * uSize) * 2.0;
+     float sum = isKeypoint(p) + isKeypoint(p + vec2(1.0, 0.0)) + isKeypoint(p + vec2(0.0, 1.0)) + isKeypoint(p + vec2(1.0, 1.0));
+     gl_FragColor = encodeCount(sum);
+});
+// clang-format on
+
+// clang-format off
+const char *HistoPyramidProc::fshaderReduceSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OGLES_GPGPU_HISTOPYRAMID_COUNT_FUNCS
+OG_TO_STR(
+ uniform sampler2D uInputTex;
+ uniform vec2 uInputSize;
+ uniform vec2 uInputOffset;
+ varying vec2 vTexCoord;
+ uniform vec2 uSize;
+
+ float count(vec2 p)
+ {
+     return decodeCount(texture2D(uInputTex, (uInputOffset + p + 0.5) / uInputSize));
+ }
+
+ void main()
+ {
+     vec2 p = floor(vTexCoord * uSize) * 2.0;
+     gl_FragColor = encodeCount(count(p) + count(p + vec2(1.0, 0.0)) + count(p + vec2(0.0, 1.0)) + count(p + vec2(1.0, 1.0)));
+});
+// clang-format on
+
+// clang-format off
+const char *HistoPyramidProc::fshaderTraverseSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OGLES_GPGPU_HISTOPYRAMID_COUNT_FUNCS
+OGLES_GPGPU_HISTOPYRAMID_KEYPOINT_FUNC
+OG_TO_STR(
+ uniform sampler2D uLevelTex0;
+ uniform sampler2D uLevelTex1;
+ uniform vec2 uLevelSize0;
+ uniform vec2 uLevelSize1;
+ uniform float uBaseSize;
+ uniform float uNumLevels;
+ uniform float uCols;
+ varying vec2 vTexCoord;
+ uniform vec2 uSize;
+
+ // count at <p> in the level of size <s> (<odd> is 1.0 for odd levels), see getLevelRect()
+ float count(vec2 p, float s, float odd)
+ {
+     float first = uBaseSize / mix(4.0, 2.0, odd);
+     vec2 offset = vec2((s == first) ? 0.0 : 1.5 * first - 2.0 * s, 0.0);
+     vec4 c0 = texture2D(uLevelTex0, (offset + p + 0.5) / uLevelSize0);
+     vec4 c1 = texture2D(uLevelTex1, (offset + p + 0.5) / uLevelSize1);
+     return decodeCount(mix(c0, c1, odd));
+ }
+
+ // descend to the child of the 2x2 block at <p> that contains keypoint <k>
+ void descend(inout vec2 p, inout float k, float c0, float c1, float c2)
+ {
+     if (k < c0) {
+     } else if (k < c0 + c1) {
+         k -= c0;
+         p.x += 1.0;
+     } else if (k < c0 + c1 + c2) {
+         k -= c0 + c1;
+         p.y += 1.0;
+     } else {
+         k -= c0 + c1 + c2;
+         p += 1.0;
+     }
+ }
+
+ void main()
+ {
+     vec2 t = floor(vTexCoord * uSize);
+     float entry = floor(t.x / 2.0) + t.y * uCols;
+     float isPosition = 1.0 - mod(t.x, 2.0);
+     float total = count(vec2(0.0), 1.0, mod(uNumLevels, 2.0));
+
+     if (entry < 0.5) { // header
+         gl_FragColor = encodeCount(total * isPosition);
+         return;
+     }
+
+     float k = entry - 1.0;
+     if (k >= total) {
+         gl_FragColor = vec4(0.0);
+         return;
+     }
+
+     // top-down traversal of the pyramid
+     vec2 p = vec2(0.0);
+     float s = 1.0;
+     for (int i = 0; i < 16; i++) {
+         float level = uNumLevels - 1.0 - float(i);
+         if (level < 0.5) {
+             break;
+         }
+
+         p *= 2.0;
+         s *= 2.0;
+         float odd = mod(level, 2.0);
+         descend(p, k, count(p, s, odd), count(p + vec2(1.0, 0.0), s, odd), count(p + vec2(0.0, 1.0), s, odd));
+     }
+
+     // input pixels
+     p *= 2.0;
+     descend(p, k, isKeypoint(p), isKeypoint(p + vec2(1.0, 0.0)), isKeypoint(p + vec2(0.0, 1.0)));
+
+     if (isPosition > 0.5) {
+         gl_FragColor = vec4(mod(p.x, 256.0), floor(p.x / 256.0), mod(p.y, 256.0), floor(p.y / 256.0)) / 255.0;
+     } else {
+         vec4 value = texture2D(uInputTex, (p + 0.5) / uInputSize);
+         gl_FragColor = vec4(dot(value, uChannel), value.gba);
+     }
+});
+// clang-format on
+
+#pragma mark constructor/deconstructor
+
+HistoPyramidProc::HistoPyramidProc(int maxKeypoints, int cols)
+    : cols(cols) {
+    assert(maxKeypoints > 0 && cols > 0);
+
+    // fill the last row (entry 0 is the header)
+    rows = (maxKeypoints + cols) / cols;
+    this->maxKeypoints = rows * cols - 1;
+}
+
+HistoPyramidProc::~HistoPyramidProc() {
+    releaseLevels();
+}
+
+#pragma mark public methods
+
+int HistoPyramidProc::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
+    FilterProcBase::setOutputSize(2 * cols, rows);
+
+    int result = FilterProcBase::init(inW, inH, order, prepareForExternalInput);
+
+    // the output is not an image: read it back without swizzling
+    fbo->getMemTransfer()->setOutputPixelFormat(GL_RGBA);
+
+    createLevelShader(baseShader, fshaderBaseSrc, true);
+    createLevelShader(reduceShader, fshaderReduceSrc, false);
+    createLevels(inW, inH);
+
+    return result;
+}
+
+int HistoPyramidProc::reinit(int inW, int inH, bool prepareForExternalInput) {
+    int result = FilterProcBase::reinit(inW, inH, prepareForExternalInput);
+
+    createLevels(inW, inH);
+
+    return result;
+}
+
+void HistoPyramidProc::cleanup() {
+    releaseLevels();
+
+    baseShader.shader.reset();
+    reduceShader.shader.reset();
+
+    FilterProcBase::cleanup();
+}
+
+int HistoPyramidProc::render(int position) {
+    OG_LOGINF(getProcName(), "input tex %d, %d levels from size %dx%d", texId, numLevels, baseSize / 2, baseSize / 2);
+
+    assert(texTarget == GL_TEXTURE_2D);
+
+    for (int level = 1; level <= numLevels; level++) {
+        renderLevel(level);
+    }
+    levelFBOs[0]->unbind(); // the output pass clears the bound framebuffer
+    Tools::checkGLErr(getProcName(), "render levels");
+
+    return FilterProcBase::render(position);
+}
+
+int HistoPyramidProc::getKeypoints(std::vector<Keypoint>& keypoints) const {
+    int total = 0;
+
+    FrameDelegate delegate = [&](const Size2d& size, const void* pixels, size_t rowStride) {
+        total = getKeypoints(size, pixels, rowStride, keypoints);
+    };
+
+    getResultData(delegate);
+    getMemTransferObj()->flushReadback(); // in case of multiple readback buffers
+
+    return total;
+}
+
+int HistoPyramidProc::getKeypoints(const Size2d& size, const void* pixels, size_t rowStride, std::vector<Keypoint>& keypoints) {
+    const int entriesPerRow = size.width / 2;
+    const auto getEntry = [&](int e) {
+        return static_cast<const unsigned char*>(pixels) + (e / entriesPerRow) * rowStride + (e % entriesPerRow) * 8;
+    };
+
+    const unsigned char* header = getEntry(0);
+    const int total = int(header[0] | (header[1] << 8) | (header[2] << 16) | (header[3] << 24));
+
+    keypoints.resize(std::min(total, entriesPerRow * size.height - 1));
+    for (int k = 0; k < int(keypoints.size()); k++) {
+        const unsigned char* entry = getEntry(k + 1);
+        keypoints[k] = Keypoint(entry[0] | (entry[1] << 8), entry[2] | (entry[3] << 8), float(entry[4]) / 255.f);
+    }
+
+    return total;
+}
+
+#pragma mark private methods
+
+void HistoPyramidProc::getUniforms() {
+    FilterProcBase::getUniforms();
+
+    shParamULevelTex[0] = shader->getParam(UNIF, "uLevelTex0");
+    shParamULevelTex[1] = shader->getParam(UNIF, "uLevelTex1");
+    shParamUInputSize = shader->getParam(UNIF, "uInputSize");
+    shParamULevelSize[0] = shader->getParam(UNIF, "uLevelSize0");
+    shParamULevelSize[1] = shader->getParam(UNIF, "uLevelSize1");
+    shParamUBaseSize = shader->getParam(UNIF, "uBaseSize");
+    shParamUNumLevels = shader->getParam(UNIF, "uNumLevels");
+    shParamUCols = shader->getParam(UNIF, "uCols");
+    shParamUSize = shader->getParam(UNIF, "uSize");
+    shParamUChannel = shader->getParam(UNIF, "uChannel");
+    shParamUThreshold = shader->getParam(UNIF, "uThreshold");
+}
+
+void HistoPyramidProc::setUniforms() {
+    FilterProcBase::setUniforms();
+
+    GLStateCache& glState = getGLState();
+
+    for (int i = 0; i < 2; i++) {
+        glState.bindTexture(texUnit + 1 + i, GL_TEXTURE_2D, levelFBOs[i]->getAttachedTexId());
+        glUniform1i(shParamULevelTex[i], texUnit + 1 + i);
+        glUniform2f(shParamULevelSize[i], float(levelFBOs[i]->getTexWidth()), float(levelFBOs[i]->getTexHeight()));
+    }
+
+    glUniform2f(shParamUInputSize, float(inFrameW), float(inFrameH));
+    glUniform1f(shParamUBaseSize, float(baseSize));
+    glUniform1f(shParamUNumLevels, float(numLevels));
+    glUniform1f(shParamUCols, float(cols));
+    glUniform2f(shParamUSize, float(outFrameW), float(outFrameH));
+    glUniform4f(shParamUChannel, scoreChannel == 0, scoreChannel == 1, scoreChannel == 2, scoreChannel == 3);
+    glUniform1f(shParamUThreshold, threshold);
+}
+
+void HistoPyramidProc::createLevels(int inW, int inH) {
+    baseSize = std::max(2, int(Tools::getBiggerPOTValue(float(std::max(inW, inH)))));
+    for (numLevels = 0; (1 << numLevels) < baseSize; numLevels++) {
+    }
+
+    assert(numLevels <= kMaxLevels);
+
+    // atlas i holds the levels with (level % 2 == i) in a row: the first level at
+    // the left, the following (1/4 smaller) levels to the right of it
+    for (int i = 0; i < 2; i++) {
+        const int firstLevel = (i == 1) ? 1 : 2;
+        int w = 1, h = 1; // unused atlas
+        if (firstLevel <= numLevels) {
+            const Rect2d first = getLevelRect(firstLevel);
+            w = (firstLevel + 2 <= numLevels) ? first.width * 3 / 2 : first.width;
+            h = first.height;
+        }
+
+        if (!levelFBOs[i]) {
+            levelFBOs[i] = new FBO(core);
+            levelFBOs[i]->setGLTexUnit(1);
+        } else {
+            levelFBOs[i]->destroyAttachedTex();
+        }
+
+        levelFBOs[i]->createAttachedTex(w, h, false);
+
+        // counts must not be interpolated
+        glBindTexture(GL_TEXTURE_2D, levelFBOs[i]->getAttachedTexId());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    }
+
+    OG_LOGINF(getProcName(), "%d levels, atlases %dx%d and %dx%d", numLevels,
+        levelFBOs[1]->getTexWidth(), levelFBOs[1]->getTexHeight(),
+        levelFBOs[0]->getTexWidth(), levelFBOs[0]->getTexHeight());
+}
+
+void HistoPyramidProc::releaseLevels() {
+    for (int i = 0; i < 2; i++) {
+        delete levelFBOs[i];
+        levelFBOs[i] = nullptr;
+    }
+
+    numLevels = baseSize = 0;
+}
+
+void HistoPyramidProc::createLevelShader(LevelShader& levelShader, const char* fshSrc, bool isBase) {
+    if (core) {
+        levelShader.shader = core->getShaderCache().acquire(vshaderDefault, fshSrc);
+    } else {
+        levelShader.shader = make_shared<Shader>();
+        levelShader.shader->buildFromSrc(vshaderDefault, fshSrc);
+    }
+
+    assert(levelShader.shader->getProgramId() > 0);
+
+    const Shader& sh = *levelShader.shader;
+    levelShader.shParamAPos = sh.getParam(ATTR, "aPos");
+    levelShader.shParamATexCoord = sh.getParam(ATTR, "aTexCoord");
+    levelShader.shParamUInputTex = sh.getParam(UNIF, "uInputTex");
+    levelShader.shParamUInputSize = sh.getParam(UNIF, "uInputSize");
+    levelShader.shParamUSize = sh.getParam(UNIF, "uSize");
+    if (isBase) {
+        levelShader.shParamUChannel = sh.getParam(UNIF, "uChannel");
+        levelShader.shParamUThreshold = sh.getParam(UNIF, "uThreshold");
+    } else {
+        levelShader.shParamUInputOffset = sh.getParam(UNIF, "uInputOffset");
+    }
+}
+
+Rect2d HistoPyramidProc::getLevelRect(int level) const {
+    const int size = baseSize >> level;
+    const int first = baseSize >> ((level % 2) ? 1 : 2); // size of the first level in the atlas
+    return Rect2d((size == first) ? 0 : first * 3 / 2 - 2 * size, 0, size, size);
+}
+
+void HistoPyramidProc::renderLevel(int level) {
+    const LevelShader& levelShader = (level == 1) ? baseShader : reduceShader;
+    const Rect2d rect = getLevelRect(level);
+
+    GLStateCache& glState = getGLState();
+
+    levelFBOs[level % 2]->bind();
+    glState.useProgram(levelShader.shader->getProgramId());
+    glState.viewport(rect.x, rect.y, rect.width, rect.height);
+
+    if (level == 1) { // count the keypoints in the input
+        glState.bindTexture(texUnit, texTarget, texId);
+        glUniform2f(levelShader.shParamUInputSize, float(inFrameW), float(inFrameH));
+        glUniform4f(levelShader.shParamUChannel, scoreChannel == 0, scoreChannel == 1, scoreChannel == 2, scoreChannel == 3);
+        glUniform1f(levelShader.shParamUThreshold, threshold);
+    } else { // sum up the lower level
+        const FBO* lower = levelFBOs[(level - 1) % 2];
+        const Rect2d lowerRect = getLevelRect(level - 1);
+        glState.bindTexture(texUnit, GL_TEXTURE_2D, lower->getAttachedTexId());
+        glUniform2f(levelShader.shParamUInputSize, float(lower->getTexWidth()), float(lower->getTexHeight()));
+        glUniform2f(levelShader.shParamUInputOffset, float(lowerRect.x), float(lowerRect.y));
+    }
+
+    glUniform1i(levelShader.shParamUInputTex, texUnit);
+    glUniform2f(levelShader.shParamUSize, float(rect.width), float(rect.height));
+
+    filterRenderSetQuad(levelShader.shParamAPos, levelShader.shParamATexCoord, RenderOrientationStd);
+    filterRenderDraw();
+
+    glState.disableVertexAttribArray(levelShader.shParamAPos);
+    glState.disableVertexAttribArray(levelShader.shParamATexCoord);
+}
@@ -0,0 +1,253 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * GPGPU keypoint compaction processor (histogram pyramid).
+ */
+#ifndef OGLES_GPGPU_COMMON_PROC_HISTOPYRAMID
+#define OGLES_GPGPU_COMMON_PROC_HISTOPYRAMID
+
+#include "../common_includes.h"
+#include "base/filterprocbase.h"
+
+#include <vector>
+
+namespace ogles_gpgpu {
+
+/**
+ * Keypoint that was found by HistoPyramidProc.
+ */
+struct Keypoint {
+    Keypoint() {}
+    Keypoint(int x, int y, float score)
+        : x(x)
+        , y(y)
+        , score(score) {
+    }
+    int x = 0, y = 0; // position in the input texture
+    float score = 0.f; // input value in [0, 1] (see HistoPyramidProc::setChannel())
+};
+
+/**
+ * HistoPyramidProc compacts the sparse, non-zero pixels of a response texture
+ * (i.e. the output of NmsProc) into a small output texture, so that only a few
+ * kilobytes have to be read back instead of the whole frame.
+ *
+ * A pixel is a keypoint if the value of channel <channel> is greater than
+ * <threshold>. A histogram pyramid is built bottom-up: each texel of a level
+ * holds the number of keypoints in the 2x2 texels below it, up to the total
+ * number of keypoints at the 1x1 top. The output pass then finds the position
+ * of each keypoint by traversing the pyramid top-down.
+ *
+ * The counts are stored as 32 bit integers in RGBA8 textures. The levels are
+ * packed into two atlas textures with alternating levels, so that each
+ * reduction reads from the other atlas than it renders to.
+ *
+ * Output layout: each entry has two texels (<2 * cols> texels per row). Entry 0
+ * holds the total number of keypoints (32 bit integer in the first texel), entry
+ * k + 1 holds keypoint k: the x and y position (16 bit integers in the first
+ * texel) and the input pixel with the score in the red channel (second texel).
+ * If there are more than <maxKeypoints> keypoints, the first keypoints in the
+ * traversal order (a Z-order curve over the input) are kept.
+ */
+class HistoPyramidProc : public FilterProcBase {
+public:
+    /**
+     * Constructor for up to <maxKeypoints> keypoints in rows of <cols> entries.
+     * The capacity is rounded up to fill the last row.
+     */
+    HistoPyramidProc(int maxKeypoints = 1024, int cols = 64);
+
+    /**
+     * Deconstructor.
+     */
+    virtual ~HistoPyramidProc();
+
+    /**
+     * Return the processors name.
+     */
+    virtual const char* getProcName() {
+        return "HistoPyramidProc";
+    }
+
+    /**
+     * The output depends on the whole input.
+     */
+    virtual int getRoiHalo() const {
+        return -1;
+    }
+
+    /**
+     * Init the processor for input frames of size <inW>x<inH> which is at
+     * position <order> in the processing pipeline.
+     */
+    virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput = false);
+
+    /**
+     * Reinitialize the proc for a different input frame size of <inW>x<inH>.
+     */
+    virtual int reinit(int inW, int inH, bool prepareForExternalInput = false);
+
+    /**
+     * Cleanup processor's resources.
+     */
+    virtual void cleanup();
+
+    /**
+     * Build the pyramid and render the keypoints.
+     */
+    virtual int render(int position = 0);
+
+    /**
+     * Set the keypoint threshold: pixels with a value greater than <value> are keypoints.
+     */
+    void setThreshold(float value) {
+        threshold = value;
+    }
+
+    /**
+     * Get the keypoint threshold.
+     */
+    float getThreshold() const {
+        return threshold;
+    }
+
+    /**
+     * Use input channel <channel> (0 = red, ..., 3 = alpha) as score.
+     */
+    void setChannel(int channel) {
+        assert(channel >= 0 && channel < 4);
+        scoreChannel = channel;
+    }
+
+    /**
+     * Get the input channel that is used as score.
+     */
+    int getChannel() const {
+        return scoreChannel;
+    }
+
+    /**
+     * Get the maximum number of keypoints in the output.
+     */
+    int getMaxKeypoints() const {
+        return maxKeypoints;
+    }
+
+    /**
+     * Get the number of pyramid levels (without the input).
+     */
+    int getNumLevels() const {
+        return numLevels;
+    }
+
+    /**
+     * Read the output and decode the keypoints to <keypoints>.
+     * Returns the total number of keypoints, which might be greater than the
+     * number of returned keypoints.
+     */
+    int getKeypoints(std::vector<Keypoint>& keypoints) const;
+
+    /**
+     * Decode the keypoints from the output <pixels> of size <size> with
+     * <rowStride> bytes per row (i.e. passed to a FrameDelegate) to <keypoints>.
+     * The output is read back as GL_RGBA. Returns the total number of keypoints.
+     */
+    static int getKeypoints(const Size2d& size, const void* pixels, size_t rowStride, std::vector<Keypoint>& keypoints);
+
+private:
+    struct LevelShader {
+        std::shared_ptr<Shader> shader; // shared program, strong ref.!
+        GLint shParamAPos;
+        GLint shParamATexCoord;
+        GLint shParamUInputTex;
+        GLint shParamUInputSize;
+        GLint shParamUInputOffset = -1;
+        GLint shParamUSize;
+        GLint shParamUChannel = -1;
+        GLint shParamUThreshold = -1;
+    };
+
+    /**
+     * Output size is defined by the number of keypoints.
+     */
+    virtual void setOutputSize(float scaleFactor) {}
+
+    /**
+     * Get the fragment shader source.
+     */
+    virtual const char* getFragmentShaderSource() {
+        return fshaderTraverseSrc;
+    }
+
+    /**
+     * Get uniform indices.
+     */
+    virtual void getUniforms();
+
+    /**
+     * Set uniforms.
+     */
+    virtual void setUniforms();
+
+    /**
+     * Create the level atlases for input size <inW>x<inH>.
+     */
+    void createLevels(int inW, int inH);
+
+    /**
+     * Release the level atlases.
+     */
+    void releaseLevels();
+
+    /**
+     * Create the program <levelShader> for fragment shader <fshSrc> of the
+     * first level (<isBase> is true) or of the upper levels.
+     */
+    void createLevelShader(LevelShader& levelShader, const char* fshSrc, bool isBase);
+
+    /**
+     * Get the rectangle of level <level> (1 is the first level above the input) in its atlas.
+     */
+    Rect2d getLevelRect(int level) const;
+
+    /**
+     * Render level <level> of the pyramid.
+     */
+    void renderLevel(int level);
+
+    static const char* fshaderBaseSrc; // fragment shader source of the first level
+    static const char* fshaderReduceSrc; // fragment shader source of the upper levels
+    static const char* fshaderTraverseSrc; // fragment shader source of the output
+
+    int maxKeypoints; // capacity of the output
+    int cols; // entries per output row
+    int rows; // output rows
+
+    float threshold = 0.f;
+    int scoreChannel = 0;
+
+    int baseSize = 0; // power of two input size (pyramid levels are baseSize / 2^level)
+    int numLevels = 0; // number of levels (the last one has size 1x1)
+
+    FBO* levelFBOs[2] = { nullptr, nullptr }; // atlases with the even and odd levels. strong refs.!
+
+    LevelShader baseShader;
+    LevelShader reduceShader;
+
+    GLint shParamULevelTex[2];
+    GLint shParamUInputSize;
+    GLint shParamULevelSize[2];
+    GLint shParamUBaseSize;
+    GLint shParamUNumLevels;
+    GLint shParamUCols;
+    GLint shParamUSize;
+    GLint shParamUChannel;
+    GLint shParamUThreshold;
+};
+}
+
+#endif
@@ -22,6 +22,9 @@ public:
     virtual const char* getProcName() {
         return "Hsv2RgbProc";
     }
+    virtual bool getIsPointwise() const {
+        return true;
+    }
 
 private:
     virtual const char* getFragmentShaderSource() {
@@ -9,7 +9,6 @@
 #include "iir.h"
 #include "blend.h"
 #include "diff.h"
-#include "fifo.h"
 
 /////////////////////////////
 //          +===============+
@@ -17,7 +16,7 @@
 // INPUT ===+= IIR ===+==>(DIFF)
 //             ^     |
 //             |     |
-//           FIFO <==+
+//             +=====+ (previous output)
 /////////////////////////////
 
 BEGIN_OGLES_GPGPU
@@ -28,19 +27,16 @@ public:
     Impl(FilterKind kind, float alpha, float strength)
         : kind(kind)
         , iirProc(alpha)
-        , fifoProc(1)
         , diffProc(strength) {
-        iirProc.add(&fifoProc);
-        fifoProc.add(&iirProc, 1);
         if (kind == kHighPass) {
             iirProc.add(&diffProc, 1);
             lastProc = &diffProc; // high pass output
         }
         iirProc.setWaitForSecondTexture(false);
+        iirProc.setFeedback(true); // reads its output of the previous frame
     }
     IirFilterProc::FilterKind kind = kLowPass;
     BlendProc iirProc;
-    FIFOPRoc fifoProc;
     DiffProc diffProc;
     ProcInterface* lastProc = &iirProc; // default for low pass
 };
@@ -49,7 +45,6 @@ IirFilterProc::IirFilterProc(FilterKind kind, float alpha, float strength) {
     // All procPasses filter will be initialized by superclass:
     m_impl = std::unique_ptr<Impl>(new Impl(kind, alpha, strength));
     procPasses.push_back(&m_impl->iirProc);
-    procPasses.push_back(&m_impl->fifoProc);
     if (kind == kHighPass) {
         procPasses.push_back(&m_impl->diffProc);
     }
@@ -79,8 +74,6 @@ int IirFilterProc::render(int position) {
     // Execute internal filter chain
 
     // calls next->useTexture(); next->process();
-    // TODO: We don't really need this to call fifoProc->useTexture(),
-    // if it is done by this class (see below for special case first frame handling)
     m_impl->iirProc.process(0);
     if (m_impl->kind == kHighPass) {
         // At this point useTexture() has been called and diffProc should have:
@@ -92,7 +85,6 @@ int IirFilterProc::render(int position) {
 }
 
 void IirFilterProc::useTexture(GLuint id, GLuint useTexUnit, GLenum target, int position) {
-    auto& fifoProc = m_impl->fifoProc;
     auto& iirProc = m_impl->iirProc;
 
     if (m_impl->kind == kHighPass) {
@@ -113,16 +105,11 @@ void IirFilterProc::useTexture(GLuint id, GLuint useTexUnit, GLenum target, int
         isFirst = false;
         iirProc.useTexture(id, useTexUnit, target, 0);
         iirProc.useTexture2(id, useTexUnit, GL_TEXTURE_2D);
-
-        // FIFO input (from IIR)
-        fifoProc.useTexture(id, useTexUnit, target, 0);
     } else {
-        // Connect FIFO output to second input of IIR for frames >= 1
+        // Connect the previous IIR output to the second input of IIR for frames >= 1
+        // (the IIR renders into its other output texture, see ProcBase::setFeedback())
         iirProc.useTexture(id, useTexUnit, target, 0);
-        iirProc.useTexture2(fifoProc.getOutputTexId(), fifoProc.getTextureUnit(), GL_TEXTURE_2D);
-
-        // FIFO input (from IIR)
-        fifoProc.useTexture(iirProc.getOutputTexId(), iirProc.getTextureUnit(), GL_TEXTURE_2D, 0);
+        iirProc.useTexture2(iirProc.getOutputTexId(), iirProc.getTextureUnit(), GL_TEXTURE_2D);
     }
 }
 
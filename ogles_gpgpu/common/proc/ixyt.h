@@ -24,6 +24,9 @@ public:
     virtual const char* getProcName() {
         return "IxytProc";
     }
+    virtual int getRoiHalo() const {
+        return 1; // 3x3 neighbourhood
+    }
     virtual void getUniforms();
     virtual void setUniforms();
     virtual void setStrength(float value) {
@@ -0,0 +1,438 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "klt.h"
+#include "../common_includes.h"
+#include "../core.h"
+
+#include "fifo.h"
+#include "grayscale.h"
+#include "pyramid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+BEGIN_OGLES_GPGPU
+
+// One Lucas-Kanade iteration per point on a level:
+//
+// [ A C; C B ] * [ du dv ]' = [ X Y ]' with the sums over the window of
+// A = Ix*Ix, B = Iy*Iy, C = Ix*Iy, X = Ix*e, Y = Iy*e and e = I(a) - J(b)
+//
+// for the previous frame I (with the gradients Ix, Iy) at the start position a and
+// the current frame J at the estimated position b. The upper half of the output holds
+// the positions [x_hi x_lo y_hi y_lo] (16 bit fixed point of the image size) and the
+// lower half the status [tracked error 0 1] of the points.
+// clang-format off
+const char* KltProc::fshaderKltSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OG_TO_STR(
+ uniform sampler2D uInputTex; // current frame
+ uniform sampler2D uPrevTex;
+ uniform sampler2D uStartTex; // points at the start of the frame
+ uniform sampler2D uPointTex; // points of the previous pass
+ uniform vec2 uInputSize;
+ uniform vec4 uLevelRect;
+ uniform vec2 uLevelScale; // level size / image size
+ uniform vec2 uImageSize;
+ uniform vec2 uSize;
+ uniform float uTau;
+ uniform float uFirst;
+ uniform float uLast;
+ varying vec2 vTexCoord;
+
+ const int wSize = 7;
+
+ vec4 fetch(sampler2D tex, vec2 p)
+ {
+     p = clamp(p, uLevelRect.xy + 0.5, uLevelRect.xy + uLevelRect.zw - 0.5);
+     return texture2D(tex, p / uInputSize);
+ }
+
+ vec2 decodePoint(vec4 c)
+ {
+     return (c.xz * 65280.0 + c.yw * 255.0) / 65535.0 * uImageSize;
+ }
+
+ vec4 encodePoint(vec2 p)
+ {
+     vec2 v = floor(clamp(p / uImageSize, 0.0, 1.0) * 65535.0 + 0.5);
+     vec2 hi = floor(v / 256.0);
+     vec2 lo = v - hi * 256.0;
+     return vec4(hi.x, lo.x, hi.y, lo.y) / 255.0;
+ }
+
+ void main()
+ {
+     vec2 texel = floor(vTexCoord * uSize);
+     float rows = uSize.y * 0.5;
+     bool isStatus = texel.y >= rows;
+     texel.y = mod(texel.y, rows);
+
+     vec2 positionCoord = (texel + 0.5) / uSize;
+     vec2 statusCoord = (texel + vec2(0.5, rows + 0.5)) / uSize;
+     vec4 status = texture2D(uStartTex, statusCoord);
+     vec2 start = decodePoint(texture2D(uStartTex, positionCoord));
+     vec2 p = (uFirst > 0.5) ? start : decodePoint(texture2D(uPointTex, positionCoord));
+
+     if (status.r < 0.5) { // lost
+         gl_FragColor = isStatus ? status : encodePoint(p);
+         return;
+     }
+
+     // positions in the level (texture pixels)
+     vec2 a = uLevelRect.xy + (start + 0.5) * uLevelScale;
+     vec2 b = uLevelRect.xy + (p + 0.5) * uLevelScale;
+     vec2 dx = vec2(1.0, 0.0);
+     vec2 dy = vec2(0.0, 1.0);
+
+     float A = 0.0;
+     float B = 0.0;
+     float C = 0.0;
+     float X = 0.0;
+     float Y = 0.0;
+     float error = 0.0;
+     for(int y=-wSize; y<=wSize; y++)
+     {
+         for(int x=-wSize; x<=wSize; x++)
+         {
+             vec2 o = vec2(float(x), float(y));
+             float Ix = (fetch(uPrevTex, a + o + dx).r - fetch(uPrevTex, a + o - dx).r) * 0.5;
+             float Iy = (fetch(uPrevTex, a + o + dy).r - fetch(uPrevTex, a + o - dy).r) * 0.5;
+             float e = fetch(uPrevTex, a + o).r - fetch(uInputTex, b + o).r;
+             A += Ix * Ix;
+             B += Iy * Iy;
+             C += Ix * Iy;
+             X += Ix * e;
+             Y += Iy * e;
+             error += abs(e);
+         }
+     }
+
+     // smaller eigenvalue of the mean tensor
+     float n = float((2 * wSize + 1) * (2 * wSize + 1));
+     float T1 = (A + B) / (2.0 * n);
+     float T2 = sqrt(4.0 * C * C + (A - B) * (A - B)) / (2.0 * n);
+     bool isValid = (T1 - T2) > uTau;
+     if (isValid) {
+         b += vec2(X * B - C * Y, A * Y - C * X) / (A * B - C * C);
+         p = (b - uLevelRect.xy) / uLevelScale - 0.5;
+     }
+
+     if (uLast > 0.5) {
+         bool isInside = all(greaterThanEqual(p, vec2(0.0))) && all(lessThanEqual(p, uImageSize - 1.0));
+         status = vec4(float(isValid && isInside), error / n, 0.0, 1.0);
+     }
+
+     gl_FragColor = isStatus ? status : encodePoint(p);
+ });
+// clang-format on
+
+KltProc::KltProc(const PyramidProc* pyramid, int maxPoints, int cols)
+    : pyramid(pyramid)
+    , cols(cols) {
+    assert(maxPoints > 0 && cols > 0);
+
+    // fill the last row
+    rows = (maxPoints + cols - 1) / cols;
+    this->maxPoints = rows * cols;
+}
+
+KltProc::~KltProc() {
+    releasePointTextures();
+}
+
+int KltProc::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
+    FilterProcBase::setOutputSize(cols, 2 * rows);
+
+    int result = TwoInputProc::init(inW, inH, order, prepareForExternalInput);
+
+    // the output is not an image: read it back without swizzling
+    fbo->getMemTransfer()->setOutputPixelFormat(GL_RGBA);
+
+    createPointTextures();
+
+    return result;
+}
+
+int KltProc::reinit(int inW, int inH, bool prepareForExternalInput) {
+    int result = TwoInputProc::reinit(inW, inH, prepareForExternalInput);
+
+    createPointTextures();
+
+    return result;
+}
+
+void KltProc::cleanup() {
+    releasePointTextures();
+
+    TwoInputProc::cleanup();
+}
+
+void KltProc::setPoints(const std::vector<TrackedPoint>& p) {
+    points.assign(p.begin(), p.begin() + std::min(int(p.size()), maxPoints));
+    hasNewPoints = true;
+}
+
+int KltProc::getPoints(std::vector<TrackedPoint>& result) const {
+    int tracked = 0;
+
+    FrameDelegate delegate = [&](const Size2d& size, const void* pixels, size_t rowStride) {
+        tracked = getPoints(size, pixels, rowStride, imageSize, int(points.size()), result);
+    };
+
+    getResultData(delegate);
+    getMemTransferObj()->flushReadback(); // in case of multiple readback buffers
+
+    return tracked;
+}
+
+int KltProc::getPoints(const Size2d& size, const void* pixels, size_t rowStride, const Size2d& imageSize, int numPoints, std::vector<TrackedPoint>& result) {
+    const int cols = size.width, rows = size.height / 2;
+    const auto getTexel = [&](int k, bool isStatus) {
+        const int row = (k / cols) + (isStatus ? rows : 0);
+        return static_cast<const unsigned char*>(pixels) + row * rowStride + (k % cols) * 4;
+    };
+
+    result.resize(std::min(numPoints, cols * rows));
+
+    int tracked = 0;
+    for (int k = 0; k < int(result.size()); k++) {
+        const unsigned char* position = getTexel(k, false);
+        const unsigned char* status = getTexel(k, true);
+
+        TrackedPoint& point = result[k];
+        point.x = float((position[0] << 8) | position[1]) / 65535.f * imageSize.width;
+        point.y = float((position[2] << 8) | position[3]) / 65535.f * imageSize.height;
+        point.tracked = (status[0] > 127);
+        point.error = float(status[1]) / 255.f;
+        tracked += point.tracked;
+    }
+
+    return tracked;
+}
+
+#pragma mark private methods
+
+void KltProc::filterShaderSetup(const char* vShaderSrc, const char* fShaderSrc, GLenum target) {
+    FilterProcBase::filterShaderSetup(vShaderSrc, fShaderSrc, target);
+}
+
+void KltProc::getUniforms() {
+    FilterProcBase::getUniforms();
+
+    shParamUPrevTex = shader->getParam(UNIF, "uPrevTex");
+    shParamUStartTex = shader->getParam(UNIF, "uStartTex");
+    shParamUPointTex = shader->getParam(UNIF, "uPointTex");
+    shParamUInputSize = shader->getParam(UNIF, "uInputSize");
+    shParamULevelRect = shader->getParam(UNIF, "uLevelRect");
+    shParamULevelScale = shader->getParam(UNIF, "uLevelScale");
+    shParamUImageSize = shader->getParam(UNIF, "uImageSize");
+    shParamUSize = shader->getParam(UNIF, "uSize");
+    shParamUTau = shader->getParam(UNIF, "uTau");
+    shParamUFirst = shader->getParam(UNIF, "uFirst");
+    shParamULast = shader->getParam(UNIF, "uLast");
+}
+
+std::vector<Rect2d> KltProc::getLevels() const {
+    if (pyramid) {
+        return pyramid->getLevelCrops();
+    }
+    return { Rect2d(0, 0, inFrameW, inFrameH) };
+}
+
+void KltProc::createPointTextures() {
+    releasePointTextures();
+
+    const Rect2d first = getLevels().front();
+    imageSize = Size2d(first.width, first.height);
+    hasNewPoints = true; // the positions of the output are not valid for another input size
+
+    startFBO = new FBO(core);
+    pointFBOs[0] = new FBO(core);
+    pointFBOs[1] = new FBO(core);
+
+    for (FBO* pointFBO : { startFBO, pointFBOs[0], pointFBOs[1] }) {
+        pointFBO->setGLTexUnit(1);
+        pointFBO->createAttachedTex(outFrameW, outFrameH, false);
+
+        // positions must not be interpolated
+        glBindTexture(GL_TEXTURE_2D, pointFBO->getAttachedTexId());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    }
+
+    OG_LOGINF(getProcName(), "%d points in %dx%d texels for image size %dx%d", maxPoints, outFrameW, outFrameH, imageSize.width, imageSize.height);
+}
+
+void KltProc::releasePointTextures() {
+    delete startFBO;
+    startFBO = nullptr;
+
+    for (int i = 0; i < 2; i++) {
+        delete pointFBOs[i];
+        pointFBOs[i] = nullptr;
+    }
+}
+
+void KltProc::uploadPoints() {
+    std::vector<unsigned char> texels(size_t(outFrameW) * outFrameH * 4, 0);
+
+    for (int k = 0; k < int(points.size()); k++) {
+        const TrackedPoint& point = points[k];
+        const int x = k % cols, y = k / cols;
+
+        unsigned char* position = &texels[(size_t(y) * outFrameW + x) * 4];
+        const float nx = std::min(std::max(point.x / float(imageSize.width), 0.f), 1.f);
+        const float ny = std::min(std::max(point.y / float(imageSize.height), 0.f), 1.f);
+        const int vx = int(std::round(nx * 65535.f)), vy = int(std::round(ny * 65535.f));
+        position[0] = (unsigned char)(vx >> 8);
+        position[1] = (unsigned char)(vx & 255);
+        position[2] = (unsigned char)(vy >> 8);
+        position[3] = (unsigned char)(vy & 255);
+
+        unsigned char* status = &texels[(size_t(y + rows) * outFrameW + x) * 4];
+        status[0] = point.tracked ? 255 : 0;
+        status[3] = 255;
+    }
+
+    getGLState().bindTexture(texUnit, GL_TEXTURE_2D, startFBO->getAttachedTexId());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, outFrameW, outFrameH, GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+
+    hasNewPoints = false;
+}
+
+void KltProc::filterRenderPrepare() {
+    GLStateCache& glState = getGLState();
+
+    // the points of the last output (or the new points) are the start positions of this frame
+    if (hasNewPoints) {
+        uploadPoints();
+    } else {
+        fbo->bind();
+        glState.bindTexture(texUnit, GL_TEXTURE_2D, startFBO->getAttachedTexId());
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, outFrameW, outFrameH);
+    }
+
+    // coarse to fine, the last pass renders into the output
+    const std::vector<Rect2d> levels = getLevels();
+    const int numPasses = int(levels.size()) * std::max(iterations, 1);
+
+    GLuint pointTex = startFBO->getAttachedTexId();
+    for (int pass = 0; pass < numPasses - 1; pass++) {
+        FBO* pointFBO = pointFBOs[pass % 2];
+        pointFBO->bind();
+        setPass(levels[levels.size() - 1 - pass / std::max(iterations, 1)], pointTex, pass == 0, false);
+
+        filterRenderSetQuad(shParamAPos, shParamATexCoord, RenderOrientationStd);
+        filterRenderDraw();
+
+        pointTex = pointFBO->getAttachedTexId();
+    }
+    fbo->unbind();
+    Tools::checkGLErr(getProcName(), "render passes");
+
+    setPass(levels.front(), pointTex, numPasses == 1, true);
+}
+
+void KltProc::setPass(const Rect2d& level, GLuint pointTex, bool isFirst, bool isLast) {
+    GLStateCache& glState = getGLState();
+
+    glState.useProgram(shader->getProgramId());
+    glState.viewport(0, 0, outFrameW, outFrameH);
+
+    // texture units: current frame, previous frame, start points, points
+    texUnit2 = texUnit + 1;
+    glState.bindTexture(texUnit, texTarget, texId);
+    glState.bindTexture(texUnit2, texTarget2, texId2);
+    glState.bindTexture(texUnit + 2, GL_TEXTURE_2D, startFBO->getAttachedTexId());
+    glState.bindTexture(texUnit + 3, GL_TEXTURE_2D, pointTex);
+    glUniform1i(shParamUInputTex, texUnit);
+    glUniform1i(shParamUPrevTex, texUnit2);
+    glUniform1i(shParamUStartTex, texUnit + 2);
+    glUniform1i(shParamUPointTex, texUnit + 3);
+
+    glUniform2f(shParamUInputSize, float(inFrameW), float(inFrameH));
+    glUniform4f(shParamULevelRect, float(level.x), float(level.y), float(level.width), float(level.height));
+    glUniform2f(shParamULevelScale, float(level.width) / float(imageSize.width), float(level.height) / float(imageSize.height));
+    glUniform2f(shParamUImageSize, float(imageSize.width), float(imageSize.height));
+    glUniform2f(shParamUSize, float(outFrameW), float(outFrameH));
+    glUniform1f(shParamUTau, tau);
+    glUniform1f(shParamUFirst, float(isFirst));
+    glUniform1f(shParamULast, float(isLast));
+}
+
+// =========================================
+
+struct KltPipeline::Impl {
+    Impl(int levels, int maxPoints, bool doGray)
+        : pyramidProc(levels)
+        , kltProc(&pyramidProc, maxPoints) {
+        if (!doGray) {
+            grayProc.setGrayscaleConvType(GRAYSCALE_INPUT_CONVERSION_NONE);
+        }
+
+        pyramidProc.setMode(PyramidProc::GAUSSIAN);
+
+        {
+            // the previous pyramid is delayed by the fifo
+            grayProc.add(&pyramidProc);
+            pyramidProc.add(&kltProc, 0);
+            pyramidProc.add(&fifoProc);
+            fifoProc.add(&kltProc, 1);
+        }
+    }
+
+    GrayscaleProc grayProc;
+    PyramidProc pyramidProc;
+    FifoProc fifoProc;
+    KltProc kltProc;
+};
+
+KltPipeline::KltPipeline(int levels, int maxPoints, bool doGray) {
+    m_pImpl = std::unique_ptr<Impl>(new Impl(levels, maxPoints, doGray));
+
+    procPasses.push_back(&m_pImpl->grayProc);
+    procPasses.push_back(&m_pImpl->pyramidProc);
+    procPasses.push_back(&m_pImpl->fifoProc);
+    procPasses.push_back(&m_pImpl->kltProc);
+}
+
+KltPipeline::~KltPipeline() {
+    procPasses.clear(); // passes are owned by m_pImpl
+}
+
+KltProc& KltPipeline::getTracker() const {
+    return m_pImpl->kltProc;
+}
+
+ProcInterface* KltPipeline::getInputFilter() const {
+    return &m_pImpl->grayProc;
+}
+
+ProcInterface* KltPipeline::getOutputFilter() const {
+    return &m_pImpl->kltProc;
+}
+
+int KltPipeline::render(int position) {
+    getInputFilter()->process(position);
+    return 0;
+}
+
+int KltPipeline::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
+    getInputFilter()->prepare(inW, inH, 0, std::numeric_limits<int>::max(), 0);
+    return 0;
+}
+
+int KltPipeline::reinit(int inW, int inH, bool prepareForExternalInput) {
+    getInputFilter()->prepare(inW, inH, 0, std::numeric_limits<int>::max(), 0);
+    return 0;
+}
+
+END_OGLES_GPGPU
@@ -0,0 +1,284 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * GPGPU sparse KLT point tracker.
+ */
+#ifndef OGLES_GPGPU_COMMON_PROC_KLT
+#define OGLES_GPGPU_COMMON_PROC_KLT
+
+#include "../common_includes.h"
+#include "base/multipassproc.h"
+#include "two.h"
+
+#include <memory>
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+class PyramidProc;
+
+/**
+ * Point that is tracked by KltProc.
+ */
+struct TrackedPoint {
+    TrackedPoint() {}
+    TrackedPoint(float x, float y, bool tracked = true)
+        : x(x)
+        , y(y)
+        , tracked(tracked) {
+    }
+    float x = 0.f, y = 0.f; // position in pixels of the input (the center of the first pixel is at 0,0)
+    bool tracked = false; // false if the point is lost
+    float error = 0.f; // mean absolute intensity difference of the window in [0, 1]
+};
+
+/**
+ * KltProc tracks a set of points from the previous frame (input 1) to the current
+ * frame (input 0) with the Lucas-Kanade method, so that the cost depends on the
+ * number of points instead of the image size.
+ *
+ * The points are kept in the output texture: the positions (16 bit fixed point per
+ * axis) in the upper half and the status in the lower half, one texel per point in
+ * rows of <cols> points. Each pass renders a texel per point, reads a 15x15 window
+ * around it from both frames and updates its position. With a PyramidProc <pyramid>,
+ * the inputs are flat pyramids with its level layout and the points are tracked
+ * from the coarsest to the first level in <iterations> passes per level, otherwise
+ * the inputs are single images. A point is lost if the smaller eigenvalue of the mean
+ * structure tensor of its window is smaller than <tau> (for intensities in [0, 1]) or
+ * if it leaves the image. Lost points are not tracked any more.
+ *
+ * The output of a frame holds the input points of the next frame, so the points
+ * are only uploaded by setPoints() and only the few kilobytes of the output are
+ * read back by getPoints().
+ */
+class KltProc : public TwoInputProc {
+public:
+    /**
+     * Constructor for up to <maxPoints> points in rows of <cols> points. The capacity
+     * is rounded up to fill the last row.
+     */
+    KltProc(const PyramidProc* pyramid = nullptr, int maxPoints = 1024, int cols = 64);
+
+    /**
+     * Deconstructor.
+     */
+    virtual ~KltProc();
+
+    /**
+     * Return the processors name.
+     */
+    virtual const char* getProcName() {
+        return "KltProc";
+    }
+
+    /**
+     * The output depends on the whole input.
+     */
+    virtual int getRoiHalo() const {
+        return -1;
+    }
+
+    /**
+     * Init the processor for input frames of size <inW>x<inH> which is at
+     * position <order> in the processing pipeline.
+     */
+    virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput = false);
+
+    /**
+     * Reinitialize the proc for a different input frame size of <inW>x<inH>.
+     */
+    virtual int reinit(int inW, int inH, bool prepareForExternalInput = false);
+
+    /**
+     * Cleanup processor's resources.
+     */
+    virtual void cleanup();
+
+    /**
+     * Set the points <points> in the previous frame (the last processed input frame),
+     * which are tracked in the next frame. Points with <tracked> == false are kept as
+     * lost points. Only the first getMaxPoints() points are used.
+     */
+    void setPoints(const std::vector<TrackedPoint>& points);
+
+    /**
+     * Read the output and decode the tracked points to <points>. Returns the number
+     * of points that are still tracked.
+     */
+    int getPoints(std::vector<TrackedPoint>& points) const;
+
+    /**
+     * Decode <numPoints> points in an image of size <imageSize> from the output <pixels>
+     * of size <size> with <rowStride> bytes per row (i.e. passed to a FrameDelegate) to
+     * <points>. The output is read back as GL_RGBA. Returns the number of tracked points.
+     */
+    static int getPoints(const Size2d& size, const void* pixels, size_t rowStride, const Size2d& imageSize, int numPoints, std::vector<TrackedPoint>& points);
+
+    /**
+     * Get the number of points that were set by setPoints().
+     */
+    int getNumPoints() const {
+        return int(points.size());
+    }
+
+    /**
+     * Get the maximum number of points.
+     */
+    int getMaxPoints() const {
+        return maxPoints;
+    }
+
+    /**
+     * Get the image size of the points (the size of the first level).
+     */
+    const Size2d& getImageSize() const {
+        return imageSize;
+    }
+
+    /**
+     * Set the number of Lucas-Kanade iterations per level.
+     */
+    void setIterations(int value) {
+        iterations = value;
+    }
+
+    /**
+     * Get the number of Lucas-Kanade iterations per level.
+     */
+    int getIterations() const {
+        return iterations;
+    }
+
+    /**
+     * Set the eigenvalue threshold <value> for lost points.
+     */
+    void setTau(float value) {
+        tau = value;
+    }
+
+    /**
+     * Get the eigenvalue threshold for lost points.
+     */
+    float getTau() const {
+        return tau;
+    }
+
+private:
+    /**
+     * Output size is defined by the number of points.
+     */
+    virtual void setOutputSize(float scaleFactor) {}
+
+    virtual const char* getFragmentShaderSource() {
+        return fshaderKltSrc;
+    }
+    virtual const char* getVertexShaderSource() {
+        return vshaderDefault;
+    }
+
+    virtual void filterShaderSetup(const char* vShaderSrc, const char* fShaderSrc, GLenum target);
+    virtual void getUniforms();
+
+    /**
+     * Render all passes but the last one and prepare the last pass, which renders
+     * into the output.
+     */
+    virtual void filterRenderPrepare();
+
+    /**
+     * Get the level rectangles of the inputs.
+     */
+    std::vector<Rect2d> getLevels() const;
+
+    /**
+     * Create the point textures.
+     */
+    void createPointTextures();
+
+    /**
+     * Release the point textures.
+     */
+    void releasePointTextures();
+
+    /**
+     * Upload the points to the start texture.
+     */
+    void uploadPoints();
+
+    /**
+     * Set the uniforms of a pass on level <level> that reads the positions from <pointTex>.
+     */
+    void setPass(const Rect2d& level, GLuint pointTex, bool isFirst, bool isLast);
+
+    const PyramidProc* pyramid = nullptr; // level layout of the inputs. weak ref.
+
+    int maxPoints = 0;
+    int cols = 0;
+    int rows = 0;
+
+    int iterations = 5;
+    float tau = 0.00001f;
+
+    std::vector<TrackedPoint> points; // points of setPoints()
+    bool hasNewPoints = true; // the points must be uploaded
+    Size2d imageSize;
+
+    FBO* startFBO = nullptr; // points at the start of the frame. strong ref.!
+    FBO* pointFBOs[2] = { nullptr, nullptr }; // points of the passes (ping-pong). strong ref.!
+
+    GLint shParamUPrevTex;
+    GLint shParamUStartTex;
+    GLint shParamUPointTex;
+    GLint shParamUInputSize;
+    GLint shParamULevelRect;
+    GLint shParamULevelScale;
+    GLint shParamUImageSize;
+    GLint shParamUSize;
+    GLint shParamUTau;
+    GLint shParamUFirst;
+    GLint shParamULast;
+
+    static const char* fshaderKltSrc; // fragment shader source
+};
+
+/**
+ * Sparse tracker for the input: both frames are reduced to a Gaussian PyramidProc
+ * with <levels> levels (the previous one is kept in a FifoProc) and a KltProc tracks
+ * the points from the previous to the current frame.
+ */
+class KltPipeline : public MultiPassProc {
+public:
+    KltPipeline(int levels = 4, int maxPoints = 1024, bool doGray = false);
+    virtual ~KltPipeline();
+
+    /**
+     * Get the tracker (i.e. to set and get the points).
+     */
+    KltProc& getTracker() const;
+
+    virtual ProcInterface* getInputFilter() const;
+    virtual ProcInterface* getOutputFilter() const;
+
+    /**
+     * Return the processors name.
+     */
+    virtual const char* getProcName() {
+        return "KltPipeline";
+    }
+
+    virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput = false);
+    virtual int reinit(int inW, int inH, bool prepareForExternalInput = false);
+    virtual int render(int position);
+
+protected:
+    struct Impl;
+    std::unique_ptr<Impl> m_pImpl;
+};
+
+END_OGLES_GPGPU
+
+#endif // OGLES_GPGPU_COMMON_PROC_KLT
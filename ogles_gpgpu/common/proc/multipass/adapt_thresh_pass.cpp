@@ -86,10 +86,6 @@ int AdaptThreshProcPass::init(int inW, int inH, unsigned int order, bool prepare
     // parent init - set defaults
     baseInit(inW, inH, order, prepareForExternalInput, procParamOutW, procParamOutH, procParamOutScale);
 
-    // calculate pixel delta values
-    pxDx = 1.0f / (float)outFrameW;
-    pxDy = 1.0f / (float)outFrameH;
-
     // get necessary fragment shader source
     const char* shSrc = renderPass == 1 ? fshaderAdaptThreshPass1Src : fshaderAdaptThreshPass2Src;
 
@@ -121,6 +117,10 @@ int AdaptThreshProcPass::render(int position) {
 
     filterRenderPrepare();
 
+    // calculate pixel delta values (the frame size changes on reinit)
+    pxDx = 1.0f / (float)outFrameW;
+    pxDy = 1.0f / (float)outFrameH;
+
     glUniform2f(shParamUPxD, pxDx, pxDy); // texture pixel delta values
 
     Tools::checkGLErr(getProcName(), "render prepare");
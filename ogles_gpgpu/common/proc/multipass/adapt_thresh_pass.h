@@ -43,6 +43,13 @@ public:
         return "AdaptThreshProcPass";
     }
 
+    /**
+     * A 5x1 neighbourhood is read.
+     */
+    virtual int getRoiHalo() const {
+        return 2;
+    }
+
     /**
      * Init the processor for input frames of size <inW>x<inH> which is at
      * position <order> in the processing pipeline.
@@ -124,6 +124,10 @@ void BoxOptProcPass::filterShaderSetup(const char* vShaderSrc, const char* fShad
 void BoxOptProcPass::setUniforms() {
     FilterProcBase::setUniforms();
 
+    // calculate pixel delta values (the frame size changes on reinit)
+    pxDx = 1.0f / (float)outFrameW;
+    pxDy = 1.0f / (float)outFrameH;
+
     glUniform1f(shParamUTexelWidthOffset, (renderPass == 1) * pxDx);
     glUniform1f(shParamUTexelHeightOffset, (renderPass == 2) * pxDy);
 }
@@ -131,10 +135,6 @@ void BoxOptProcPass::setUniforms() {
 void BoxOptProcPass::getUniforms() {
     FilterProcBase::getUniforms();
 
-    // calculate pixel delta values
-    pxDx = 1.0f / (float)outFrameW;
-    pxDy = 1.0f / (float)outFrameH;
-
     shParamUInputTex = shader->getParam(UNIF, "inputImageTexture");
     shParamUTexelWidthOffset = shader->getParam(UNIF, "texelWidthOffset");
     shParamUTexelHeightOffset = shader->getParam(UNIF, "texelHeightOffset");
@@ -44,6 +44,13 @@ public:
         return "BoxOptProcPass";
     }
 
+    /**
+     * The radius of the kernel (plus one pixel for linear sampling) is read.
+     */
+    virtual int getRoiHalo() const {
+        return int(_blurRadiusInPixels) + 1;
+    }
+
     virtual void filterShaderSetup(const char* vShaderSrc, const char* fShaderSrc, GLenum target);
     virtual void setUniforms();
     virtual void getUniforms();
@@ -157,6 +157,8 @@ void GaussOptProcPass::setRadius(float newValue) {
             calculatedSampleRadius += calculatedSampleRadius % 2; // There's nothing to gain from handling odd radius sizes, due to the optimizations I use
         }
 
+        sampleRadius = calculatedSampleRadius;
+
         //std::cout << "Blur radius " << _blurRadiusInPixels << " calculated sample radius " << calculatedSampleRadius << std::endl;
         //std::cout << "===" << std::endl;
 
@@ -182,6 +184,10 @@ void GaussOptProcPass::filterShaderSetup(const char* vShaderSrc, const char* fSh
 void GaussOptProcPass::setUniforms() {
     FilterProcBase::setUniforms();
 
+    // calculate pixel delta values (the frame size changes on reinit)
+    pxDx = 1.0f / (float)outFrameW; // input or output?
+    pxDy = 1.0f / (float)outFrameH;
+
     glUniform1f(shParamUTexelWidthOffset, (renderPass == 1) * pxDx);
     glUniform1f(shParamUTexelHeightOffset, (renderPass == 2) * pxDy);
 }
@@ -189,10 +195,6 @@ void GaussOptProcPass::setUniforms() {
 void GaussOptProcPass::getUniforms() {
     FilterProcBase::getUniforms();
 
-    // calculate pixel delta values
-    pxDx = 1.0f / (float)outFrameW; // input or output?
-    pxDy = 1.0f / (float)outFrameH;
-
     shParamUInputTex = shader->getParam(UNIF, "inputImageTexture");
     shParamUTexelWidthOffset = shader->getParam(UNIF, "texelWidthOffset");
     shParamUTexelHeightOffset = shader->getParam(UNIF, "texelHeightOffset");
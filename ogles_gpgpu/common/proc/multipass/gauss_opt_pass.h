@@ -46,6 +46,13 @@ public:
         return "GaussOptProcPass";
     }
 
+    /**
+     * The sample radius of the kernel (plus one pixel for linear sampling) is read.
+     */
+    virtual int getRoiHalo() const {
+        return sampleRadius + 1;
+    }
+
     virtual void filterShaderSetup(const char* vShaderSrc, const char* fShaderSrc, GLenum target);
     virtual void setUniforms();
     virtual void getUniforms();
@@ -62,6 +69,7 @@ private:
     float normConst = 0.005;
 
     float _blurRadiusInPixels = 0.0; // start 0 (uninitialized)
+    int sampleRadius = 0; // radius of the kernel samples
 
     GLint shParamUTexelWidthOffset;
     GLint shParamUTexelHeightOffset;
@@ -52,6 +52,13 @@ public:
         return "GaussProcPass";
     }
 
+    /**
+     * A 5x1 or 7x1 (k7Tap) neighbourhood is read.
+     */
+    virtual int getRoiHalo() const {
+        return (kernel == k7Tap) ? 3 : 2;
+    }
+
     virtual void filterShaderSetup(const char* vShaderSrc, const char* fShaderSrc, GLenum target);
     virtual void setUniforms();
     virtual void getUniforms();
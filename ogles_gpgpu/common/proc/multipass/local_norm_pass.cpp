@@ -71,10 +71,6 @@ int LocalNormPass::init(int inW, int inH, unsigned int order, bool prepareForExt
     // parent init - set defaults
     baseInit(inW, inH, order, prepareForExternalInput, procParamOutW, procParamOutH, procParamOutScale);
 
-    // calculate pixel delta values
-    pxDx = 1.0f / (float)outFrameW;
-    pxDy = 1.0f / (float)outFrameH;
-
     // get necessary fragment shader source
     const char* shSrc = renderPass == 1 ? fshaderLocalNormPass1Src : fshaderLocalNormPass2Src;
 
@@ -110,6 +106,10 @@ int LocalNormPass::render(int position) {
 
     filterRenderPrepare();
 
+    // calculate pixel delta values (the frame size changes on reinit)
+    pxDx = 1.0f / (float)outFrameW;
+    pxDy = 1.0f / (float)outFrameH;
+
     glUniform1f(shParamUPxD, renderPass == 1 ? pxDy : pxDx); // texture pixel delta values
     if (renderPass == 2) {
         glUniform1f(shParamUNormConst, normConst);
@@ -38,6 +38,13 @@ public:
         return "LocalNormPass";
     }
 
+    /**
+     * A 7x1 neighbourhood is read.
+     */
+    virtual int getRoiHalo() const {
+        return 3;
+    }
+
     /**
      * Init the processor for input frames of size <inW>x<inH> which is at
      * position <order> in the processing pipeline.
@@ -8,10 +8,75 @@
 
 #include "pyramid.h"
 #include "../common_includes.h"
+#include "../core.h"
 
 using namespace std;
 using namespace ogles_gpgpu;
 
+// clang-format off
+#define OGLES_GPGPU_PYRAMID_FETCH_FUNC OG_TO_STR(                               \
+ uniform sampler2D uInputTex;                                                   \
+ uniform vec2 uInputSize;                                                       \
+                                                                                \
+ vec4 fetch(vec2 p, vec4 rect)                                                  \
+ {                                                                              \
+     p = clamp(p, rect.xy + 0.5, rect.xy + rect.zw - 0.5);                      \
+     return texture2D(uInputTex, p / uInputSize);                               \
+ }                                                                              \
+)
+// clang-format on
+
+// 5-tap binomial kernel [1 4 6 4 1] / 16 at the output positions, which are between the
+// input pixels, i.e. [1 5 10 10 5 1] / 32 on the input pixels with 3 linear fetches per axis
+// clang-format off
+static const char* fshaderReduceSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OGLES_GPGPU_PYRAMID_FETCH_FUNC
+OG_TO_STR(
+ uniform vec4 uInputRect;
+ varying vec2 vTexCoord;
+
+ const float d = 5.0 / 3.0;
+ const vec3 w = vec3(3.0, 10.0, 3.0) / 16.0;
+
+ vec4 row(vec2 p)
+ {
+     return w.x * fetch(p - vec2(d, 0.0), uInputRect) + w.y * fetch(p, uInputRect) + w.z * fetch(p + vec2(d, 0.0), uInputRect);
+ }
+
+ void main()
+ {
+     vec2 p = uInputRect.xy + vTexCoord * uInputRect.zw;
+     gl_FragColor = w.x * row(p - vec2(0.0, d)) + w.y * row(p) + w.z * row(p + vec2(0.0, d));
+});
+// clang-format on
+
+// difference of a Gaussian level and the linearly upsampled next level
+// clang-format off
+static const char* fshaderLaplacianSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OGLES_GPGPU_PYRAMID_FETCH_FUNC
+OG_TO_STR(
+ uniform vec4 uInputRect;
+ uniform vec4 uCoarseRect;
+ varying vec2 vTexCoord;
+
+ void main()
+ {
+     vec4 g = fetch(uInputRect.xy + vTexCoord * uInputRect.zw, uInputRect);
+     if (uCoarseRect.z < 0.5) { // last level
+         gl_FragColor = g;
+     } else {
+         vec4 c = fetch(uCoarseRect.xy + vTexCoord * uCoarseRect.zw, uCoarseRect);
+         gl_FragColor = vec4(clamp((g.rgb - c.rgb) * 0.5 + 0.5, 0.0, 1.0), g.a);
+     }
+});
+// clang-format on
+
 static std::vector<Rect2d> pack(const std::vector<Size2d>& src) {
     std::vector<Rect2d> packed;
 
@@ -69,6 +134,10 @@ PyramidProc::PyramidProc(const std::vector<Size2d>& scales)
     : m_scales(scales) {
 }
 
+PyramidProc::~PyramidProc() {
+    releaseLevels();
+}
+
 void PyramidProc::setOutputSize(float scaleFactor) {
     // noop
 }
@@ -102,18 +171,66 @@ int PyramidProc::PyramidProc::render(int position) {
     glClearColor(0, 0, 0, 1);
 
     for (auto& c : m_crops) {
-        glViewport(c.x, c.y, c.width, c.height);
+        getGLState().viewport(c.x, c.y, c.width, c.height);
         filterRenderDraw();
+
+        if (m_cascaded) {
+            break; // the other levels are reduced from the first one
+        }
     }
     Tools::checkGLErr(getProcName(), "render draw");
 
     filterRenderCleanup();
     Tools::checkGLErr(getProcName(), "render cleanup");
 
+    if (m_cascaded) {
+        renderCascade();
+        Tools::checkGLErr(getProcName(), "render cascade");
+    }
+
     return 0;
 }
 
 int PyramidProc::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
+    setLayout(inW, inH);
+
+    int result = FilterProcBase::init(inW, inH, order, prepareForExternalInput);
+
+    if (m_cascaded) {
+        createLevelShader(m_reduceShader, fshaderReduceSrc);
+        createLevelShader(m_laplacianShader, fshaderLaplacianSrc);
+        createLevels();
+    }
+
+    return result;
+}
+
+int PyramidProc::reinit(int inW, int inH, bool prepareForExternalInput) {
+    setLayout(inW, inH);
+
+    int result = FilterProcBase::reinit(inW, inH, prepareForExternalInput);
+
+    if (m_cascaded) {
+        if (!m_reduceShader.shader) {
+            createLevelShader(m_reduceShader, fshaderReduceSrc);
+            createLevelShader(m_laplacianShader, fshaderLaplacianSrc);
+        }
+        createLevels();
+    }
+
+    return result;
+}
+
+void PyramidProc::cleanup() {
+    releaseLevels();
+
+    m_reduceShader.shader.reset();
+    m_laplacianShader.shader.reset();
+
+    FilterProcBase::cleanup();
+}
+
+void PyramidProc::setLayout(int inW, int inH) {
     int width = 0, height = 0;
     if (m_scales.size()) {
         m_crops = pack(m_scales);
@@ -127,6 +244,124 @@ int PyramidProc::init(int inW, int inH, unsigned int order, bool prepareForExter
         height = inH;
     }
 
+    if (m_mode != DIRECT && m_scales.size()) {
+        OG_LOGERR(getProcName(), "levels are sampled from the input for preset scales");
+    }
+    m_cascaded = (m_mode != DIRECT) && m_scales.empty() && m_crops.size() > 1;
+
     FilterProcBase::setOutputSize(width, height);
-    return FilterProcBase::init(inW, inH, order, prepareForExternalInput);
+}
+
+void PyramidProc::createLevels() {
+    releaseLevels();
+
+    // the previous level is copied to the level texture (the first level is the largest)
+    m_levelFBO = new FBO(core);
+    m_levelFBO->setGLTexUnit(1);
+    m_levelFBO->createAttachedTex(m_crops[0].width, m_crops[0].height, false);
+
+    if (m_mode == LAPLACIAN) {
+        m_gaussFBO = new FBO(core);
+        m_gaussFBO->setGLTexUnit(1);
+        m_gaussFBO->createAttachedTex(outFrameW, outFrameH, false);
+    }
+
+    OG_LOGINF(getProcName(), "%d cascaded levels", int(m_crops.size()));
+}
+
+void PyramidProc::releaseLevels() {
+    delete m_levelFBO;
+    m_levelFBO = nullptr;
+
+    delete m_gaussFBO;
+    m_gaussFBO = nullptr;
+}
+
+void PyramidProc::createLevelShader(LevelShader& levelShader, const char* fshSrc) {
+    if (core) {
+        levelShader.shader = core->getShaderCache().acquire(vshaderDefault, fshSrc);
+    } else {
+        levelShader.shader = make_shared<Shader>();
+        levelShader.shader->buildFromSrc(vshaderDefault, fshSrc);
+    }
+
+    assert(levelShader.shader->getProgramId() > 0);
+
+    const Shader& sh = *levelShader.shader;
+    levelShader.shParamAPos = sh.getParam(ATTR, "aPos");
+    levelShader.shParamATexCoord = sh.getParam(ATTR, "aTexCoord");
+    levelShader.shParamUInputTex = sh.getParam(UNIF, "uInputTex");
+    levelShader.shParamUInputSize = sh.getParam(UNIF, "uInputSize");
+    levelShader.shParamUInputRect = sh.getParam(UNIF, "uInputRect");
+    if (fshSrc == fshaderLaplacianSrc) {
+        levelShader.shParamUCoarseRect = sh.getParam(UNIF, "uCoarseRect");
+    }
+}
+
+void PyramidProc::renderCascade() {
+    assert(m_levelFBO);
+
+    GLStateCache& glState = getGLState();
+    const GLuint levelTex = m_levelFBO->getAttachedTexId();
+
+    // the first level is a copy of the input unless it is transformed
+    bool isIdentity = true;
+    for (int i = 0; i < 4; i++) {
+        for (int j = 0; j < 4; j++) {
+            isIdentity = isIdentity && (transformMatrix.data[i][j] == GLfloat(i == j));
+        }
+    }
+    const RenderOrientation o = getOutputRenderOrientation();
+    const bool isInputLevel = isIdentity && texTarget == GL_TEXTURE_2D && (o == RenderOrientationStd || o == RenderOrientationNone);
+
+    fbo->bind();
+
+    for (int i = 1; i < int(m_crops.size()); i++) {
+        if (i == 1 && isInputLevel) {
+            renderLevel(m_reduceShader, texId, inFrameW, inFrameH, Rect2d(0, 0, inFrameW, inFrameH), m_crops[i]);
+            continue;
+        }
+
+        // copy the previous level from the output to the level texture
+        const Rect2d& prev = m_crops[i - 1];
+        glState.bindTexture(texUnit, GL_TEXTURE_2D, levelTex);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, prev.x, prev.y, prev.width, prev.height);
+
+        renderLevel(m_reduceShader, levelTex, m_levelFBO->getTexWidth(), m_levelFBO->getTexHeight(), Rect2d(0, 0, prev.width, prev.height), m_crops[i]);
+    }
+
+    if (m_mode == LAPLACIAN) {
+        // copy the Gaussian levels and replace them by the differences
+        const GLuint gaussTex = m_gaussFBO->getAttachedTexId();
+        glState.bindTexture(texUnit, GL_TEXTURE_2D, gaussTex);
+        glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, outFrameW, outFrameH);
+
+        for (int i = 0; i < int(m_crops.size()); i++) {
+            const Rect2d coarse = (i + 1 < int(m_crops.size())) ? m_crops[i + 1] : Rect2d();
+            renderLevel(m_laplacianShader, gaussTex, outFrameW, outFrameH, m_crops[i], m_crops[i], coarse);
+        }
+    }
+
+    fbo->unbind();
+}
+
+void PyramidProc::renderLevel(const LevelShader& levelShader, GLuint tex, int texW, int texH, const Rect2d& src, const Rect2d& dst, const Rect2d& coarse) {
+    GLStateCache& glState = getGLState();
+
+    glState.useProgram(levelShader.shader->getProgramId());
+    glState.viewport(dst.x, dst.y, dst.width, dst.height);
+    glState.bindTexture(texUnit, GL_TEXTURE_2D, tex);
+
+    glUniform1i(levelShader.shParamUInputTex, texUnit);
+    glUniform2f(levelShader.shParamUInputSize, float(texW), float(texH));
+    glUniform4f(levelShader.shParamUInputRect, float(src.x), float(src.y), float(src.width), float(src.height));
+    if (levelShader.shParamUCoarseRect >= 0) {
+        glUniform4f(levelShader.shParamUCoarseRect, float(coarse.x), float(coarse.y), float(coarse.width), float(coarse.height));
+    }
+
+    filterRenderSetQuad(levelShader.shParamAPos, levelShader.shParamATexCoord, RenderOrientationStd);
+    filterRenderDraw();
+
+    glState.disableVertexAttribArray(levelShader.shParamAPos);
+    glState.disableVertexAttribArray(levelShader.shParamATexCoord);
 }
@@ -25,6 +25,15 @@ namespace ogles_gpgpu {
  */
 class PyramidProc : public TransformProc {
 public:
+    /**
+     * How the levels (after the first one) are created.
+     */
+    enum Mode {
+        DIRECT, // each level is sampled from the input
+        GAUSSIAN, // each level is reduced from the previous level with a 5-tap binomial kernel
+        LAPLACIAN // GAUSSIAN levels, stored as the difference to the next level (see setMode())
+    };
+
     /**
      * Constructor for pyramid.
      */
@@ -35,6 +44,11 @@ public:
      */
     PyramidProc(const std::vector<Size2d>& scales);
 
+    /**
+     * Deconstructor.
+     */
+    virtual ~PyramidProc();
+
     /**
      * Render a flat pyramid
      */
@@ -52,6 +66,16 @@ public:
      */
     virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput);
 
+    /**
+     * Reinitialize the levels for input size <inW>x<inH>.
+     */
+    virtual int reinit(int inW, int inH, bool prepareForExternalInput = false);
+
+    /**
+     * Release the level textures and shaders.
+     */
+    virtual void cleanup();
+
     /**
      * Preset output scales
      */
@@ -67,14 +91,85 @@ public:
      */
     const std::vector<Rect2d>& getLevelCrops() const;
 
+    /**
+     * Set the mode <mode> for the levels after the first one (default: DIRECT).
+     * In GAUSSIAN and LAPLACIAN mode, level i is reduced from level i - 1, so that the
+     * cost is bounded by about 4/3 of the first level. In LAPLACIAN mode, level i (except
+     * for the last one) holds 0.5 + 0.5 * (G_i - G_i+1) in the RGB channels, with the
+     * Gaussian level G_i+1 linearly upsampled, and the alpha channel of G_i.
+     * Only available for a number of levels (see setLevels()), not for preset scales.
+     * Must be set before the proc is initialized.
+     */
+    void setMode(Mode mode) {
+        m_mode = mode;
+    }
+
+    /**
+     * Get the mode for the levels after the first one.
+     */
+    Mode getMode() const {
+        return m_mode;
+    }
+
 private:
+    struct LevelShader {
+        std::shared_ptr<Shader> shader; // shared program, strong ref.!
+        GLint shParamAPos;
+        GLint shParamATexCoord;
+        GLint shParamUInputTex;
+        GLint shParamUInputSize;
+        GLint shParamUInputRect;
+        GLint shParamUCoarseRect = -1;
+    };
+
     virtual void setOutputSize(float scaleFactor);
 
+    /**
+     * Set the level crops and the output size for input size <inW>x<inH>.
+     */
+    void setLayout(int inW, int inH);
+
+    /**
+     * Create the level textures for GAUSSIAN and LAPLACIAN mode.
+     */
+    void createLevels();
+
+    /**
+     * Release the level textures.
+     */
+    void releaseLevels();
+
+    /**
+     * Create the program <levelShader> for fragment shader <fshSrc>.
+     */
+    void createLevelShader(LevelShader& levelShader, const char* fshSrc);
+
+    /**
+     * Render the levels after the first one from the previous level (GAUSSIAN and
+     * LAPLACIAN mode).
+     */
+    void renderCascade();
+
+    /**
+     * Render rectangle <dst> of the output with <levelShader> from rectangle <src> of
+     * texture <tex> with size <texW>x<texH> (and from its rectangle <coarse>).
+     */
+    void renderLevel(const LevelShader& levelShader, GLuint tex, int texW, int texH, const Rect2d& src, const Rect2d& dst, const Rect2d& coarse = Rect2d());
+
     std::vector<Size2d> m_scales;
 
     int m_levels = 4;
 
     std::vector<Rect2d> m_crops;
+
+    Mode m_mode = DIRECT;
+    bool m_cascaded = false; // GAUSSIAN or LAPLACIAN mode is used
+
+    LevelShader m_reduceShader;
+    LevelShader m_laplacianShader;
+
+    FBO* m_levelFBO = nullptr; // previous level for the reduction. strong ref.!
+    FBO* m_gaussFBO = nullptr; // Gaussian levels in LAPLACIAN mode. strong ref.!
 };
 }
 
@@ -0,0 +1,280 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "reduce.h"
+#include "../common_includes.h"
+#include "../core.h"
+
+#include <cstring>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+// clang-format off
+const char *ReduceProc::fshaderReduceSrc =
+#if defined(OGLES_GPGPU_OPENGLES)
+OG_TO_STR(precision highp float;)
+#endif
+OG_TO_STR(
+ uniform sampler2D uInputTex;
+ uniform vec2 uInputSize;
+ uniform vec2 uFrameSize;
+ uniform float uScale;
+ uniform float uFactor;
+ uniform float uOp;
+ uniform float uIsInput;
+ uniform vec4 uChannel;
+ varying vec2 vTexCoord;
+ uniform vec2 uSize;
+
+ // mean and mean of squares as 16 bit fixed point numbers
+ vec2 decodeMoments(vec4 c)
+ {
+     return (floor(c.rb * 255.0 + 0.5) * 256.0 + floor(c.ga * 255.0 + 0.5)) / 65535.0;
+ }
+
+ vec4 encodeMoments(vec2 m)
+ {
+     vec2 v = floor(clamp(m, 0.0, 1.0) * 65535.0 + 0.5);
+     vec2 hi = floor(v / 256.0);
+     return vec4(hi.x, v.x - hi.x * 256.0, hi.y, v.y - hi.y * 256.0) / 255.0;
+ }
+
+ void main()
+ {
+     vec2 t = floor(vTexCoord * uSize);
+     vec4 minValue = vec4(1.0);
+     vec4 maxValue = vec4(0.0);
+     vec2 moments = vec2(0.0);
+     float weight = 0.0;
+
+     for (int j = 0; j < 4; j++) {
+         for (int i = 0; i < 4; i++) {
+             vec2 q = t * uFactor + vec2(float(i), float(j));
+
+             // number of frame pixels below texel <q> of the lower level
+             vec2 cover = clamp(uFrameSize - q * uScale, 0.0, uScale);
+             float w = cover.x * cover.y;
+
+             if (float(i) < uFactor && float(j) < uFactor && w > 0.0) {
+                 vec4 c = texture2D(uInputTex, (q + 0.5) / uInputSize);
+                 float x = dot(c, uChannel);
+                 moments += w * ((uIsInput > 0.5) ? vec2(x, x * x) : decodeMoments(c));
+                 minValue = min(minValue, c);
+                 maxValue = max(maxValue, c);
+                 weight += w;
+             }
+         }
+     }
+
+     vec4 mask = vec4(notEqual(uChannel, vec4(0.0)));
+     if (uOp < 0.5) {
+         gl_FragColor = encodeMoments(moments / weight);
+     } else if (uOp < 1.5) {
+         gl_FragColor = minValue * mask;
+     } else {
+         gl_FragColor = maxValue * mask;
+     }
+});
+// clang-format on
+
+#pragma mark constructor/deconstructor
+
+ReduceProc::ReduceProc(ReduceOp op, int factor)
+    : op(op)
+    , factor(factor) {
+    assert(factor >= 2 && factor <= 4);
+
+    const GLfloat red[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+    setChannelMask(red);
+}
+
+ReduceProc::~ReduceProc() {
+    releaseLevels();
+}
+
+#pragma mark public methods
+
+int ReduceProc::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
+    FilterProcBase::setOutputSize(1, 1);
+
+    int result = FilterProcBase::init(inW, inH, order, prepareForExternalInput);
+
+    // the output is not an image: read it back without swizzling
+    fbo->getMemTransfer()->setOutputPixelFormat(GL_RGBA);
+
+    createLevels(inW, inH);
+
+    return result;
+}
+
+int ReduceProc::reinit(int inW, int inH, bool prepareForExternalInput) {
+    int result = FilterProcBase::reinit(inW, inH, prepareForExternalInput);
+
+    createLevels(inW, inH);
+
+    return result;
+}
+
+void ReduceProc::cleanup() {
+    releaseLevels();
+
+    FilterProcBase::cleanup();
+}
+
+int ReduceProc::render(int position) {
+    OG_LOGINF(getProcName(), "input tex %d, %d passes", texId, getNumPasses());
+
+    assert(texTarget == GL_TEXTURE_2D);
+
+    GLStateCache& glState = getGLState();
+
+    for (int i = 0; i < int(levelFBOs.size()); i++) {
+        FBO* level = levelFBOs[i];
+
+        level->bind();
+        glState.useProgram(shader->getProgramId());
+        glState.viewport(0, 0, level->getTexWidth(), level->getTexHeight());
+
+        setPassUniforms(i + 1);
+
+        filterRenderSetQuad(shParamAPos, shParamATexCoord, RenderOrientationStd);
+        filterRenderDraw();
+    }
+
+    if (!levelFBOs.empty()) {
+        levelFBOs.back()->unbind(); // the output pass clears the bound framebuffer
+    }
+    Tools::checkGLErr(getProcName(), "render levels");
+
+    return FilterProcBase::render(position);
+}
+
+void ReduceProc::setChannelMask(const GLfloat mask[4]) {
+    memcpy(channelMask, mask, sizeof(GLfloat) * 4);
+}
+
+void ReduceProc::getResult(float result[4]) const {
+    FrameDelegate delegate = [&](const Size2d& size, const void* pixels, size_t rowStride) {
+        getResult(op, static_cast<const unsigned char*>(pixels), inFrameW * inFrameH, result);
+    };
+
+    getResultData(delegate);
+    getMemTransferObj()->flushReadback(); // in case of multiple readback buffers
+}
+
+void ReduceProc::getResult(ReduceOp op, const unsigned char* pixel, int numPixels, float result[4]) {
+    if (op == ReduceMin || op == ReduceMax) {
+        for (int i = 0; i < 4; i++) {
+            result[i] = float(pixel[i]) / 255.f;
+        }
+        return;
+    }
+
+    const double mean = double(pixel[0] * 256 + pixel[1]) / 65535.0;
+    const double meanOfSquares = double(pixel[2] * 256 + pixel[3]) / 65535.0;
+
+    switch (op) {
+    case ReduceSum:
+        result[0] = float(mean * numPixels);
+        break;
+    case ReduceVariance:
+        result[0] = float(std::max(0.0, meanOfSquares - mean * mean));
+        break;
+    default:
+        result[0] = float(mean);
+        break;
+    }
+
+    result[1] = result[2] = result[3] = 0.f;
+}
+
+#pragma mark private methods
+
+void ReduceProc::getUniforms() {
+    FilterProcBase::getUniforms();
+
+    shParamUInputSize = shader->getParam(UNIF, "uInputSize");
+    shParamUFrameSize = shader->getParam(UNIF, "uFrameSize");
+    shParamUScale = shader->getParam(UNIF, "uScale");
+    shParamUFactor = shader->getParam(UNIF, "uFactor");
+    shParamUOp = shader->getParam(UNIF, "uOp");
+    shParamUIsInput = shader->getParam(UNIF, "uIsInput");
+    shParamUChannel = shader->getParam(UNIF, "uChannel");
+    shParamUSize = shader->getParam(UNIF, "uSize");
+}
+
+void ReduceProc::setUniforms() {
+    FilterProcBase::setUniforms();
+
+    setPassUniforms(getNumPasses());
+}
+
+void ReduceProc::createLevels(int inW, int inH) {
+    releaseLevels();
+
+    // each pass divides the size by <factor> until the 1x1 output is reached
+    int w = (inW + factor - 1) / factor, h = (inH + factor - 1) / factor;
+    while (w > 1 || h > 1) {
+        FBO* level = new FBO(core);
+        level->setGLTexUnit(1);
+        level->createAttachedTex(w, h, false);
+
+        // moments must not be interpolated
+        glBindTexture(GL_TEXTURE_2D, level->getAttachedTexId());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+
+        levelFBOs.push_back(level);
+
+        w = (w + factor - 1) / factor;
+        h = (h + factor - 1) / factor;
+    }
+
+    OG_LOGINF(getProcName(), "%d passes for input size %dx%d", getNumPasses(), inW, inH);
+}
+
+void ReduceProc::releaseLevels() {
+    for (auto level : levelFBOs) {
+        delete level;
+    }
+    levelFBOs.clear();
+}
+
+void ReduceProc::setPassUniforms(int pass) {
+    GLStateCache& glState = getGLState();
+
+    const FBO* output = (pass <= int(levelFBOs.size())) ? levelFBOs[pass - 1] : nullptr;
+    const FBO* input = (pass > 1) ? levelFBOs[pass - 2] : nullptr;
+
+    if (input) {
+        glState.bindTexture(texUnit, GL_TEXTURE_2D, input->getAttachedTexId());
+        glUniform2f(shParamUInputSize, float(input->getTexWidth()), float(input->getTexHeight()));
+    } else {
+        glState.bindTexture(texUnit, texTarget, texId);
+        glUniform2f(shParamUInputSize, float(inFrameW), float(inFrameH));
+    }
+
+    float scale = 1.f; // frame pixels per input texel
+    for (int i = 1; i < pass; i++) {
+        scale *= factor;
+    }
+
+    const bool isMoments = (op == ReduceSum || op == ReduceMean || op == ReduceVariance);
+
+    glUniform1i(shParamUInputTex, texUnit);
+    glUniform2f(shParamUFrameSize, float(inFrameW), float(inFrameH));
+    glUniform1f(shParamUScale, scale);
+    glUniform1f(shParamUFactor, float(factor));
+    glUniform1f(shParamUOp, isMoments ? 0.f : (op == ReduceMin) ? 1.f : 2.f);
+    glUniform1f(shParamUIsInput, (pass == 1) ? 1.f : 0.f);
+    glUniform4fv(shParamUChannel, 1, channelMask);
+    if (output) {
+        glUniform2f(shParamUSize, float(output->getTexWidth()), float(output->getTexHeight()));
+    } else {
+        glUniform2f(shParamUSize, float(outFrameW), float(outFrameH));
+    }
+}
@@ -0,0 +1,201 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * GPGPU reduction processor (sum, min, max, mean, variance).
+ */
+#ifndef OGLES_GPGPU_COMMON_PROC_REDUCE
+#define OGLES_GPGPU_COMMON_PROC_REDUCE
+
+#include "../common_includes.h"
+#include "base/filterprocbase.h"
+
+#include <vector>
+
+namespace ogles_gpgpu {
+
+/**
+ * Reduction operator of ReduceProc.
+ */
+typedef enum {
+    ReduceSum = 0, // sum of the weighted channels
+    ReduceMean, // mean of the weighted channels
+    ReduceVariance, // variance of the weighted channels
+    ReduceMin, // minimum of each channel
+    ReduceMax // maximum of each channel
+} ReduceOp;
+
+/**
+ * ReduceProc reduces the input frame to a single value (i.e. the mean
+ * brightness or the motion energy of a DiffProc output), so that a 1x1
+ * texture is read back instead of the whole frame.
+ *
+ * Each pass reduces blocks of <factor>x<factor> texels of the level below until
+ * the 1x1 output is reached. Border texels that cover fewer input pixels are
+ * weighted accordingly, so the result is exact for any frame size.
+ *
+ * ReduceSum, ReduceMean and ReduceVariance reduce the channels weighted with the
+ * channel mask (see setChannelMask()). The levels hold the mean and the mean of
+ * squares of this value as 16 bit fixed point numbers (red/green and blue/alpha,
+ * high byte first), so the weighted value must be in [0, 1].
+ * ReduceMin and ReduceMax reduce each channel with a non-zero weight (the other
+ * channels are 0).
+ *
+ * The output texture can be used by downstream procs, or it is read back and
+ * decoded by getResult().
+ */
+class ReduceProc : public FilterProcBase {
+public:
+    /**
+     * Constructor for operator <op> with <factor>x<factor> (2 to 4) texels per
+     * output texel of each pass.
+     */
+    ReduceProc(ReduceOp op = ReduceMean, int factor = 4);
+
+    /**
+     * Deconstructor.
+     */
+    virtual ~ReduceProc();
+
+    /**
+     * Return the processors name.
+     */
+    virtual const char* getProcName() {
+        return "ReduceProc";
+    }
+
+    /**
+     * The output depends on the whole input.
+     */
+    virtual int getRoiHalo() const {
+        return -1;
+    }
+
+    /**
+     * Init the processor for input frames of size <inW>x<inH> which is at
+     * position <order> in the processing pipeline.
+     */
+    virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput = false);
+
+    /**
+     * Reinitialize the proc for a different input frame size of <inW>x<inH>.
+     */
+    virtual int reinit(int inW, int inH, bool prepareForExternalInput = false);
+
+    /**
+     * Cleanup processor's resources.
+     */
+    virtual void cleanup();
+
+    /**
+     * Render all reduction passes.
+     */
+    virtual int render(int position = 0);
+
+    /**
+     * Set the reduction operator <op>.
+     */
+    void setOp(ReduceOp op) {
+        this->op = op;
+    }
+
+    /**
+     * Get the reduction operator.
+     */
+    ReduceOp getOp() const {
+        return op;
+    }
+
+    /**
+     * Set the RGBA channel weights to <mask> (default is the red channel only).
+     */
+    void setChannelMask(const GLfloat mask[4]);
+
+    /**
+     * Get the RGBA channel weights.
+     */
+    const GLfloat* getChannelMask() const {
+        return channelMask;
+    }
+
+    /**
+     * Get the number of reduction passes.
+     */
+    int getNumPasses() const {
+        return int(levelFBOs.size()) + 1;
+    }
+
+    /**
+     * Read the output and decode it to <result>: the RGBA values for ReduceMin and
+     * ReduceMax, the statistic in <result>[0] for the other operators.
+     */
+    void getResult(float result[4]) const;
+
+    /**
+     * Decode the output <pixel> (read back as GL_RGBA, i.e. passed to a FrameDelegate)
+     * of operator <op> for an input frame with <numPixels> pixels to <result>.
+     */
+    static void getResult(ReduceOp op, const unsigned char* pixel, int numPixels, float result[4]);
+
+private:
+    /**
+     * Output size is always 1x1.
+     */
+    virtual void setOutputSize(float scaleFactor) {}
+
+    /**
+     * Get the fragment shader source.
+     */
+    virtual const char* getFragmentShaderSource() {
+        return fshaderReduceSrc;
+    }
+
+    /**
+     * Get uniform indices.
+     */
+    virtual void getUniforms();
+
+    /**
+     * Set uniforms.
+     */
+    virtual void setUniforms();
+
+    /**
+     * Create the intermediate levels for input size <inW>x<inH>.
+     */
+    void createLevels(int inW, int inH);
+
+    /**
+     * Release the intermediate levels.
+     */
+    void releaseLevels();
+
+    /**
+     * Set the uniforms and bind the input of pass <pass> (starting with 1).
+     */
+    void setPassUniforms(int pass);
+
+    static const char* fshaderReduceSrc; // fragment shader source of all passes
+
+    ReduceOp op;
+    int factor;
+
+    GLfloat channelMask[4];
+
+    std::vector<FBO*> levelFBOs; // intermediate levels (the last one is the output fbo). strong refs.!
+
+    GLint shParamUInputSize;
+    GLint shParamUFrameSize;
+    GLint shParamUScale;
+    GLint shParamUFactor;
+    GLint shParamUOp;
+    GLint shParamUIsInput;
+    GLint shParamUChannel;
+    GLint shParamUSize;
+};
+}
+
+#endif
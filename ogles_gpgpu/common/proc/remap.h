@@ -21,6 +21,9 @@ public:
     virtual const char* getProcName() {
         return "RemapProc";
     }
+    virtual int getRoiHalo() const {
+        return -1; // the input is sampled at the coordinates of the map
+    }
 
 private:
     void filterShaderSetup(const char* vShaderSrc, const char* fShaderSrc, GLenum target);
@@ -20,6 +20,9 @@ public:
     virtual const char* getProcName() {
         return "Rgb2HsvProc";
     }
+    virtual bool getIsPointwise() const {
+        return true;
+    }
 
 private:
     virtual const char* getFragmentShaderSource() {
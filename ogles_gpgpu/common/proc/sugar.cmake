@@ -21,6 +21,8 @@ sugar_include(multipass)
 sugar_files(
     OGLES_GPGPU_SRCS
     adapt_thresh.h
+    batcher.cpp#
+    batcher.h#
     blend.cpp#
     blend.h#
     box_opt.h#
@@ -49,12 +51,18 @@ sugar_files(
     hessian.cpp#
     hessian.h#
     highpass.h#
+    histogram.cpp#
+    histogram.h#
+    histopyramid.cpp#
+    histopyramid.h#
     hsv2rgb.cpp#
     hsv2rgb.h#
     iir.cpp#
     iir.h#
     ixyt.cpp#
     ixyt.h#
+    klt.cpp#
+    klt.h#
     lnorm.h#
     lbp.cpp#
     lbp.h#
@@ -65,6 +73,8 @@ sugar_files(
     nms.h#
     pyramid.cpp#
     pyramid.h#
+    reduce.cpp#
+    reduce.h#
     remap.cpp#
     remap.h#
     rgb2hsv.cpp#
@@ -77,12 +87,16 @@ sugar_files(
     three.h#
     thresh.cpp#
     thresh.h#
+    tiler.cpp#
+    tiler.h#
     transform.cpp#
     transform.h#
     two.cpp#
     two.h#
     video.cpp#
     video.h#
+    video_worker.cpp#
+    video_worker.h#
     yuv2rgb.cpp#
     yuv2rgb.h#
 )
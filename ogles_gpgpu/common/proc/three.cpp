@@ -110,28 +110,32 @@ void ThreeInputProc::useTexture3(GLuint id, GLuint useTexUnit, GLenum target) {
 }
 
 void ThreeInputProc::filterRenderPrepare() {
-    shader->use();
+    GLStateCache& glState = getGLState();
+
+    glState.useProgram(shader->getProgramId());
+
+    // render to (and clear) the FBO, see FilterProcBase::filterRenderPrepare()
+    if (fbo) {
+        fbo->bind();
+    }
 
     // set the viewport
-    glViewport(0, 0, outFrameW, outFrameH);
+    glState.viewport(0, 0, outFrameW, outFrameH);
 
     glClear(GL_COLOR_BUFFER_BIT);
 
     // Bind input texture 1:
-    glActiveTexture(GL_TEXTURE0 + texUnit);
-    glBindTexture(texTarget, texId);
+    glState.bindTexture(texUnit, texTarget, texId);
     glUniform1i(shParamUInputTex, texUnit);
 
     // Bind input texture 2:
     texUnit2 = texUnit + 1;
-    glActiveTexture(GL_TEXTURE0 + texUnit2);
-    glBindTexture(texTarget2, texId2);
+    glState.bindTexture(texUnit2, texTarget2, texId2);
     glUniform1i(shParamUInputTex2, texUnit2);
 
     // Bind input texture 3:
     texUnit3 = texUnit + 2;
-    glActiveTexture(GL_TEXTURE0 + texUnit3);
-    glBindTexture(texTarget3, texId3);
+    glState.bindTexture(texUnit3, texTarget3, texId3);
     glUniform1i(shParamUInputTex3, texUnit3);
 }
 
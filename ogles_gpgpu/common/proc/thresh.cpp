@@ -40,41 +40,10 @@ ThreshProc::ThreshProc() {
     threshVal = 0.5f;
 }
 
-int ThreshProc::init(int inW, int inH, unsigned int order, bool prepareForExternalInput) {
-    OG_LOGINF(getProcName(), "initialize");
-
-    // create fbo for output
-    createFBO();
-
-    // parent init - set defaults
-    baseInit(inW, inH, order, prepareForExternalInput, procParamOutW, procParamOutH, procParamOutScale);
-
-    // FilterProcBase init - create shaders, get shader params, set buffers for OpenGL
-    filterInit(vshaderDefault, fshaderSimpleThreshSrc);
-
-    // get additional shader params
+void ThreshProc::getUniforms() {
     shParamUThresh = shader->getParam(UNIF, "uThresh");
-
-    return 1;
 }
 
-int ThreshProc::render(int position) {
-    OG_LOGINF(getProcName(), "input tex %d, target %d, framebuffer of size %dx%d", texId, texTarget, outFrameW, outFrameH);
-
-    filterRenderPrepare();
-
+void ThreshProc::setUniforms() {
     glUniform1f(shParamUThresh, threshVal); // thresholding value for simple thresholding
-
-    Tools::checkGLErr("ThreshProc", "render prepare");
-
-    filterRenderSetCoords();
-    Tools::checkGLErr("ThreshProc", "render set coords");
-
-    filterRenderDraw();
-    Tools::checkGLErr("ThreshProc", "render draw");
-
-    filterRenderCleanup();
-    Tools::checkGLErr("ThreshProc", "render cleanup");
-
-    return 0;
 }
@@ -39,6 +39,13 @@ public:
         return "ThreshProc";
     }
 
+    /**
+     * Point-wise filter (can be fused).
+     */
+    virtual bool getIsPointwise() const {
+        return true;
+    }
+
     /**
      * Set threshold as 8 bit value [0..255] <v> for simple thresholding.
      */
@@ -60,18 +67,24 @@ public:
         return threshVal;
     }
 
+private:
+    /**
+     * Get the fragment shader source.
+     */
+    virtual const char* getFragmentShaderSource() {
+        return fshaderSimpleThreshSrc;
+    }
+
     /**
-     * Init the processor for input frames of size <inW>x<inH> which is at
-     * position <order> in the processing pipeline.
+     * Get shader uniform id.
      */
-    virtual int init(int inW, int inH, unsigned int order, bool prepareForExternalInput = false);
+    virtual void getUniforms();
 
     /**
-     * Render the output.
+     * Set shader uniform values.
      */
-    virtual int render(int position = 0);
+    virtual void setUniforms();
 
-private:
     float threshVal; // thresholding value [0.0 .. 1.0]
 
     GLint shParamUThresh; // fixed threshold value
@@ -0,0 +1,145 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "tiler.h"
+#include "base/roiplanner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+BEGIN_OGLES_GPGPU
+
+Tiler::Tiler(void* glContext)
+    : video(glContext) {
+}
+
+void Tiler::set(ProcInterface* r, ProcInterface* o) {
+    root = r;
+    outputProc = o;
+    video.set(root);
+    video.setOutput(outputProc, [this](const Size2d& size, const void* pixels, size_t rowStride) {
+        onOutput(size, pixels, rowStride);
+    });
+}
+
+std::vector<Tiler::Span> Tiler::getSpans(int length, int tileLength, int halo, int align) {
+    std::vector<Span> spans;
+    for (int begin = 0; begin < length;) {
+        // the tile starts <halo> pixels before the stitched part and stays inside the image
+        int start = (begin == 0) ? 0 : (begin - halo) / align * align;
+        start = std::min(start, (length - tileLength) / align * align);
+
+        // the stitched part ends <halo> pixels before the end of the tile (or at the image border)
+        const int stop = start + tileLength;
+        const int end = (stop >= length) ? length : (stop - halo) / align * align;
+        if (end <= begin) {
+            return std::vector<Span>(); // tile is too small for the halo
+        }
+
+        spans.push_back({ start, begin, end });
+        begin = end;
+    }
+    return spans;
+}
+
+bool Tiler::operator()(const Size2d& size, const void* pixels, size_t rowStride, GLenum inputPixFormat) {
+    assert(root && outputProc);
+
+    if (inputPixFormat == 0) {
+        OG_LOGERR("Tiler", "YUV input can not be tiled");
+        return false;
+    }
+
+    GLint maxTexSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexSize);
+    const int limit = (maxTileSize > 0) ? std::min(maxTileSize, int(maxTexSize)) : int(maxTexSize);
+
+    // all tiles have the same size, so the graph is prepared once
+    const Size2d tileSize(std::min(size.width, limit), std::min(size.height, limit));
+    video.configure(tileSize, inputPixFormat);
+
+    halo = RoiPlanner().getHalo(root, outputProc);
+    if (halo < 0) {
+        OG_LOGERR("Tiler", "the output of %s depends on the whole input", outputProc->getProcName());
+        return false;
+    }
+
+    // tiles of a downscaled output start at multiples of the scale factor
+    outputScaleX = float(outputProc->getOutFrameW()) / float(tileSize.width);
+    outputScaleY = float(outputProc->getOutFrameH()) / float(tileSize.height);
+    const int alignX = std::max(int(std::round(1.f / outputScaleX)), 1);
+    const int alignY = std::max(int(std::round(1.f / outputScaleY)), 1);
+
+    // the last tile ends at the image border only if both sizes are aligned
+    const bool tiledX = size.width > tileSize.width, tiledY = size.height > tileSize.height;
+    if ((tiledX && tileSize.width % alignX) || (tiledY && tileSize.height % alignY)) {
+        OG_LOGERR("Tiler", "tile size %dx%d must be a multiple of the output scale 1/%dx1/%d", tileSize.width, tileSize.height, alignX, alignY);
+        return false;
+    }
+    if ((tiledX && size.width % alignX) || (tiledY && size.height % alignY)) {
+        OG_LOGERR("Tiler", "image size %dx%d must be a multiple of the output scale 1/%dx1/%d", size.width, size.height, alignX, alignY);
+        return false;
+    }
+
+    const std::vector<Span> spansX = getSpans(size.width, tileSize.width, halo, alignX);
+    const std::vector<Span> spansY = getSpans(size.height, tileSize.height, halo, alignY);
+    if (spansX.empty() || spansY.empty()) {
+        OG_LOGERR("Tiler", "tile size %dx%d is too small for a halo of %d pixels", tileSize.width, tileSize.height, halo);
+        return false;
+    }
+
+    outputSize = Size2d(int(std::round(size.width * outputScaleX)), int(std::round(size.height * outputScaleY)));
+    output.resize(size_t(outputSize.width) * outputSize.height * 4);
+
+    const size_t inputRowStride = (rowStride > 0) ? rowStride : size_t(size.width) * 4;
+    const unsigned char* data = static_cast<const unsigned char*>(pixels);
+
+    numTiles = 0;
+    for (auto& y : spansY) {
+        for (auto& x : spansX) {
+            pendingTiles.push_back({ x, y });
+
+            // upload the tile from the image (with the row stride of the image)
+            unsigned char* tilePixels = const_cast<unsigned char*>(data + y.start * inputRowStride + x.start * 4);
+            video({ tileSize, tilePixels, true, 0, inputPixFormat, inputRowStride });
+
+            numTiles++;
+        }
+    }
+
+    // deliver the tiles in flight
+    video.flush();
+
+    return true;
+}
+
+void Tiler::onOutput(const Size2d& size, const void* pixels, size_t rowStride) {
+    assert(!pendingTiles.empty());
+
+    const Tile tile = pendingTiles.front();
+    pendingTiles.pop_front();
+
+    // stitched part in output pixels of the image and of the tile
+    const int x0 = int(std::round(tile.x.begin * outputScaleX));
+    const int x1 = std::min(int(std::round(tile.x.end * outputScaleX)), outputSize.width);
+    const int y0 = int(std::round(tile.y.begin * outputScaleY));
+    const int y1 = std::min(int(std::round(tile.y.end * outputScaleY)), outputSize.height);
+    const int tileX = int(std::round(tile.x.start * outputScaleX));
+    const int tileY = int(std::round(tile.y.start * outputScaleY));
+
+    const int width = std::min(x1, tileX + size.width) - x0;
+    if (width <= 0) {
+        return;
+    }
+
+    const unsigned char* src = static_cast<const unsigned char*>(pixels);
+    for (int y = y0; y < std::min(y1, tileY + size.height); y++) {
+        memcpy(&output[(size_t(y) * outputSize.width + x0) * 4], src + (y - tileY) * rowStride + (x0 - tileX) * 4, size_t(width) * 4);
+    }
+}
+
+END_OGLES_GPGPU
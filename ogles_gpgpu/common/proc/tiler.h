@@ -0,0 +1,144 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Tiled processing of images that exceed the maximum texture size.
+ */
+#ifndef OGLES_GPGPU_COMMON_TILER
+#define OGLES_GPGPU_COMMON_TILER
+
+#include "../common_includes.h"
+#include "video.h"
+
+#include <deque>
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+/**
+ * Tiler processes an image that is larger than GL_MAX_TEXTURE_SIZE (or than a given
+ * tile size) with a filter graph in overlapping tiles and stitches the output of the
+ * output proc. The tiles overlap by the halo that the graph reads around each pixel
+ * (see RoiPlanner::getHalo()), so that the stitched output is the same as for the
+ * whole image. All tiles have the same size, so the graph is prepared once and the
+ * GPU memory is bounded by the tile size.
+ *
+ * Graphs with procs that read their whole input (i.e. PyramidProc, ReduceProc) on the
+ * path to the output proc can not be tiled. For outputs that are scaled down by a
+ * factor of n, the tiles start at multiples of n input pixels, so the size of a tiled
+ * image (and of its tiles) must be a multiple of n.
+ */
+class Tiler {
+public:
+    /**
+     * Constructor. Processing is done by a VideoSource in the current OpenGL context
+     * or in <glContext> (see VideoSource::init()).
+     */
+    Tiler(void* glContext = nullptr);
+
+    /**
+     * Set the filter graph that starts at <root>. The output of <output> is stitched.
+     */
+    void set(ProcInterface* root, ProcInterface* output);
+
+    /**
+     * Limit the tiles (incl. the halo) to <size>x<size> pixels. With 0 (default),
+     * the limit is GL_MAX_TEXTURE_SIZE.
+     */
+    void setMaxTileSize(int size) {
+        maxTileSize = size;
+    }
+
+    /**
+     * Get the tile size limit (0 for GL_MAX_TEXTURE_SIZE).
+     */
+    int getMaxTileSize() const {
+        return maxTileSize;
+    }
+
+    /**
+     * Process the image <pixels> of size <size> with <rowStride> bytes per row (0: tightly
+     * packed) and the 4 channel pixel format <inputPixFormat>. Returns false if the image
+     * can not be tiled for the filter graph.
+     */
+    bool operator()(const Size2d& size, const void* pixels, size_t rowStride = 0, GLenum inputPixFormat = DFLT_PIX_FORMAT);
+
+    /**
+     * Get the stitched output of the output proc (4 bytes per pixel, tightly packed).
+     */
+    const std::vector<unsigned char>& getOutput() const {
+        return output;
+    }
+
+    /**
+     * Get the size of the stitched output.
+     */
+    const Size2d& getOutputSize() const {
+        return outputSize;
+    }
+
+    /**
+     * Get the halo (in input pixels) of the last processed image.
+     */
+    int getHalo() const {
+        return halo;
+    }
+
+    /**
+     * Get the number of tiles of the last processed image.
+     */
+    int getNumTiles() const {
+        return numTiles;
+    }
+
+    /**
+     * Get the VideoSource that processes the tiles (i.e. to set its options).
+     */
+    VideoSource& getVideoSource() {
+        return video;
+    }
+
+private:
+    struct Span {
+        int start; // first input pixel of the tile
+        int begin; // first input pixel that is stitched
+        int end; // input pixel after the last one that is stitched
+    };
+
+    struct Tile {
+        Span x, y;
+    };
+
+    /**
+     * Split <length> input pixels into spans of tiles with <tileLength> pixels that overlap
+     * by <halo> pixels and start at multiples of <align>.
+     */
+    static std::vector<Span> getSpans(int length, int tileLength, int halo, int align);
+
+    /**
+     * Copy the stitched part of the output of the oldest pending tile.
+     */
+    void onOutput(const Size2d& size, const void* pixels, size_t rowStride);
+
+    VideoSource video;
+    ProcInterface* root = nullptr; // first proc of the filter graph. weak ref.
+    ProcInterface* outputProc = nullptr; // weak ref.
+
+    int maxTileSize = 0;
+
+    std::deque<Tile> pendingTiles; // tiles in flight (in order of processing)
+
+    std::vector<unsigned char> output;
+    Size2d outputSize;
+    float outputScaleX = 1.f, outputScaleY = 1.f; // output size / input size of a tile
+
+    int halo = 0;
+    int numTiles = 0;
+};
+
+END_OGLES_GPGPU
+
+#endif // OGLES_GPGPU_COMMON_TILER
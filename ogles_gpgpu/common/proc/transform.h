@@ -40,6 +40,13 @@ public:
         return "TransformProc";
     }
 
+    /**
+     * An output pixel may depend on any input pixel.
+     */
+    virtual int getRoiHalo() const {
+        return -1;
+    }
+
     /**
      * Get the fragment shader source.
      */
@@ -99,22 +99,27 @@ void TwoInputProc::useTexture2(GLuint id, GLuint useTexUnit, GLenum target) {
 }
 
 void TwoInputProc::filterRenderPrepare() {
-    shader->use();
+    GLStateCache& glState = getGLState();
+
+    glState.useProgram(shader->getProgramId());
+
+    // render to (and clear) the FBO, see FilterProcBase::filterRenderPrepare()
+    if (fbo) {
+        fbo->bind();
+    }
 
     // set the viewport
-    glViewport(0, 0, outFrameW, outFrameH);
+    glState.viewport(0, 0, outFrameW, outFrameH);
 
     glClear(GL_COLOR_BUFFER_BIT);
 
     // Bind input texture 1:
-    glActiveTexture(GL_TEXTURE0 + texUnit);
-    glBindTexture(texTarget, texId);
+    glState.bindTexture(texUnit, texTarget, texId);
     glUniform1i(shParamUInputTex, texUnit);
 
     // Bind input texture 2:
     texUnit2 = texUnit + 1;
-    glActiveTexture(GL_TEXTURE0 + texUnit2);
-    glBindTexture(texTarget2, texId2);
+    glState.bindTexture(texUnit2, texTarget2, texId2);
     glUniform1i(shParamUInputTex2, texUnit2);
 }
 
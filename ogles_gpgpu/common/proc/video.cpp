@@ -21,15 +21,24 @@ VideoSource::VideoSource(void* glContext, const Size2d& size, GLenum inputPixFor
 }
 
 VideoSource::~VideoSource() {
-    Core::getInstance()->reset();
+    // the output proc may already be destroyed: drop the frames in flight
+#ifdef OGLES_GPGPU_FENCE_SYNC
+    for (auto& frame : pendingFrames) {
+        if (frame.fence) {
+            glDeleteSync(frame.fence);
+        }
+    }
+#endif
+    pendingFrames.clear();
+
+    core.reset();
 }
 
 void VideoSource::init(void* glContext) {
-    auto* gpgpu = Core::getInstance();
-    Core::tryEnablePlatformOptimizations();
-    Core::getInstance()->setUseMipmaps(false); // TODO
+    core.tryEnablePlatformOptimizations();
+    core.setUseMipmaps(false); // TODO
     // pipeline
-    gpgpu->init(glContext);
+    core.init(glContext);
 }
 
 VideoSource::VideoSource(const Size2d& size, GLenum inputPixFormat) {
@@ -45,6 +54,7 @@ void VideoSource::configurePipeline(const Size2d& size, GLenum inputPixFormat) {
     if (inputPixFormat == 0) { // 0 == NV{12,21}
         if (!yuv2RgbProc) {
             yuv2RgbProc = std::make_shared<ogles_gpgpu::Yuv2RgbProc>();
+            yuv2RgbProc->setCore(&core);
             yuv2RgbProc->setExternalInputDataFormat(inputPixFormat);
             yuv2RgbProc->init(size.width, size.height, 0, true);
             frameSize = size;
@@ -57,24 +67,49 @@ void VideoSource::configurePipeline(const Size2d& size, GLenum inputPixFormat) {
         yuv2RgbProc->createFBOTex(false); // TODO: mipmapping?
     }
 
-    ogles_gpgpu::Core::tryEnablePlatformOptimizations();
+    core.tryEnablePlatformOptimizations();
 
     assert(pipeline);
     if (pipeline != nullptr) {
         pipeline->prepare(size.width, size.height, inputPixFormat);
+
+        if (core.getUseMemoryPlanner()) {
+            core.planMemory(pipeline);
+        }
+
+        if (core.getRoiDirty() || core.getRoi().width > 0) {
+            core.planRoi(pipeline); // the region is scaled to the new frame size
+        }
     }
     frameSize = size;
 }
 
+void VideoSource::configure(const Size2d& size, GLenum inputPixFormat) {
+    if (firstFrame || size != frameSize) {
+        flush(); // the output of the frames in flight is released on reconfiguration
+        configurePipeline(size, inputPixFormat);
+        firstFrame = false;
+    }
+}
+
 void VideoSource::set(ProcInterface* p) {
     pipeline = p;
+    if (pipeline) {
+        pipeline->setCore(&core);
+    }
 }
 
-void VideoSource::operator()(const FrameInput& frame) {
-    return (*this)(frame.size, frame.pixelBuffer, frame.useRawPixels, frame.inputTexture, frame.textureFormat);
+void VideoSource::operator()(const Size2d& size, void* pixelBuffer, bool useRawPixels, GLuint inputTexture, GLenum inputPixFormat) {
+    return (*this)(FrameInput(size, pixelBuffer, useRawPixels, inputTexture, inputPixFormat));
 }
 
-void VideoSource::operator()(const Size2d& size, void* pixelBuffer, bool useRawPixels, GLuint inputTexture, GLenum inputPixFormat) {
+void VideoSource::operator()(const FrameInput& frame) {
+    const Size2d& size = frame.size;
+    void* pixelBuffer = frame.pixelBuffer;
+    const bool useRawPixels = frame.useRawPixels;
+    GLuint inputTexture = frame.inputTexture;
+    const GLenum inputPixFormat = frame.textureFormat;
+
     preConfig();
 
     if (m_timer)
@@ -82,15 +117,22 @@ void VideoSource::operator()(const Size2d& size, void* pixelBuffer, bool useRawP
 
     assert(pipeline);
 
-    if (firstFrame || size != frameSize) {
-        configurePipeline(size, inputPixFormat);
-        firstFrame = false;
+    configure(size, inputPixFormat);
+
+    if (core.getRoiDirty()) {
+        core.planRoi(pipeline);
     }
 
     auto gpgpuInputHandler = pipeline->getInputMemTransferObj();
     gpgpuInputHandler->setUseRawPixels(useRawPixels);
 
-    // on each new frame, this will release the input buffers and textures, and prepare new ones
+    if (framesInFlight > 1) {
+        // each frame in flight is uploaded to its own pixel buffer
+        gpgpuInputHandler->setUploadBuffers(framesInFlight);
+    }
+
+    // on each new frame, this will prepare the input buffers and textures
+    // (the generic MemTransfer only reallocates them if the frame size or format changed)
     // texture format must be GL_BGRA because this is one of the native camera formats (see initCam)
     if (pixelBuffer) {
         if (inputPixFormat == 0) {
@@ -101,6 +143,10 @@ void VideoSource::operator()(const Size2d& size, void* pixelBuffer, bool useRawP
             }
             manager->prepareInput(frameSize.width, frameSize.height, inputPixFormat, pixelBuffer);
 
+            // the conversion is rendered before beginFrame(): forget the state that the
+            // application and the upload above changed outside of the cache
+            core.getGLState().invalidate();
+
             yuv2RgbProc->setTextures(manager->getLuminanceTexId(), manager->getChrominanceTexId());
             yuv2RgbProc->render();
             //glFinish();
@@ -109,6 +155,7 @@ void VideoSource::operator()(const Size2d& size, void* pixelBuffer, bool useRawP
             inputTexture = yuv2RgbProc->getOutputTexId(); // override input parameter
         } else {
             gpgpuInputHandler->prepareInput(frameSize.width, frameSize.height, inputPixFormat, pixelBuffer);
+            gpgpuInputHandler->setInputRowStride(frame.rowStride);
             setInputData(reinterpret_cast<const unsigned char*>(pixelBuffer));
             inputTexture = gpgpuInputHandler->getInputTexId(); // override input parameter
         }
@@ -118,7 +165,18 @@ void VideoSource::operator()(const Size2d& size, void* pixelBuffer, bool useRawP
         m_timer("process");
 
     assert(inputTexture); // inputTexture must be defined at this point
+    core.beginFrame();
     pipeline->process(inputTexture, 1, GL_TEXTURE_2D, 0, 0, m_timer);
+    core.endFrame();
+
+    if (outputProc) {
+        // issue the readback. with one more buffer than frames in flight, the readback
+        // ring does not deliver by itself: the output is delivered by finishFrame()
+        outputProc->getMemTransferObj()->setReadbackBuffers(framesInFlight + 1);
+        outputProc->getResultData(outputDelegate);
+    }
+
+    submitFrame();
 
     if (m_timer)
         m_timer("end");
@@ -126,6 +184,75 @@ void VideoSource::operator()(const Size2d& size, void* pixelBuffer, bool useRawP
     postConfig();
 }
 
+void VideoSource::setFramesInFlight(int n) {
+    assert(n > 0);
+    flush();
+    framesInFlight = n;
+}
+
+void VideoSource::setOutput(ProcInterface* proc, const MemTransfer::FrameDelegate& delegate) {
+    flush();
+    outputProc = proc;
+    outputDelegate = delegate;
+}
+
+void VideoSource::flush() {
+    while (!pendingFrames.empty()) {
+        finishFrame();
+    }
+}
+
+void VideoSource::submitFrame() {
+    PendingFrame frame;
+
+#ifdef OGLES_GPGPU_FENCE_SYNC
+    if (framesInFlight > 1) {
+        frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush(); // start the GPU work now, so that the fence can signal without another flush
+    }
+#endif
+
+    frame.hasOutput = (outputProc != nullptr);
+    pendingFrames.push_back(frame);
+
+    // deliver the finished frames, wait for the oldest ones while there are too many in flight
+    while (!pendingFrames.empty() && ((int)pendingFrames.size() >= framesInFlight || getOldestFrameIsFinished())) {
+        finishFrame();
+    }
+}
+
+void VideoSource::finishFrame() {
+    assert(!pendingFrames.empty());
+
+    PendingFrame frame = pendingFrames.front();
+    pendingFrames.pop_front();
+
+#ifdef OGLES_GPGPU_FENCE_SYNC
+    if (frame.fence) {
+        // wait in steps of 1s
+        while (glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED) {
+        }
+        glDeleteSync(frame.fence);
+    }
+#endif
+
+    if (frame.hasOutput && outputProc) {
+        outputProc->getMemTransferObj()->deliverReadback();
+    }
+}
+
+bool VideoSource::getOldestFrameIsFinished() const {
+#ifdef OGLES_GPGPU_FENCE_SYNC
+    const GLsync fence = pendingFrames.front().fence;
+    if (fence) {
+        const GLenum result = glClientWaitSync(fence, 0, 0);
+        return (result == GL_ALREADY_SIGNALED) || (result == GL_CONDITION_SATISFIED);
+    }
+#endif
+
+    return false;
+}
+
 void VideoSource::setInputData(const unsigned char* data) {
 
 #if 1
@@ -13,12 +13,19 @@
 #define OGLES_GPGPU_COMMON_VIDEO
 
 #include "../common_includes.h"
+#include "../core.h"
 #include "base/procbase.h"
 #include "base/procinterface.h"
 #include "yuv2rgb.h"
 
+#include <deque>
 #include <memory>
 
+// fence sync objects (glFenceSync()) are available?
+#if defined(OGLES_GPGPU_OPENGL) && !defined(__APPLE__) && defined(GL_SYNC_GPU_COMMANDS_COMPLETE)
+#define OGLES_GPGPU_FENCE_SYNC 1
+#endif
+
 BEGIN_OGLES_GPGPU
 
 #if __ANDROID__
@@ -29,12 +36,13 @@ BEGIN_OGLES_GPGPU
 
 struct FrameInput {
     FrameInput() {}
-    FrameInput(const Size2d& size, void* pixelBuffer, bool useRawPixels, GLuint inputTexture, GLenum textureFormat)
+    FrameInput(const Size2d& size, void* pixelBuffer, bool useRawPixels, GLuint inputTexture, GLenum textureFormat, size_t rowStride = 0)
         : size(size)
         , pixelBuffer(pixelBuffer)
         , useRawPixels(useRawPixels)
         , inputTexture(inputTexture)
-        , textureFormat(textureFormat) {
+        , textureFormat(textureFormat)
+        , rowStride(rowStride) {
     }
 
     Size2d size;
@@ -42,6 +50,7 @@ struct FrameInput {
     bool useRawPixels = false;
     GLuint inputTexture = 0;
     GLenum textureFormat = 0;
+    size_t rowStride = 0; // bytes per row of <pixelBuffer> (0: tightly packed)
 };
 
 /**
@@ -70,19 +79,97 @@ public:
 
     virtual void postConfig() {}
 
+    /**
+     * Set the filter graph <p> that will be fed by this source. The graph
+     * is bound to the processing context of this source.
+     */
     void set(ProcInterface* p);
 
+    /**
+     * Get the processing context owned by this source.
+     */
+    Core& getCore() {
+        return core;
+    }
+
     void setLogger(Timer& timer) {
         m_timer = timer;
     }
 
     GLuint getInputTexId();
 
+    /**
+     * Prepare the filter graph for input frames of size <size> with the format <inputPixFormat>
+     * (if it is not prepared for them yet). This is done by operator() for each frame, but it
+     * can be called before, i.e. to get the output sizes of the procs.
+     */
+    void configure(const Size2d& size, GLenum inputPixFormat = DFLT_PIX_FORMAT);
+
+    /**
+     * Keep up to <n> frames in flight (default: 1, i.e. each frame is finished
+     * before operator() returns). With <n> > 1, operator() returns as soon as the
+     * frame is submitted, so that the upload, rendering and readback of consecutive
+     * frames overlap. Each frame is uploaded to its own pixel buffer and finished
+     * frames are detected with a fence. The output (see setOutput()) of a frame is
+     * delivered when it is finished on the GPU, at most <n> - 1 frames later.
+     */
+    void setFramesInFlight(int n);
+
+    /**
+     * Get the maximum number of frames in flight.
+     */
+    int getFramesInFlight() const {
+        return framesInFlight;
+    }
+
+    /**
+     * Get the number of submitted frames that were not finished yet.
+     */
+    int getNumFramesPending() const {
+        return (int)pendingFrames.size();
+    }
+
+    /**
+     * Read the result of <proc> for each frame and pass it to <delegate>
+     * (in order of the frames). Set <proc> to nullptr to disable the output.
+     */
+    void setOutput(ProcInterface* proc, const MemTransfer::FrameDelegate& delegate);
+
+    /**
+     * Wait until all frames in flight are finished and deliver their output.
+     */
+    void flush();
+
 protected:
+    struct PendingFrame {
+#ifdef OGLES_GPGPU_FENCE_SYNC
+        GLsync fence = 0; // signaled when the frame is finished
+#endif
+        bool hasOutput = false; // readback of the output was issued
+    };
+
+    /**
+     * Add the frame that was just submitted to the frames in flight. Delivers
+     * all finished frames and waits for the oldest ones if there are too many.
+     */
+    void submitFrame();
+
+    /**
+     * Wait until the oldest pending frame is finished and deliver its output.
+     */
+    void finishFrame();
+
+    /**
+     * Returns true if the oldest pending frame is finished (without waiting).
+     */
+    bool getOldestFrameIsFinished() const;
+
     Timer m_timer;
 
     void* glContext = nullptr;
 
+    Core core; // processing context of this source
+
     void setInputData(const unsigned char* data);
 
     void configurePipeline(const Size2d& size, GLenum inputPixFormat);
@@ -94,6 +181,14 @@ protected:
     ProcInterface* pipeline = nullptr;
 
     std::shared_ptr<ogles_gpgpu::Yuv2RgbProc> yuv2RgbProc;
+
+    int framesInFlight = 1; // maximum number of frames in flight
+
+    std::deque<PendingFrame> pendingFrames; // frames in flight (oldest first)
+
+    ProcInterface* outputProc = nullptr; // weak ref.
+
+    MemTransfer::FrameDelegate outputDelegate; // receives the output of <outputProc>
 };
 
 END_OGLES_GPGPU
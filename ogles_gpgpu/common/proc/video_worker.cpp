@@ -0,0 +1,279 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "video_worker.h"
+
+#include <chrono>
+#include <cstring>
+
+#if defined(OGLES_GPGPU_HEADLESS)
+#include "../../platform/opengl/headless.h"
+#endif
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+// sleep time of the idle worker thread
+static const std::chrono::microseconds kIdleSleep(100);
+
+#pragma mark constructor/deconstructor
+
+VideoWorker::VideoWorker(int capacity, VideoWorkerBackpressure backpressure)
+    : capacity(capacity)
+    , backpressure(backpressure)
+    , slots(capacity + 1)
+    , head(0)
+    , tail(0)
+    , busy(0)
+    , running(false)
+    , numDropped(0)
+    , numProcessed(0) {
+    assert(capacity > 0);
+}
+
+VideoWorker::~VideoWorker() {
+    stop();
+}
+
+#pragma mark public methods
+
+void VideoWorker::setContextFuncs(const ContextFunc& activate, const ContextFunc& deactivate) {
+    assert(!running);
+
+    activateContext = activate;
+    deactivateContext = deactivate;
+}
+
+bool VideoWorker::start(const SetupFunc& setup, const TeardownFunc& teardown) {
+    assert(!running && setup);
+
+    head = tail = busy = 0;
+    nextIndex = 0;
+    numDropped = numProcessed = 0;
+
+    running = true;
+
+    std::promise<bool> started;
+    std::future<bool> result = started.get_future();
+    thread = std::thread(&VideoWorker::run, this, setup, teardown, &started);
+
+    if (!result.get()) {
+        thread.join();
+        running = false;
+        return false;
+    }
+
+    return true;
+}
+
+void VideoWorker::stop() {
+    if (thread.joinable()) {
+        running = false;
+        thread.join();
+    }
+}
+
+std::future<VideoWorkerResult> VideoWorker::submit(const FrameInput& frame) {
+    std::promise<VideoWorkerResult> promise;
+    std::future<VideoWorkerResult> result = promise.get_future();
+
+    if (!push(frame, &promise, nullptr)) {
+        return std::future<VideoWorkerResult>();
+    }
+
+    return result;
+}
+
+bool VideoWorker::submit(const FrameInput& frame, const ResultCallback& callback) {
+    return push(frame, nullptr, callback);
+}
+
+#pragma mark private methods
+
+bool VideoWorker::push(const FrameInput& frame, std::promise<VideoWorkerResult>* promise, const ResultCallback& callback) {
+    if (!running) {
+        return false;
+    }
+
+    // wait for a free slot or drop the oldest frame
+    const unsigned long long h = head.load(std::memory_order_relaxed);
+    for (;;) {
+        unsigned long long t = tail.load(std::memory_order_acquire);
+        if (h - t >= (unsigned long long)capacity) {
+            if (backpressure == VideoWorkerDropOldest) {
+                // claim the oldest slot (the worker may take it first)
+                if (tail.compare_exchange_strong(t, t + 1, std::memory_order_acq_rel)) {
+                    Slot& slot = slots[t % slots.size()];
+                    PendingResult pending{ slot.index, slot.hasPromise, std::move(slot.promise), std::move(slot.callback) };
+
+                    VideoWorkerResult result;
+                    result.index = pending.index;
+                    result.dropped = true;
+                    complete(pending, result);
+
+                    numDropped++;
+                }
+            } else {
+                std::this_thread::yield();
+            }
+            continue;
+        }
+
+        // after dropping frames, the slot may still be copied by the worker (only for a moment)
+        const unsigned long long b = busy.load(std::memory_order_acquire);
+        if (b != 0 && (h - (b - 1)) % slots.size() == 0) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        break;
+    }
+
+    // copy the frame into the slot
+    Slot& slot = slots[h % slots.size()];
+    slot.frame = frame;
+
+    if (frame.pixelBuffer) {
+        size_t numBytes = 0;
+        if (frame.textureFormat == 0) { // NV{12,21}
+            numBytes = (size_t)frame.size.width * frame.size.height * 3 / 2;
+        } else {
+            const size_t rowBytes = (size_t)frame.size.width * MemTransfer::getBytesPerPixel(frame.textureFormat);
+            const size_t rowStride = (frame.rowStride > 0) ? frame.rowStride : rowBytes;
+            numBytes = rowStride * (frame.size.height - 1) + rowBytes;
+        }
+
+        slot.pixels.resize(numBytes); // noop after the first frames of the same size
+        memcpy(&slot.pixels[0], frame.pixelBuffer, numBytes);
+        slot.frame.pixelBuffer = &slot.pixels[0];
+    }
+
+    slot.index = nextIndex++;
+    slot.hasPromise = (promise != nullptr);
+    slot.promise = promise ? std::move(*promise) : std::promise<VideoWorkerResult>();
+    slot.callback = callback;
+
+    // publish the slot
+    head.store(h + 1, std::memory_order_release);
+
+    return true;
+}
+
+void VideoWorker::complete(PendingResult& pending, VideoWorkerResult& result) {
+    if (pending.hasPromise) {
+        pending.promise.set_value(std::move(result));
+    } else if (pending.callback) {
+        pending.callback(result);
+    }
+}
+
+void VideoWorker::run(SetupFunc setup, TeardownFunc teardown, std::promise<bool>* started) {
+    // activate the context on this thread
+#if defined(OGLES_GPGPU_HEADLESS)
+    HeadlessContext headless;
+#endif
+
+    bool activated = false;
+    if (activateContext) {
+        activated = activateContext();
+    } else {
+#if defined(OGLES_GPGPU_HEADLESS)
+        activated = headless.setup();
+#else
+        OG_LOGERR("VideoWorker", "no context functions set");
+#endif
+    }
+
+    if (!activated) {
+        OG_LOGERR("VideoWorker", "could not activate the OpenGL context");
+        started->set_value(false);
+        return;
+    }
+
+    {
+        FrameInput frame; // frame in process
+        std::vector<unsigned char> framePixels; // input data of <frame> (swapped with the slot)
+
+        VideoSource video;
+        ProcInterface* outputProc = setup(video);
+        video.setFramesInFlight(framesInFlight);
+        if (outputProc) {
+            video.setOutput(outputProc, [this](const Size2d& size, const void* pixels, size_t rowStride) {
+                onOutput(size, pixels, rowStride);
+            });
+        }
+
+        started->set_value(true); // <started> is invalid from here on
+
+        for (;;) {
+            unsigned long long t = tail.load(std::memory_order_acquire);
+            const unsigned long long h = head.load(std::memory_order_acquire);
+
+            if (t == h) {
+                if (!running) {
+                    break;
+                }
+
+                // idle: deliver the frames in flight, then wait for new frames
+                video.flush();
+                std::this_thread::sleep_for(kIdleSleep);
+                continue;
+            }
+
+            // claim the oldest slot (the producer may drop it first)
+            busy.store(t + 1, std::memory_order_seq_cst);
+            if (!tail.compare_exchange_strong(t, t + 1, std::memory_order_acq_rel)) {
+                busy.store(0, std::memory_order_release);
+                continue;
+            }
+
+            // take over the slot, so that the producer can reuse it
+            Slot& slot = slots[t % slots.size()];
+            frame = slot.frame;
+            if (frame.pixelBuffer) {
+                framePixels.swap(slot.pixels);
+                frame.pixelBuffer = &framePixels[0];
+            }
+            pendingResults.push_back(PendingResult{ slot.index, slot.hasPromise, std::move(slot.promise), std::move(slot.callback) });
+
+            busy.store(0, std::memory_order_release);
+
+            video(frame);
+            numProcessed++;
+
+            if (!outputProc) {
+                // no output: the frame is done when it is submitted
+                VideoWorkerResult result;
+                result.index = pendingResults.front().index;
+                complete(pendingResults.front(), result);
+                pendingResults.pop_front();
+            }
+        }
+
+        video.flush();
+
+        if (teardown) {
+            teardown();
+        }
+    }
+
+    if (deactivateContext) {
+        deactivateContext();
+    }
+}
+
+void VideoWorker::onOutput(const Size2d& size, const void* pixels, size_t rowStride) {
+    assert(!pendingResults.empty());
+
+    VideoWorkerResult result;
+    result.index = pendingResults.front().index;
+    result.size = size;
+    result.rowStride = rowStride;
+    result.pixels.assign((const unsigned char*)pixels, (const unsigned char*)pixels + rowStride * size.height);
+
+    complete(pendingResults.front(), result);
+    pendingResults.pop_front();
+}
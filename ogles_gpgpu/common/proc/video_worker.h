@@ -0,0 +1,201 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Process frames of a VideoSource on a dedicated OpenGL thread.
+ */
+#ifndef OGLES_GPGPU_COMMON_VIDEO_WORKER
+#define OGLES_GPGPU_COMMON_VIDEO_WORKER
+
+#include "../common_includes.h"
+#include "video.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <thread>
+#include <vector>
+
+BEGIN_OGLES_GPGPU
+
+/**
+ * Behaviour of VideoWorker::submit() if the queue is full.
+ */
+typedef enum {
+    VideoWorkerBlock = 0, // wait until the worker takes a frame from the queue
+    VideoWorkerDropOldest // drop the oldest frame in the queue
+} VideoWorkerBackpressure;
+
+/**
+ * Result of a frame that was submitted to a VideoWorker.
+ */
+struct VideoWorkerResult {
+    long long index = -1; // frame number (in order of the submit() calls)
+    bool dropped = false; // frame was dropped by the backpressure policy
+    Size2d size; // size of the output
+    size_t rowStride = 0; // bytes per row of <pixels>
+    std::vector<unsigned char> pixels; // output of the output proc (empty if there is none)
+};
+
+/**
+ * VideoWorker owns an OpenGL context and a VideoSource on a dedicated thread.
+ * Frames are submitted from a producer thread (i.e. a camera capture thread)
+ * through a lock-free single-producer/single-consumer queue, so the producer
+ * never waits for the GPU (unless the queue is full and the backpressure
+ * policy is VideoWorkerBlock).
+ *
+ * The input data of each frame is copied into a preallocated queue slot (the
+ * worker takes over the buffer of a slot without copying it again). The
+ * output of the output proc is returned through a future or a callback. Callbacks
+ * are called on the worker thread (or on the producer thread for dropped frames).
+ *
+ * submit() and stop() must be called from the same (producer) thread.
+ */
+class VideoWorker {
+public:
+    typedef std::function<bool()> ContextFunc;
+    typedef std::function<ProcInterface*(VideoSource& video)> SetupFunc;
+    typedef std::function<void()> TeardownFunc;
+    typedef std::function<void(const VideoWorkerResult& result)> ResultCallback;
+
+    /**
+     * Constructor with a queue of <capacity> frames and the <backpressure> policy.
+     */
+    VideoWorker(int capacity = 4, VideoWorkerBackpressure backpressure = VideoWorkerBlock);
+
+    /**
+     * Deconstructor. Stops the worker.
+     */
+    ~VideoWorker();
+
+    VideoWorker(const VideoWorker&) = delete;
+    VideoWorker& operator=(const VideoWorker&) = delete;
+
+    /**
+     * Set the functions that make the OpenGL context current (<activate>) and
+     * release it (<deactivate>) on the worker thread. Must be called before start().
+     * Without them, the worker creates a HeadlessContext (if available).
+     */
+    void setContextFuncs(const ContextFunc& activate, const ContextFunc& deactivate);
+
+    /**
+     * Keep up to <n> frames in flight on the worker (see VideoSource::setFramesInFlight()).
+     * Must be called before start().
+     */
+    void setFramesInFlight(int n) {
+        framesInFlight = n;
+    }
+
+    /**
+     * Start the worker thread. <setup> is called on the worker thread to create the
+     * filter graph for the VideoSource and returns the proc whose output is read
+     * for each frame (or nullptr). <teardown> is called on the worker thread before
+     * the context is released, i.e. to delete the procs. Returns false if the
+     * context could not be activated.
+     */
+    bool start(const SetupFunc& setup, const TeardownFunc& teardown = nullptr);
+
+    /**
+     * Process the frames in the queue and stop the worker thread.
+     */
+    void stop();
+
+    /**
+     * Returns true if the worker thread is running.
+     */
+    bool getIsRunning() const {
+        return running;
+    }
+
+    /**
+     * Submit <frame> for processing. The result is returned through the future.
+     * If the worker is not running, the future is invalid.
+     */
+    std::future<VideoWorkerResult> submit(const FrameInput& frame);
+
+    /**
+     * Submit <frame> for processing. The result is passed to <callback>.
+     * Returns false if the worker is not running.
+     */
+    bool submit(const FrameInput& frame, const ResultCallback& callback);
+
+    /**
+     * Get the number of frames that were dropped by the backpressure policy.
+     */
+    long long getNumDropped() const {
+        return numDropped;
+    }
+
+    /**
+     * Get the number of processed frames.
+     */
+    long long getNumProcessed() const {
+        return numProcessed;
+    }
+
+private:
+    struct Slot {
+        FrameInput frame; // frame with the pixel buffer pointing to <pixels>
+        std::vector<unsigned char> pixels; // copy of the input data
+        long long index = -1; // frame number
+        bool hasPromise = false; // result is returned through <promise>, else through <callback>
+        std::promise<VideoWorkerResult> promise;
+        ResultCallback callback;
+    };
+
+    struct PendingResult {
+        long long index;
+        bool hasPromise;
+        std::promise<VideoWorkerResult> promise;
+        ResultCallback callback;
+    };
+
+    /**
+     * Copy <frame> into the next free slot (producer thread).
+     */
+    bool push(const FrameInput& frame, std::promise<VideoWorkerResult>* promise, const ResultCallback& callback);
+
+    /**
+     * Pass <result> to the promise or callback of <pending>.
+     */
+    static void complete(PendingResult& pending, VideoWorkerResult& result);
+
+    /**
+     * Worker thread main function. Sets <started> after the setup.
+     */
+    void run(SetupFunc setup, TeardownFunc teardown, std::promise<bool>* started);
+
+    /**
+     * Deliver the output of the oldest pending frame (worker thread).
+     */
+    void onOutput(const Size2d& size, const void* pixels, size_t rowStride);
+
+    int capacity; // maximum number of queued frames
+    VideoWorkerBackpressure backpressure;
+    int framesInFlight = 1;
+
+    ContextFunc activateContext;
+    ContextFunc deactivateContext;
+
+    std::vector<Slot> slots; // queue (<capacity> + 1 slots)
+    std::atomic<unsigned long long> head; // next slot to write (producer)
+    std::atomic<unsigned long long> tail; // next slot to read (claimed by the consumer or by the producer to drop it)
+    std::atomic<unsigned long long> busy; // slot + 1 that is copied by the consumer (0: none)
+
+    std::atomic<bool> running;
+    std::thread thread;
+
+    long long nextIndex = 0; // frame number of the next frame (producer)
+    std::atomic<long long> numDropped;
+    std::atomic<long long> numProcessed;
+
+    std::deque<PendingResult> pendingResults; // frames in flight on the worker (worker thread)
+};
+
+END_OGLES_GPGPU
+
+#endif // OGLES_GPGPU_COMMON_VIDEO_WORKER
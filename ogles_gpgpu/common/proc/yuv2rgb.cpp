@@ -180,20 +180,25 @@ int Yuv2RgbProc::init(int inW, int inH, unsigned int order, bool prepareForExter
 }
 
 void Yuv2RgbProc::filterRenderPrepare() {
-    shader->use();
+    GLStateCache& glState = getGLState();
+
+    glState.useProgram(shader->getProgramId());
+
+    // render to (and clear) the FBO, see FilterProcBase::filterRenderPrepare()
+    if (fbo) {
+        fbo->bind();
+    }
 
     // set the viewport
-    glViewport(0, 0, outFrameW, outFrameH);
+    glState.viewport(0, 0, outFrameW, outFrameH);
 
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_2D, luminanceTexture);
+    glState.bindTexture(4, GL_TEXTURE_2D, luminanceTexture);
     glUniform1i(yuvConversionLuminanceTextureUniform, 4);
 
-    glActiveTexture(GL_TEXTURE5);
-    glBindTexture(GL_TEXTURE_2D, chrominanceTexture);
+    glState.bindTexture(5, GL_TEXTURE_2D, chrominanceTexture);
     glUniform1i(yuvConversionChrominanceTextureUniform, 5);
 
     glUniformMatrix3fv(yuvConversionMatrixUniform, 1, GL_FALSE, _preferredConversion);
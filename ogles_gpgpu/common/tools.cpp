@@ -25,7 +25,20 @@ clock_t Tools::startTick = 0;
 vector<double> Tools::timeMeasurements;
 #endif
 
+#ifdef NDEBUG
+int Tools::glErrCheckInterval = 0;
+#else
+int Tools::glErrCheckInterval = 1;
+#endif
+int Tools::glErrCheckCount = 0;
+
 void Tools::checkGLErr(const char* cls, const char* msg) {
+    // glGetError() may stall the pipeline, so it is only called every n-th time
+    if (glErrCheckInterval <= 0 || ++glErrCheckCount < glErrCheckInterval) {
+        return;
+    }
+    glErrCheckCount = 0;
+
     GLenum err = glGetError();
     if (err != GL_NO_ERROR) {
         OG_LOGERR(cls, "%s - GL error '%d' occured", msg, err);
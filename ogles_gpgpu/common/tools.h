@@ -34,6 +34,23 @@ public:
      */
     static void checkGLErr(const char* cls, const char* msg);
 
+    /**
+     * Only check for OpenGL errors in every <interval>-th call of checkGLErr().
+     * 0 disables the checks, 1 checks on every call. Default is 1 for debug
+     * builds and 0 for release builds (NDEBUG).
+     */
+    static void setGLErrorCheckInterval(int interval) {
+        glErrCheckInterval = interval;
+        glErrCheckCount = 0;
+    }
+
+    /**
+     * Get the OpenGL error check interval.
+     */
+    static int getGLErrorCheckInterval() {
+        return glErrCheckInterval;
+    }
+
     /**
      * Check if <v> is a power-of-two (POT) value.
      */
@@ -67,6 +84,9 @@ public:
 #endif
 
 private:
+    static int glErrCheckInterval; // check for OpenGL errors in every n-th checkGLErr() call
+    static int glErrCheckCount; // checkGLErr() calls since the last check
+
 #ifdef OGLES_GPGPU_BENCHMARK
     static clock_t startTick;
     static vector<double> timeMeasurements;
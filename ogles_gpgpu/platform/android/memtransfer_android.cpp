@@ -213,6 +213,13 @@ void MemTransferAndroid::releaseInput() {
 }
 
 void MemTransferAndroid::releaseOutput() {
+    releaseOutputTex();
+
+    // force re-creation in prepareOutput()
+    outputW = outputH = 0;
+}
+
+void MemTransferAndroid::releaseOutputTex() {
     // release output image
     if (outputImage) {
         OG_LOGINF("MemTransferAndroid", "releasing output image");
@@ -185,6 +185,12 @@ public:
      */
     virtual void flush(uint32_t us = 2000000000 /* 2 sec */);
 
+protected:
+    /**
+     * Release the platform buffers of the own output texture.
+     */
+    virtual void releaseOutputTex();
+
 private:
     static GraphicBufferFnCtor graBufCreate; // function pointer to GraphicBufferFnCtor
     static GraphicBufferFnDtor graBufDestroy; // function pointer to GraphicBufferFnDtor
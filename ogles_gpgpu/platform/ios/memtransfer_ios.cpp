@@ -74,6 +74,14 @@ void MemTransferIOS::releaseInput() {
 }
 
 void MemTransferIOS::releaseOutput() {
+    releaseOutputTex();
+
+    // force re-creation in prepareOutput()
+    outputW = outputH = 0;
+    preparedOutput = false;
+}
+
+void MemTransferIOS::releaseOutputTex() {
     if (outputPixelBuffer) {
         CVPixelBufferRelease(outputPixelBuffer);
         outputPixelBuffer = NULL;
@@ -85,8 +93,6 @@ void MemTransferIOS::releaseOutput() {
     }
 
     CVOpenGLESTextureCacheFlush(textureCache, 0);
-
-    preparedOutput = false;
 }
 
 void MemTransferIOS::init() {
@@ -108,7 +114,7 @@ void MemTransferIOS::init() {
         empty);
 
     // create texture cache
-    void* glCtxPtr = Core::getInstance()->getGLContextPtr();
+    void* glCtxPtr = glContextPtr;
     OG_LOGINF("MemTransferIOS", "OpenGL ES context at %p", glCtxPtr);
     assert(glCtxPtr);
     CVReturn res = CVOpenGLESTextureCacheCreate(kCFAllocatorDefault,
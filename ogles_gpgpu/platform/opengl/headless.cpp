@@ -0,0 +1,279 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+#include "headless.h"
+
+#if defined(OGLES_GPGPU_HAS_EGL)
+#include <EGL/eglext.h>
+#endif
+
+#if defined(OGLES_GPGPU_HAS_OSMESA)
+#include <GL/osmesa.h>
+#endif
+
+#include <cstring>
+
+using namespace std;
+using namespace ogles_gpgpu;
+
+#if defined(OGLES_GPGPU_HAS_EGL)
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+static int eglDisplayRefs = 0; // EGL displays are shared in the process, terminate with the last context
+
+// surfaceless Mesa platform if available (no X11/Wayland/GBM device needed), else the default display
+static EGLDisplay getEGLDisplay() {
+    const char* clientExt = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    if (clientExt && strstr(clientExt, "EGL_MESA_platform_surfaceless")) {
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay) {
+            EGLDisplay disp = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+            if (disp != EGL_NO_DISPLAY) {
+                return disp;
+            }
+        }
+    }
+
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+#endif
+
+#pragma mark constructor/deconstructor
+
+HeadlessContext::HeadlessContext()
+    : backend(HeadlessBackendNone)
+#if defined(OGLES_GPGPU_HAS_EGL)
+    , disp(EGL_NO_DISPLAY)
+    , ctx(EGL_NO_CONTEXT)
+    , surface(EGL_NO_SURFACE)
+#endif
+#if defined(OGLES_GPGPU_HAS_OSMESA)
+    , osmesaCtx(NULL)
+#endif
+{
+}
+
+HeadlessContext::~HeadlessContext() {
+    shutdown();
+}
+
+#pragma mark public methods
+
+const char* HeadlessContext::getBackendName(HeadlessBackend backend) {
+    switch (backend) {
+    case HeadlessBackendAuto:
+        return "auto";
+    case HeadlessBackendEGLSurfaceless:
+        return "EGL surfaceless";
+    case HeadlessBackendEGLPBuffer:
+        return "EGL pbuffer";
+    case HeadlessBackendOSMesa:
+        return "OSMesa";
+    default:
+        return "none";
+    }
+}
+
+bool HeadlessContext::setup(HeadlessBackend b) {
+    shutdown();
+
+    bool any = (b == HeadlessBackendAuto);
+
+    if ((any || b == HeadlessBackendEGLSurfaceless) && setupEGL(false)) {
+        backend = HeadlessBackendEGLSurfaceless;
+    } else if ((any || b == HeadlessBackendEGLPBuffer) && setupEGL(true)) {
+        backend = HeadlessBackendEGLPBuffer;
+    } else if ((any || b == HeadlessBackendOSMesa) && setupOSMesa()) {
+        backend = HeadlessBackendOSMesa;
+    } else {
+        OG_LOGERR("HeadlessContext", "could not create a context with backend %s", getBackendName(b));
+        return false;
+    }
+
+    OG_LOGINF("HeadlessContext", "created context with backend %s: %s", getBackendName(backend), (const char*)glGetString(GL_VERSION));
+
+    return true;
+}
+
+bool HeadlessContext::activate() {
+#if defined(OGLES_GPGPU_HAS_EGL)
+    if (ctx != EGL_NO_CONTEXT) {
+        return eglMakeCurrent(disp, surface, surface, ctx) == EGL_TRUE;
+    }
+#endif
+
+#if defined(OGLES_GPGPU_HAS_OSMESA)
+    if (osmesaCtx) {
+        return OSMesaMakeCurrent((OSMesaContext)osmesaCtx, &osmesaBuffer[0], GL_UNSIGNED_BYTE, 1, 1) == GL_TRUE;
+    }
+#endif
+
+    return false;
+}
+
+bool HeadlessContext::deactivate() {
+#if defined(OGLES_GPGPU_HAS_EGL)
+    if (ctx != EGL_NO_CONTEXT) {
+        // only release the context if it is ours
+        return eglGetCurrentContext() != ctx || eglMakeCurrent(disp, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT) == EGL_TRUE;
+    }
+#endif
+
+#if defined(OGLES_GPGPU_HAS_OSMESA)
+    if (osmesaCtx) {
+        return OSMesaGetCurrentContext() != (OSMesaContext)osmesaCtx || OSMesaMakeCurrent(NULL, NULL, GL_UNSIGNED_BYTE, 0, 0) == GL_TRUE;
+    }
+#endif
+
+    return false;
+}
+
+void HeadlessContext::shutdown() {
+    if (backend == HeadlessBackendNone) {
+        return;
+    }
+
+    deactivate();
+
+#if defined(OGLES_GPGPU_HAS_EGL)
+    releaseEGL();
+#endif
+
+#if defined(OGLES_GPGPU_HAS_OSMESA)
+    if (osmesaCtx) {
+        OSMesaDestroyContext((OSMesaContext)osmesaCtx);
+        osmesaCtx = NULL;
+        osmesaBuffer.clear();
+    }
+#endif
+
+    backend = HeadlessBackendNone;
+}
+
+#pragma mark private methods
+
+bool HeadlessContext::setupEGL(bool pbuffer) {
+#if defined(OGLES_GPGPU_HAS_EGL)
+    // EGL config attributes
+    const EGLint confAttr[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, // desktop OpenGL (see platform/opengl/gl_includes.h)
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+
+    // all processing is done in FBOs, so the pixelbuffer surface can be tiny
+    const EGLint surfaceAttr[] = {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE
+    };
+
+    EGLint eglMajVers, eglMinVers;
+    EGLint numConfigs = 0;
+    EGLConfig conf;
+
+    disp = getEGLDisplay();
+    if (disp == EGL_NO_DISPLAY) {
+        OG_LOGINF("HeadlessContext", "eglGetDisplay failed: %d", eglGetError());
+        return false;
+    }
+
+    if (!eglInitialize(disp, &eglMajVers, &eglMinVers)) {
+        OG_LOGINF("HeadlessContext", "eglInitialize failed: %d", eglGetError());
+        disp = EGL_NO_DISPLAY;
+        return false;
+    }
+    eglDisplayRefs++;
+
+    OG_LOGINF("HeadlessContext", "EGL init with version %d.%d", eglMajVers, eglMinVers);
+
+    const char* ext = eglQueryString(disp, EGL_EXTENSIONS);
+    bool ok = pbuffer || (ext && strstr(ext, "EGL_KHR_surfaceless_context"));
+
+    ok = ok && eglBindAPI(EGL_OPENGL_API) && eglChooseConfig(disp, confAttr, &conf, 1, &numConfigs) && numConfigs > 0;
+
+    if (ok) {
+        ctx = eglCreateContext(disp, conf, EGL_NO_CONTEXT, NULL);
+        ok = (ctx != EGL_NO_CONTEXT);
+    }
+
+    if (ok && pbuffer) {
+        surface = eglCreatePbufferSurface(disp, conf, surfaceAttr);
+        ok = (surface != EGL_NO_SURFACE);
+    }
+
+    ok = ok && activate();
+
+    if (!ok) {
+        OG_LOGINF("HeadlessContext", "EGL %s context setup failed: %d", pbuffer ? "pbuffer" : "surfaceless", eglGetError());
+        releaseEGL();
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+#if defined(OGLES_GPGPU_HAS_EGL)
+void HeadlessContext::releaseEGL() {
+    if (disp == EGL_NO_DISPLAY) {
+        return;
+    }
+
+    deactivate();
+
+    if (surface != EGL_NO_SURFACE) {
+        eglDestroySurface(disp, surface);
+        surface = EGL_NO_SURFACE;
+    }
+
+    if (ctx != EGL_NO_CONTEXT) {
+        eglDestroyContext(disp, ctx);
+        ctx = EGL_NO_CONTEXT;
+    }
+
+    if (--eglDisplayRefs == 0) {
+        eglTerminate(disp);
+    }
+
+    disp = EGL_NO_DISPLAY;
+}
+#endif
+
+bool HeadlessContext::setupOSMesa() {
+#if defined(OGLES_GPGPU_HAS_OSMESA)
+    osmesaCtx = OSMesaCreateContextExt(OSMESA_RGBA, 0, 0, 0, NULL);
+    if (!osmesaCtx) {
+        OG_LOGINF("HeadlessContext", "OSMesaCreateContextExt failed");
+        return false;
+    }
+
+    // all processing is done in FBOs, so the color buffer can be tiny
+    osmesaBuffer.resize(4);
+
+    if (!activate()) {
+        OG_LOGINF("HeadlessContext", "OSMesaMakeCurrent failed");
+        OSMesaDestroyContext((OSMesaContext)osmesaCtx);
+        osmesaCtx = NULL;
+        return false;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
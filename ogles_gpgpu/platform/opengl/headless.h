@@ -0,0 +1,132 @@
+//
+// ogles_gpgpu project - GPGPU for mobile devices and embedded systems using OpenGL ES 2.0
+//
+// See LICENSE file in project repository root for the license.
+//
+
+/**
+ * Headless OpenGL context provider (EGL or OSMesa).
+ */
+#ifndef OGLES_GPGPU_OPENGL_HEADLESS
+#define OGLES_GPGPU_OPENGL_HEADLESS
+
+#include "../../common/common_includes.h"
+
+#if defined(OGLES_GPGPU_HAS_EGL)
+#include <EGL/egl.h>
+#endif
+
+#include <vector>
+
+namespace ogles_gpgpu {
+
+/**
+ * Backends of a HeadlessContext.
+ */
+typedef enum {
+    HeadlessBackendNone = 0,
+    HeadlessBackendAuto, // first backend that works, in the order below
+    HeadlessBackendEGLSurfaceless, // EGL context without surface (EGL_MESA_platform_surfaceless / EGL_KHR_surfaceless_context)
+    HeadlessBackendEGLPBuffer, // EGL context with a pixelbuffer surface
+    HeadlessBackendOSMesa // Mesa off-screen rendering into client memory
+} HeadlessBackend;
+
+/**
+ * HeadlessContext creates an OpenGL context that does not need a display or
+ * window system, i.e. for offline processing, unit tests and benchmarks on
+ * servers (also on plain CPU machines with Mesa llvmpipe).
+ *
+ * The backends are only available if the library was built with
+ * OGLES_GPGPU_HEADLESS (defines OGLES_GPGPU_HAS_EGL and/or OGLES_GPGPU_HAS_OSMESA).
+ * All processing renders into FBOs, so the (pbuffer or OSMesa) surface is kept
+ * minimal.
+ */
+class HeadlessContext {
+public:
+    /**
+     * Constructor. Does not create the context, see setup().
+     */
+    HeadlessContext();
+
+    /**
+     * Deconstructor. Calls shutdown().
+     */
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    /**
+     * Create the context with backend <backend> and make it current.
+     * Returns true on success, otherwise false.
+     */
+    bool setup(HeadlessBackend backend = HeadlessBackendAuto);
+
+    /**
+     * Make the context current on the calling thread.
+     */
+    bool activate();
+
+    /**
+     * Release the context from the calling thread.
+     */
+    bool deactivate();
+
+    /**
+     * Destroy the context. Also calls deactivate().
+     */
+    void shutdown();
+
+    /**
+     * Return the backend of the created context (HeadlessBackendNone if there is none).
+     */
+    HeadlessBackend getBackend() const {
+        return backend;
+    }
+
+    /**
+     * Returns true if a context was created.
+     */
+    operator bool() const {
+        return backend != HeadlessBackendNone;
+    }
+
+    /**
+     * Return the name of <backend>.
+     */
+    static const char* getBackendName(HeadlessBackend backend);
+
+private:
+    /**
+     * Try to create an EGL context, with a pixelbuffer surface if <pbuffer> is true.
+     */
+    bool setupEGL(bool pbuffer);
+
+#if defined(OGLES_GPGPU_HAS_EGL)
+    /**
+     * Destroy the EGL surface and context and release the display.
+     */
+    void releaseEGL();
+#endif
+
+    /**
+     * Try to create an OSMesa context.
+     */
+    bool setupOSMesa();
+
+    HeadlessBackend backend; // backend of the created context
+
+#if defined(OGLES_GPGPU_HAS_EGL)
+    EGLDisplay disp;
+    EGLContext ctx;
+    EGLSurface surface;
+#endif
+
+#if defined(OGLES_GPGPU_HAS_OSMESA)
+    void* osmesaCtx; // OSMesaContext
+    std::vector<unsigned char> osmesaBuffer; // color buffer of the OSMesa context
+#endif
+};
+}
+
+#endif
@@ -17,4 +17,6 @@ include(sugar_files)
 sugar_files(
     OGLES_GPGPU_SRCS
     gl_includes.h
+    headless.cpp
+    headless.h
 )
@@ -61,6 +61,14 @@ void MemTransferOSX::releaseInput() {
 }
 
 void MemTransferOSX::releaseOutput() {
+    releaseOutputTex();
+
+    // force re-creation in prepareOutput()
+    outputW = outputH = 0;
+    preparedOutput = false;
+}
+
+void MemTransferOSX::releaseOutputTex() {
     if (outputPixelBuffer) {
         CVPixelBufferRelease(outputPixelBuffer);
         outputPixelBuffer = NULL;
@@ -72,8 +80,6 @@ void MemTransferOSX::releaseOutput() {
     }
 
     CVOpenGLTextureCacheFlush(textureCache, 0);
-
-    preparedOutput = false;
 }
 
 void MemTransferOSX::init() {
@@ -94,7 +100,7 @@ void MemTransferOSX::init() {
     CFDictionarySetValue(bufferAttr, kCVPixelBufferIOSurfacePropertiesKey, empty);
 
     // create texture cache
-    CGLContextObj glCtxPtr = (CGLContextObj)Core::getInstance()->getGLContextPtr();
+    CGLContextObj glCtxPtr = (CGLContextObj)glContextPtr;
     OG_LOGINF("MemTransferOSX", "OpenGL ES context at %p", glCtxPtr);
 
     assert(glCtxPtr);
@@ -35,10 +35,12 @@ public:
     static bool initPlatformOptimizations();
 
     /**
-     * Constructor. Set defaults.
+     * Constructor. Set defaults. <glContext> is the OpenGL context (platform
+     * specific type) of the owning Core, needed to create the TextureCache.
      */
-    MemTransferOSX()
+    MemTransferOSX(void* glContext = NULL)
         : MemTransfer()
+        , glContextPtr(glContext)
         , bufferAttr(NULL)
         , inputPixelBuffer(NULL)
         , outputPixelBuffer(NULL)
@@ -101,12 +103,20 @@ public:
      */
     virtual void unlockBuffer(BufType bufType);
 
+protected:
+    /**
+     * Release the platform buffers of the own output texture.
+     */
+    virtual void releaseOutputTex();
+
 private:
     /**
      * Sets <buf> and <lockOpt> to the necessary pointers/values according to <bufType>.
      */
     void getPixelBufferAndLockFlags(BufType bufType, CVPixelBufferRef* buf, CVOptionFlags* lockOpt);
 
+    void* glContextPtr; // OpenGL context (platform specific type), weak ref.
+
     CFMutableDictionaryRef bufferAttr; // buffer attributes
 
     CVPixelBufferRef inputPixelBuffer; // input pixel buffer
@@ -17,6 +17,10 @@
 #include <opencv2/imgproc.hpp>
 #include <opencv2/highgui.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <set>
+
 // NOTE: GL_BGRA is absent in Android NDK
 // clang-format off
 #ifdef ANDROID
@@ -32,6 +36,9 @@
 #include "../common/proc/yuv2rgb.h"      // [0]
 #include "../common/proc/lnorm.h"        // [0]
 #include "../common/proc/video.h"        // [0]
+#include "../common/proc/video_worker.h" // [0]
+#include "../common/proc/tiler.h"        // [0]
+#include "../common/proc/batcher.h"      // [0]
 #include "../common/proc/adapt_thresh.h" // [x]
 #include "../common/proc/gain.h"         // [x]
 #include "../common/proc/blend.h"        // [x]
@@ -52,12 +59,16 @@
 #include "../common/proc/highpass.h"     // [0]
 #include "../common/proc/thresh.h"       // [0]
 #include "../common/proc/pyramid.h"      // [0]
+#include "../common/proc/reduce.h"       // [0]
 #include "../common/proc/ixyt.h"         // [0]
 #include "../common/proc/tensor.h"       // [0]
 #include "../common/proc/shitomasi.h"    // [0]
 #include "../common/proc/harris.h"       // [0]
 #include "../common/proc/nms.h"          // [0]
+#include "../common/proc/histogram.h"    // [0]
+#include "../common/proc/histopyramid.h" // [0]
 #include "../common/proc/flow.h"         // [0]
+#include "../common/proc/klt.h"          // [0]
 #include "../common/proc/rgb2hsv.h"      // [0]
 #include "../common/proc/hsv2rgb.h"      // [0]
 #include "../common/proc/remap.h"        // [ ] (needs work)
@@ -79,9 +90,13 @@ int main(int argc, char** argv) {
 
 // Provide skeleton context when !defined(OGLES_GPGPU_HAS_GLFW)
 // This supports end-to-end link tests.
+// With OGLES_GPGPU_HEADLESS a headless context is used (no display needed).
 struct GLFWContext {
     GLFWContext() {
-#if defined(OGLES_GPGPU_HAS_GLFW)
+#if defined(OGLES_GPGPU_HEADLESS)
+        headless.setup();
+        glActiveTexture(GL_TEXTURE0);
+#elif defined(OGLES_GPGPU_HAS_GLFW)
         // initialize glfw context
         glfwInit();
 
@@ -101,7 +116,9 @@ struct GLFWContext {
     }
 
     operator bool() const {
-#if defined(OGLES_GPGPU_HAS_GLFW)
+#if defined(OGLES_GPGPU_HEADLESS)
+        return headless;
+#elif defined(OGLES_GPGPU_HAS_GLFW)
         return (context != nullptr);
 #else
         return false;
@@ -109,13 +126,17 @@ struct GLFWContext {
     }
 
     ~GLFWContext() {
-#if defined(OGLES_GPGPU_HAS_GLFW)
+#if defined(OGLES_GPGPU_HEADLESS)
+        headless.shutdown();
+#elif defined(OGLES_GPGPU_HAS_GLFW)
         glfwDestroyWindow(context);
         glfwTerminate();
 #endif
     }
 
-#if defined(OGLES_GPGPU_HAS_GLFW)
+#if defined(OGLES_GPGPU_HEADLESS)
+    ogles_gpgpu::HeadlessContext headless;
+#elif defined(OGLES_GPGPU_HAS_GLFW)
     GLFWwindow* context = nullptr;
 #endif
 };
@@ -305,6 +326,313 @@ TEST(OGLESGPGPUTest, GainProc) {
     }
 }
 
+TEST(OGLESGPGPUTest, IndependentCores) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        static const int value = 1, g1 = 10, g2 = 20;
+        cv::Mat test(640, 480, CV_8UC4, cv::Scalar(value, value, value, 255));
+
+        glActiveTexture(GL_TEXTURE0);
+
+        // Two sources with separate processing contexts side by side:
+        ogles_gpgpu::VideoSource video1, video2;
+        ogles_gpgpu::GainProc gain1(g1), gain2(g2);
+
+        video1.set(&gain1);
+        video2.set(&gain2);
+        ASSERT_NE(gain1.getCore(), gain2.getCore());
+
+        video1({ { test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT });
+        video2({ { test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT });
+
+        cv::Mat result1, result2;
+        getImage(gain1, result1);
+        getImage(gain2, result2);
+        ASSERT_EQ(static_cast<int>(cv::mean(result1)[0]), (value * g1));
+        ASSERT_EQ(static_cast<int>(cv::mean(result2)[0]), (value * g2));
+    }
+}
+
+TEST(OGLESGPGPUTest, FilterFusion) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 10, true);
+        glActiveTexture(GL_TEXTURE0);
+
+        // GrayscaleProc -> GainProc -> ThreshProc with and without fusion:
+        cv::Mat results[2];
+        for (int i = 0; i < 2; i++) {
+            ogles_gpgpu::VideoSource video;
+            video.getCore().setUseFilterFusion(i == 1);
+
+            ogles_gpgpu::GrayscaleProc gray;
+            ogles_gpgpu::GainProc gain(1.5f);
+            ogles_gpgpu::ThreshProc thresh;
+            gray.add(&gain);
+            gain.add(&thresh);
+
+            video.set(&gray);
+            video({ { test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT });
+
+            // only the last stage of a fused chain has an output texture
+            ASSERT_EQ(gray.getOutputTexId() == 0, i == 1);
+
+            getImage(thresh, results[i]);
+        }
+
+        ASSERT_EQ(cv::countNonZero(results[0].reshape(1) != results[1].reshape(1)), 0);
+
+        // Rgb2HsvProc -> Hsv2RgbProc, where the 8 bit rounding of the hue matters:
+        for (int i = 0; i < 2; i++) {
+            ogles_gpgpu::VideoSource video;
+            video.getCore().setUseFilterFusion(i == 1);
+
+            ogles_gpgpu::Rgb2HsvProc rgb2hsv;
+            ogles_gpgpu::Hsv2RgbProc hsv2rgb;
+            rgb2hsv.add(&hsv2rgb);
+
+            video.set(&rgb2hsv);
+            video({ { test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT });
+
+            getImage(hsv2rgb, results[i]);
+        }
+
+        // the last stage may differ in the rounding of ties
+        ASSERT_LE(cv::norm(results[0], results[1], cv::NORM_INF), 1.0);
+    }
+}
+
+TEST(OGLESGPGPUTest, MemoryPlanner) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 10, true);
+        glActiveTexture(GL_TEXTURE0);
+
+        // GrayscaleProc -> GainProc -> GainProc -> GainProc -> ThreshProc with and without shared render targets:
+        cv::Mat results[2];
+        for (int i = 0; i < 2; i++) {
+            ogles_gpgpu::VideoSource video;
+            video.getCore().setUseMemoryPlanner(i == 1);
+
+            ogles_gpgpu::GrayscaleProc gray;
+            ogles_gpgpu::GainProc gain1(1.5f), gain2(0.5f), gain3(2.0f);
+            ogles_gpgpu::ThreshProc thresh;
+            gray.add(&gain1);
+            gain1.add(&gain2);
+            gain2.add(&gain3);
+            gain3.add(&thresh);
+
+            video.set(&gray);
+            video({ { test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT });
+
+            getImage(thresh, results[i]);
+
+            if (i == 1) {
+                // the intermediate results fit into two alternating textures
+                const ogles_gpgpu::MemoryReport& report = video.getCore().getMemoryReport();
+                ASSERT_EQ(report.numProcs, 5);
+                ASSERT_EQ(report.numAliased, 4);
+                ASSERT_EQ(report.numTextures, 3);
+                ASSERT_LT(report.steadyBytes, report.unplannedBytes);
+            }
+        }
+
+        ASSERT_EQ(cv::countNonZero(results[0].reshape(1) != results[1].reshape(1)), 0);
+    }
+}
+
+TEST(OGLESGPGPUTest, MemoryPlannerReplan) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 10, true);
+        glActiveTexture(GL_TEXTURE0);
+
+        // GrayscaleProc -> GainProc (x2) -> BlendProc without shared render targets and with a second plan:
+        cv::Mat results[2];
+        for (int i = 0; i < 2; i++) {
+            ogles_gpgpu::VideoSource video;
+            video.getCore().setUseMemoryPlanner(i == 1);
+
+            ogles_gpgpu::GrayscaleProc gray;
+            ogles_gpgpu::GainProc gain1(0.5f), gain2(1.5f);
+            ogles_gpgpu::BlendProc blend(0.5f);
+            gray.add(&gain1);
+            gray.add(&gain2);
+            gain1.add(&blend, 0);
+            gain2.add(&blend, 1);
+
+            video.set(&gray);
+            video({ { test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT });
+
+            if (i == 1) {
+                // the textures of the first plan are reused
+                const ogles_gpgpu::MemoryReport report = video.getCore().getMemoryReport();
+                const GLuint texId = gain1.getOutputTexId();
+                ASSERT_GT(report.numAliased, 0);
+                ASSERT_EQ(video.getCore().planMemory(&gray).numAliased, report.numAliased);
+                ASSERT_EQ(gain1.getOutputTexId(), texId);
+                ASSERT_TRUE(glIsTexture(texId));
+            }
+
+            video({ { test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT });
+            getImage(blend, results[i]);
+        }
+
+        ASSERT_EQ(cv::countNonZero(results[0].reshape(1) != results[1].reshape(1)), 0);
+    }
+}
+
+TEST(OGLESGPGPUTest, RoiPlanner) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 10, true);
+        glActiveTexture(GL_TEXTURE0);
+
+        // GrayscaleProc -> GaussOptProc -> GradProc -> NmsProc for the whole frame and for a region of interest:
+        const cv::Rect roi(200, 120, 160, 100);
+        cv::Mat results[2];
+        for (int i = 0; i < 2; i++) {
+            ogles_gpgpu::VideoSource video;
+            if (i == 1) {
+                video.getCore().setRoi({ roi.x, roi.y, roi.width, roi.height });
+            }
+
+            ogles_gpgpu::GrayscaleProc gray;
+            ogles_gpgpu::GaussOptProc gauss(4.0f);
+            ogles_gpgpu::GradProc grad;
+            ogles_gpgpu::NmsProc nms;
+            gray.add(&gauss);
+            gauss.add(&grad);
+            grad.add(&nms);
+
+            video.set(&gray);
+            video({ { test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT });
+
+            getImage(nms, results[i]);
+
+            if (i == 1) {
+                // the region grows by the halo of the following neighbourhood filters
+                ASSERT_EQ(nms.getRoi().x, roi.x);
+                ASSERT_EQ(nms.getRoi().width, roi.width);
+                ASSERT_EQ(grad.getRoi().x, roi.x - 1);
+                ASSERT_EQ(gauss.getRoi().x, roi.x - 2);
+                ASSERT_EQ(gray.getRoi().x, roi.x - 2 - gauss.getRoiHalo());
+            }
+        }
+
+        ASSERT_EQ(cv::countNonZero(results[0](roi).reshape(1) != results[1](roi).reshape(1)), 0);
+    }
+}
+
+TEST(OGLESGPGPUTest, Tiler) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 10, true);
+        glActiveTexture(GL_TEXTURE0);
+
+        // GrayscaleProc -> GaussOptProc -> GradProc for the whole image and in tiles of 256x256 pixels:
+        cv::Mat results[2];
+        for (int i = 0; i < 2; i++) {
+            ogles_gpgpu::GrayscaleProc gray;
+            ogles_gpgpu::GaussOptProc gauss(4.0f);
+            ogles_gpgpu::GradProc grad;
+            gray.add(&gauss);
+            gauss.add(&grad);
+
+            if (i == 0) {
+                ogles_gpgpu::VideoSource video;
+                video.set(&gray);
+                video({ { test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT });
+                getImage(grad, results[i]);
+            } else {
+                ogles_gpgpu::Tiler tiler;
+                tiler.setMaxTileSize(256);
+                tiler.set(&gray, &grad);
+                ASSERT_TRUE(tiler({ test.cols, test.rows }, test.ptr<void>(), test.step, TEXTURE_FORMAT));
+                ASSERT_GT(tiler.getHalo(), 0);
+                ASSERT_GT(tiler.getNumTiles(), 4);
+
+                const ogles_gpgpu::Size2d& size = tiler.getOutputSize();
+                results[i] = cv::Mat(size.height, size.width, CV_8UC4, (void*)tiler.getOutput().data()).clone();
+            }
+        }
+
+        ASSERT_EQ(cv::countNonZero(results[0].reshape(1) != results[1].reshape(1)), 0);
+
+        // tiles of a downscaled output need an image size that is a multiple of the scale:
+        ogles_gpgpu::GainProc half(1.f);
+        ogles_gpgpu::GaussOptProc gauss(4.0f);
+        half.setOutputSize(0.5f);
+        half.add(&gauss);
+
+        ogles_gpgpu::Tiler tiler;
+        tiler.setMaxTileSize(256);
+        tiler.set(&half, &gauss);
+        ASSERT_FALSE(tiler({ test.cols - 1, test.rows - 1 }, test.ptr<void>(), test.step, TEXTURE_FORMAT));
+        ASSERT_TRUE(tiler({ test.cols, test.rows }, test.ptr<void>(), test.step, TEXTURE_FORMAT));
+        ASSERT_EQ(tiler.getOutputSize().width, test.cols / 2);
+    }
+}
+
+TEST(OGLESGPGPUTest, Batcher) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 10, true);
+        glActiveTexture(GL_TEXTURE0);
+
+        // 24 crops of 64x64 pixels (with the row stride of the test image):
+        const int size = 64, count = 24;
+        std::vector<cv::Mat> crops;
+        std::vector<const void*> images;
+        for (int i = 0; i < count; i++) {
+            crops.push_back(test(cv::Rect((i % 8) * 72, (i / 8) * 150, size, size)));
+            images.push_back(crops.back().ptr());
+        }
+
+        ogles_gpgpu::GaussOptProc gauss(4.0f);
+        ogles_gpgpu::Batcher batcher;
+        batcher.setMaxAtlasSize(512);
+        batcher.set(&gauss, &gauss);
+        ASSERT_TRUE(batcher({ size, size }, images, test.step, TEXTURE_FORMAT));
+        ASSERT_EQ(batcher.getNumImages(), count);
+        ASSERT_GT(batcher.getNumAtlases(), 1);
+        ASSERT_GT(batcher.getUsedGutter(), 0);
+
+        // each result is the same as for processing the image alone:
+        ogles_gpgpu::GaussOptProc gaussRef(4.0f);
+        ogles_gpgpu::VideoSource video;
+        video.set(&gaussRef);
+        for (int i = 0; i < count; i++) {
+            cv::Mat crop = crops[i].clone();
+            video({ { size, size }, crop.ptr<void>(), true, 0, TEXTURE_FORMAT });
+
+            cv::Mat expected;
+            getImage(gaussRef, expected);
+
+            const ogles_gpgpu::Batcher::View view = batcher.getResult(i);
+            ASSERT_EQ(view.size.width, size);
+            ASSERT_EQ(view.size.height, size);
+            cv::Mat result(size, size, CV_8UC4, (void*)view.pixels, view.rowStride);
+            ASSERT_EQ(cv::countNonZero(expected.reshape(1) != result.reshape(1)), 0);
+        }
+
+        // a downscaling graph can not batch images with a size that is not a multiple of the scale:
+        ogles_gpgpu::GainProc half(1.f);
+        half.setOutputSize(0.5f);
+        ogles_gpgpu::Batcher halfBatcher;
+        halfBatcher.set(&half, &half);
+        ASSERT_FALSE(halfBatcher({ size + 1, size - 1 }, images, test.step, TEXTURE_FORMAT));
+        ASSERT_TRUE(halfBatcher({ size, size }, images, test.step, TEXTURE_FORMAT));
+    }
+}
+
 TEST(OGLESGPGPUTest, BlendProc) {
     GLFWContext context;
     ASSERT_TRUE(context);
@@ -354,6 +682,401 @@ TEST(OGLESGPGPUTest, FIFOProc) {
     }
 }
 
+TEST(OGLESGPGPUTest, FIFOProcRotation) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        glActiveTexture(GL_TEXTURE0);
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::GainProc gain(1.f);
+        ogles_gpgpu::FIFOPRoc fifo(3);
+        video.set(&gain);
+        gain.add(&fifo);
+        fifo.setProducer(&gain); // gain renders directly into the next slot
+
+        // the output of the producer is still the current frame (also with readbacks in flight)
+        std::vector<int> values;
+        video.setFramesInFlight(3);
+        video.setOutput(&gain, [&](const ogles_gpgpu::Size2d& size, const void* pixels, size_t bytesPerRow) {
+            cv::Mat result(size.height, size.width, CV_8UC4, (void*)pixels, bytesPerRow);
+            values.push_back(static_cast<int>(cv::mean(result)[0] + 0.5));
+        });
+
+        for (int i = 0; i < 5; i++) {
+            cv::Mat test(640, 480, CV_8UC4, cv::Scalar(i, i, i, 255));
+            video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+        }
+        video.flush();
+
+        ASSERT_EQ(values, std::vector<int>({ 0, 1, 2, 3, 4 }));
+        ASSERT_EQ(fifo.getNumCopies(), 0);
+        for (int i = 0; i < 3; i++) {
+            cv::Mat result;
+            getImage(*fifo[i], result);
+            ASSERT_EQ(cv::mean(result)[0], i + 2);
+        }
+    }
+}
+
+TEST(OGLESGPGPUTest, ShaderCache) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 1, true);
+
+        glActiveTexture(GL_TEXTURE0);
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::GainProc gain;
+        ogles_gpgpu::FIFOPRoc fifo(3);
+        ogles_gpgpu::GaussOptProc gauss1(5.0f), gauss2(5.0f);
+
+        gain.add(&fifo);
+        gain.add(&gauss1);
+        gauss1.add(&gauss2);
+
+        video.set(&gain);
+        video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+
+        // GainProc, the FIFO passes and the blur passes only need one program per distinct source
+        const ogles_gpgpu::ShaderCache& cache = video.getCore().getShaderCache();
+        ASSERT_LE(cache.getNumPrograms(), 3);
+        ASSERT_EQ(cache.getNumCompiled(), cache.getNumPrograms());
+        ASSERT_GE(cache.getNumHits(), 5);
+
+        cv::Mat result;
+        getImage(gauss2, result);
+        ASSERT_FALSE(result.empty());
+    }
+}
+
+TEST(OGLESGPGPUTest, GLStateCache) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 1, true);
+        glActiveTexture(GL_TEXTURE0);
+
+        // same chain with the state cache disabled and enabled:
+        cv::Mat results[2];
+        for (int i = 0; i < 2; i++) {
+            ogles_gpgpu::VideoSource video;
+            ogles_gpgpu::GLStateCache& glState = video.getCore().getGLState();
+            glState.setEnabled(i == 1);
+
+            ogles_gpgpu::GrayscaleProc gray;
+            ogles_gpgpu::GaussOptProc gauss1(3.0f), gauss2(3.0f);
+            gray.add(&gauss1);
+            gauss1.add(&gauss2);
+
+            video.set(&gray);
+            video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+            video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+
+            if (i == 0) {
+                ASSERT_EQ(glState.getNumSkipped(), 0);
+            } else {
+                ASSERT_GT(glState.getNumSkipped(), 0);
+            }
+
+            getImage(gauss2, results[i]);
+        }
+
+        ASSERT_EQ(cv::countNonZero(results[0].reshape(1) != results[1].reshape(1)), 0);
+    }
+}
+
+TEST(OGLESGPGPUTest, QuadBuffer) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 1, true);
+        glActiveTexture(GL_TEXTURE0);
+
+        // shared quad buffer vs. vertex data from client memory:
+        cv::Mat results[2];
+        for (int i = 0; i < 2; i++) {
+            ogles_gpgpu::VideoSource video;
+            ogles_gpgpu::GainProc gain;
+            ogles_gpgpu::PyramidProc pyramid(3);
+            gain.setOutputRenderOrientation(ogles_gpgpu::RenderOrientationDiagonal);
+            gain.add(&pyramid);
+
+            video.set(&gain);
+            video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+            ASSERT_TRUE(video.getCore().getQuadBuffer().getIsInitialized());
+
+            if (i == 1) {
+                video.getCore().getQuadBuffer().clear();
+                video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+            }
+
+            getImage(pyramid, results[i]);
+        }
+
+        ASSERT_EQ(cv::countNonZero(results[0].reshape(1) != results[1].reshape(1)), 0);
+    }
+}
+
+TEST(OGLESGPGPUTest, Profiler) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 1, true);
+        glActiveTexture(GL_TEXTURE0);
+
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::Profiler& profiler = video.getCore().getProfiler();
+        profiler.setEnabled(true);
+
+        ogles_gpgpu::GrayscaleProc gray;
+        ogles_gpgpu::GaussOptProc gauss(3.0f);
+        gauss.setProcTitle("blur");
+        gray.add(&gauss);
+
+        video.set(&gray);
+        for (int i = 0; i < 3; i++) {
+            video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+        }
+        profiler.flush();
+
+        ASSERT_EQ(profiler.getNumFrames(), 3);
+
+        const std::vector<ogles_gpgpu::ProfilerStats> stats = profiler.getStats();
+        ASSERT_EQ(stats.size(), 2);
+        ASSERT_EQ(stats[1].name, "blur");
+        for (auto& s : stats) {
+            ASSERT_EQ(s.count, 3);
+            ASSERT_GE(s.gpuP99, s.gpuP50);
+        }
+
+        ASSERT_NE(profiler.getChromeTrace().find("\"traceEvents\""), std::string::npos);
+    }
+}
+
+TEST(OGLESGPGPUTest, ProfilerNested) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 1, true);
+        glActiveTexture(GL_TEXTURE0);
+
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::Profiler& profiler = video.getCore().getProfiler();
+        profiler.setEnabled(true);
+
+        // IirFilterProc processes its inner BlendProc in its own render() call
+        ogles_gpgpu::GainProc gain(1.f);
+        ogles_gpgpu::IirFilterProc iir(ogles_gpgpu::IirFilterProc::kLowPass);
+        gain.add(&iir);
+
+        video.set(&gain);
+        for (int i = 0; i < 3; i++) {
+            video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+        }
+        profiler.flush();
+
+        ASSERT_EQ(profiler.getNumFrames(), 3);
+
+        const std::vector<ogles_gpgpu::ProfilerStats> stats = profiler.getStats();
+        ASSERT_EQ(stats.size(), 3);
+        ASSERT_EQ(stats[1].proc, &iir);
+        ASSERT_EQ(stats[2].name, "BlendProc");
+        for (auto& s : stats) {
+            ASSERT_EQ(s.count, 3);
+        }
+
+        // the outer proc is measured from its own begin (and includes the inner proc)
+        ASSERT_GE(stats[1].cpuP50, stats[2].cpuP50);
+    }
+}
+
+TEST(OGLESGPGPUTest, AsyncReadback) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        glActiveTexture(GL_TEXTURE0);
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::GainProc gain(1.f);
+        video.set(&gain);
+
+        // readbacks are delivered 2 frames later (and in order)
+        static const int numFrames = 5, numBuffers = 3;
+        std::vector<int> values;
+        for (int i = 0; i < numFrames; i++) {
+            cv::Mat test(480, 640, CV_8UC4, cv::Scalar(i * 10, i * 10, i * 10, 255));
+            video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+
+            ogles_gpgpu::MemTransfer* transfer = gain.getMemTransferObj();
+            transfer->setReadbackBuffers(numBuffers);
+
+            ogles_gpgpu::MemTransfer::FrameDelegate delegate = [&](const ogles_gpgpu::Size2d& size, const void* pixels, size_t bytesPerRow) {
+                cv::Mat result(size.height, size.width, CV_8UC4, (void*)pixels, bytesPerRow);
+                values.push_back(static_cast<int>(cv::mean(result)[0] + 0.5));
+            };
+            gain.getResultData(delegate);
+
+            // platform optimized implementations deliver immediately
+            const int latency = dynamic_cast<ogles_gpgpu::MemTransferOptimized*>(transfer) ? 0 : (numBuffers - 1);
+            ASSERT_EQ(values.size(), std::max(0, i + 1 - latency));
+        }
+        gain.getMemTransferObj()->flushReadback();
+
+        ASSERT_EQ(values.size(), numFrames);
+        for (int i = 0; i < numFrames; i++) {
+            ASSERT_EQ(values[i], i * 10);
+        }
+    }
+}
+
+TEST(OGLESGPGPUTest, StreamingUpload) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        // padded rows: ROI of a wider image
+        cv::Mat padded = getTestImage(640, 480, 10, true);
+        cv::copyMakeBorder(padded, padded, 0, 0, 0, 32, cv::BORDER_CONSTANT);
+        cv::Mat test = padded(cv::Rect(0, 0, 640, 480));
+
+        glActiveTexture(GL_TEXTURE0);
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::GainProc gain(1.f);
+        video.set(&gain);
+
+        GLuint inputTex = 0;
+        for (int i = 0; i < 3; i++) {
+            ogles_gpgpu::FrameInput frame({ test.cols, test.rows }, test.data, true, 0, TEXTURE_FORMAT, test.step[0]);
+            video(frame);
+            gain.getInputMemTransferObj()->setUploadBuffers(2);
+
+            // the input texture is allocated once
+            if (i > 0) {
+                ASSERT_EQ(video.getInputTexId(), inputTex);
+            }
+            inputTex = video.getInputTexId();
+
+            cv::Mat result;
+            getImage(gain, result);
+            ASSERT_EQ(cv::norm(result, test, cv::NORM_INF), 0.0);
+        }
+    }
+}
+
+TEST(OGLESGPGPUTest, FramesInFlight) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        glActiveTexture(GL_TEXTURE0);
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::GainProc gain(1.f);
+        video.set(&gain);
+
+        static const int numFrames = 6, framesInFlight = 3;
+        video.setFramesInFlight(framesInFlight);
+
+        std::vector<int> values;
+        video.setOutput(&gain, [&](const ogles_gpgpu::Size2d& size, const void* pixels, size_t bytesPerRow) {
+            cv::Mat result(size.height, size.width, CV_8UC4, (void*)pixels, bytesPerRow);
+            values.push_back(static_cast<int>(cv::mean(result)[0] + 0.5));
+        });
+
+        for (int i = 0; i < numFrames; i++) {
+            cv::Mat test(480, 640, CV_8UC4, cv::Scalar(i * 10, i * 10, i * 10, 255));
+            video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+            ASSERT_LT(video.getNumFramesPending(), framesInFlight);
+        }
+        video.flush();
+
+        // the output of all frames is delivered in order
+        ASSERT_EQ(video.getNumFramesPending(), 0);
+        ASSERT_EQ(values.size(), numFrames);
+        for (int i = 0; i < numFrames; i++) {
+            ASSERT_EQ(values[i], i * 10);
+        }
+    }
+}
+
+TEST(OGLESGPGPUTest, VideoWorker) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        ogles_gpgpu::VideoWorker worker(2, ogles_gpgpu::VideoWorkerBlock);
+        worker.setFramesInFlight(2);
+
+#if !defined(OGLES_GPGPU_HEADLESS) && defined(OGLES_GPGPU_HAS_GLFW)
+        // move the context to the worker thread
+        GLFWwindow* window = context.context;
+        glfwMakeContextCurrent(nullptr);
+        worker.setContextFuncs([=]() { glfwMakeContextCurrent(window); return true; },
+            []() { glfwMakeContextCurrent(nullptr); return true; });
+#endif
+
+        // the procs are created and deleted on the worker thread
+        std::unique_ptr<ogles_gpgpu::GainProc> gain;
+        bool started = worker.start([&](ogles_gpgpu::VideoSource& video) {
+            gain.reset(new ogles_gpgpu::GainProc(1.f));
+            video.set(gain.get());
+            return gain.get();
+        },
+            [&]() { gain.reset(); });
+        ASSERT_TRUE(started);
+
+        static const int numFrames = 8;
+        std::vector<std::future<ogles_gpgpu::VideoWorkerResult>> results;
+        for (int i = 0; i < numFrames; i++) {
+            // the input is copied, so it can be released after submit()
+            cv::Mat test(480, 640, CV_8UC4, cv::Scalar(i * 10, i * 10, i * 10, 255));
+            results.push_back(worker.submit({ { test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT }));
+        }
+
+        // the output of all frames is delivered in order
+        for (int i = 0; i < numFrames; i++) {
+            ogles_gpgpu::VideoWorkerResult result = results[i].get();
+            ASSERT_EQ(result.index, i);
+            ASSERT_FALSE(result.dropped);
+
+            cv::Mat output(result.size.height, result.size.width, CV_8UC4, &result.pixels[0], result.rowStride);
+            ASSERT_EQ(static_cast<int>(cv::mean(output)[0] + 0.5), i * 10);
+        }
+
+        worker.stop();
+        ASSERT_EQ(worker.getNumProcessed(), numFrames);
+
+#if !defined(OGLES_GPGPU_HEADLESS) && defined(OGLES_GPGPU_HAS_GLFW)
+        glfwMakeContextCurrent(window);
+#endif
+    }
+}
+
+TEST(OGLESGPGPUTest, ShaderBinaryCache) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 1, true);
+        glActiveTexture(GL_TEXTURE0);
+
+        // the first run compiles and saves the programs, the second run loads them:
+        cv::Mat results[2];
+        for (int i = 0; i < 2; i++) {
+            ogles_gpgpu::VideoSource video;
+            ogles_gpgpu::ShaderCache& cache = video.getCore().getShaderCache();
+            cache.setBinaryDirectory(".");
+
+            ogles_gpgpu::GaussOptProc gauss(3.0f);
+            video.set(&gauss);
+            video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+
+            if (ogles_gpgpu::Shader::getSupportsBinary() && i == 1) {
+                ASSERT_GT(cache.getNumBinaryLoaded(), 0);
+                ASSERT_EQ(cache.getNumCompiled(), 0);
+            }
+
+            getImage(gauss, results[i]);
+        }
+
+        ASSERT_EQ(cv::countNonZero(results[0].reshape(1) != results[1].reshape(1)), 0);
+    }
+}
+
 TEST(OGLESGPGPUTest, TransformProc) {
     GLFWContext context;
     ASSERT_TRUE(context);
@@ -632,6 +1355,61 @@ TEST(OGLESGPGPUTest, HighPassProc) {
     }
 }
 
+TEST(OGLESGPGPUTest, LowPassProcFeedback) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        glActiveTexture(GL_TEXTURE0);
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::LowPassFilterProc low(0.5f);
+        video.set(&low);
+
+        // output = (input + previous output) / 2, starting with the first input
+        const int values[] = { 0, 200, 100, 20 };
+        const int expected[] = { 0, 100, 100, 60 };
+        for (int i = 0; i < 4; i++) {
+            cv::Mat test(480, 640, CV_8UC4, cv::Scalar(values[i], values[i], values[i], 255));
+            video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+
+            cv::Mat result;
+            getImage(low, result);
+            ASSERT_NEAR(cv::mean(result)[0], expected[i], 1.0);
+        }
+    }
+}
+
+TEST(OGLESGPGPUTest, LowPassProcFeedbackInFlight) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        glActiveTexture(GL_TEXTURE0);
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::LowPassFilterProc low(0.5f);
+        video.set(&low);
+
+        // the swapped feedback textures keep the readbacks in flight
+        std::vector<int> values;
+        video.setFramesInFlight(3);
+        video.setOutput(&low, [&](const ogles_gpgpu::Size2d& size, const void* pixels, size_t bytesPerRow) {
+            cv::Mat result(size.height, size.width, CV_8UC4, (void*)pixels, bytesPerRow);
+            values.push_back(static_cast<int>(cv::mean(result)[0] + 0.5));
+        });
+
+        const int inputs[] = { 0, 200, 100, 20 };
+        const int expected[] = { 0, 100, 100, 60 };
+        for (int i = 0; i < 4; i++) {
+            cv::Mat test(480, 640, CV_8UC4, cv::Scalar(inputs[i], inputs[i], inputs[i], 255));
+            video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+        }
+        video.flush();
+
+        ASSERT_EQ(values.size(), 4);
+        for (int i = 0; i < 4; i++) {
+            ASSERT_NEAR(values[i], expected[i], 1);
+        }
+    }
+}
+
 TEST(OGLESGPGPUTest, ThreshProc) {
     GLFWContext context;
     ASSERT_TRUE(context);
@@ -670,6 +1448,70 @@ TEST(OGLESGPGPUTest, PyramidProc) {
     }
 }
 
+TEST(OGLESGPGPUTest, PyramidProcCascaded) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        glActiveTexture(GL_TEXTURE0);
+
+        // every 4th column is white: the levels from 1/4 of the size on are uniform (sampling
+        // these levels directly from the input would alias to 0 or 255)
+        cv::Mat stripes(480, 640, CV_8UC4);
+        for (int y = 0; y < stripes.rows; y++) {
+            for (int x = 0; x < stripes.cols; x++) {
+                const int value = (x % 4 == 3) ? 255 : 0;
+                stripes.at<cv::Vec4b>(y, x) = cv::Vec4b(value, value, value, 255);
+            }
+        }
+
+        {
+            ogles_gpgpu::VideoSource video;
+            ogles_gpgpu::PyramidProc pyramid(4);
+            pyramid.setMode(ogles_gpgpu::PyramidProc::GAUSSIAN);
+            video.set(&pyramid);
+            video({ stripes.cols, stripes.rows }, stripes.ptr<void>(), true, 0, TEXTURE_FORMAT);
+
+            cv::Mat result;
+            getImage(pyramid, result);
+
+            const std::vector<ogles_gpgpu::Rect2d>& crops = pyramid.getLevelCrops();
+            for (int i = 2; i < int(crops.size()); i++) {
+                const ogles_gpgpu::Rect2d& c = crops[i];
+                int maxDiff = 0;
+                for (int y = c.y + 2; y < c.y + c.height - 2; y++) {
+                    for (int x = c.x + 2; x < c.x + c.width - 2; x++) {
+                        maxDiff = std::max(maxDiff, std::abs(int(result.at<cv::Vec4b>(y, x)[0]) - 64));
+                    }
+                }
+                ASSERT_LE(maxDiff, 2);
+            }
+        }
+
+        // uniform image: the Laplacian levels are 0 (encoded as 0.5), the last level is the image
+        {
+            const int value = 100;
+            cv::Mat uniform(480, 640, CV_8UC4, cv::Scalar(value, value, value, 255));
+
+            ogles_gpgpu::VideoSource video;
+            ogles_gpgpu::PyramidProc pyramid(4);
+            pyramid.setMode(ogles_gpgpu::PyramidProc::LAPLACIAN);
+            video.set(&pyramid);
+            video({ uniform.cols, uniform.rows }, uniform.ptr<void>(), true, 0, TEXTURE_FORMAT);
+
+            cv::Mat result;
+            getImage(pyramid, result);
+
+            const std::vector<ogles_gpgpu::Rect2d>& crops = pyramid.getLevelCrops();
+            for (int i = 0; i < int(crops.size()); i++) {
+                const ogles_gpgpu::Rect2d& c = crops[i];
+                cv::Mat level = result(cv::Rect(c.x, c.y, c.width, c.height));
+                const double expected = (i + 1 < int(crops.size())) ? 127.5 : value;
+                ASSERT_NEAR(cv::mean(level)[0], expected, 1.0);
+            }
+        }
+    }
+}
+
 TEST(OGLESGPGPUTest, IxytProc) {
     GLFWContext context;
     ASSERT_TRUE(context);
@@ -816,6 +1658,123 @@ TEST(OGLESGPGPUTest, NmsProc) {
     }
 }
 
+TEST(OGLESGPGPUTest, HistoPyramidProc) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        // sparse keypoints (same value in all channels for any texture format)
+        cv::Mat test(480, 640, CV_8UC4, cv::Scalar::all(0));
+        std::set<std::pair<int, int>> truth;
+        for (int i = 0; i < 200; i++) {
+            const int x = rand() % test.cols, y = rand() % test.rows;
+            test.at<cv::Vec4b>(y, x) = cv::Vec4b(200, 200, 200, 200);
+            truth.emplace(x, y);
+        }
+
+        glActiveTexture(GL_TEXTURE0);
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::GainProc gain(1.f);
+        ogles_gpgpu::HistoPyramidProc histoPyramid(256);
+        histoPyramid.setThreshold(0.5f);
+
+        video.set(&gain);
+        gain.add(&histoPyramid);
+        video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+
+        std::vector<ogles_gpgpu::Keypoint> keypoints;
+        const int total = histoPyramid.getKeypoints(keypoints);
+        ASSERT_EQ(total, static_cast<int>(truth.size()));
+        ASSERT_EQ(keypoints.size(), truth.size());
+
+        std::set<std::pair<int, int>> found;
+        for (const auto& k : keypoints) {
+            found.emplace(k.x, k.y);
+            ASSERT_NEAR(k.score, 200.f / 255.f, 1e-2f);
+        }
+        ASSERT_EQ(found, truth);
+    }
+}
+
+TEST(OGLESGPGPUTest, HistogramProc) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 10, true);
+
+        glActiveTexture(GL_TEXTURE0);
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::GrayscaleProc gray;
+        ogles_gpgpu::HistogramProc histogram(256, 2, 2);
+
+        video.set(&gray);
+        gray.add(&histogram);
+        video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+
+        std::vector<unsigned int> counts;
+        histogram.getHistograms(counts);
+        ASSERT_EQ(counts.size(), static_cast<size_t>(histogram.getNumHistograms() * 256));
+
+        // compare with the histograms of the grayscale output
+        cv::Mat result;
+        getImage(gray, result);
+        std::vector<unsigned int> truth(4 * 256, 0);
+        for (int y = 0; y < result.rows; y++) {
+            for (int x = 0; x < result.cols; x++) {
+                const int tile = (y / (result.rows / 2)) * 2 + x / (result.cols / 2);
+                truth[tile * 256 + result.at<cv::Vec4b>(y, x)[0]]++;
+            }
+        }
+        ASSERT_EQ(counts, truth);
+    }
+}
+
+TEST(OGLESGPGPUTest, ReduceProc) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        cv::Mat test = getTestImage(640, 480, 10, true);
+
+        glActiveTexture(GL_TEXTURE0);
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::GainProc gain(1.f);
+        ogles_gpgpu::ReduceProc reduce(ogles_gpgpu::ReduceMean, 4);
+
+        // all channels with the same weight (independent of the texture format)
+        const GLfloat mask[4] = { 0.25f, 0.25f, 0.25f, 0.25f };
+        reduce.setChannelMask(mask);
+
+        video.set(&gain);
+        gain.add(&reduce);
+
+        cv::Mat result;
+        float mean[4], variance[4], maxValue[4];
+        video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+        reduce.getResult(mean);
+        getImage(gain, result);
+
+        reduce.setOp(ogles_gpgpu::ReduceVariance);
+        video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+        reduce.getResult(variance);
+
+        reduce.setOp(ogles_gpgpu::ReduceMax);
+        video({ test.cols, test.rows }, test.ptr<void>(), true, 0, TEXTURE_FORMAT);
+        reduce.getResult(maxValue);
+
+        // compare with the statistics of the input of the ReduceProc
+        cv::Mat gray;
+        result.reshape(1, result.rows * result.cols).convertTo(gray, CV_32F, 0.25 / 255.0);
+        cv::reduce(gray, gray, 1, cv::REDUCE_SUM);
+        cv::Scalar truthMean, truthStdDev;
+        cv::meanStdDev(gray, truthMean, truthStdDev);
+        ASSERT_NEAR(mean[0], truthMean[0], 1e-3);
+        ASSERT_NEAR(variance[0], truthStdDev[0] * truthStdDev[0], 1e-3);
+
+        double truthMax = 0.0;
+        cv::minMaxLoc(result.reshape(1), nullptr, &truthMax);
+        ASSERT_NEAR(*std::max_element(maxValue, maxValue + 4), truthMax / 255.0, 1e-3);
+    }
+}
+
 TEST(OGLESGPGPUTest, FlowProc) {
     GLFWContext context;
     ASSERT_TRUE(context);
@@ -843,6 +1802,113 @@ TEST(OGLESGPGPUTest, FlowProc) {
     }
 }
 
+TEST(OGLESGPGPUTest, PyramidFlowProc) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        // smooth texture, which is shifted by more pixels than a single scale LK window can track
+        const float dx = 10.f, dy = -6.f;
+        cv::Mat frames[2];
+        for (int i = 0; i < 2; i++) {
+            frames[i].create(240, 320, CV_8UC4);
+            for (int y = 0; y < frames[i].rows; y++) {
+                for (int x = 0; x < frames[i].cols; x++) {
+                    const float u = x - i * dx, v = y - i * dy;
+                    const float value = 0.5f + 0.2f * std::sin(u * 0.11f + 1.f) * std::cos(v * 0.07f) + 0.15f * std::sin(u * 0.05f - v * 0.13f);
+                    const uint8_t gray = cv::saturate_cast<uint8_t>(value * 255.f);
+                    frames[i].at<cv::Vec4b>(y, x) = cv::Vec4b(gray, gray, gray, 255);
+                }
+            }
+        }
+
+        glActiveTexture(GL_TEXTURE0);
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::PyramidFlowPipeline flow(4, 3);
+
+        video.set(&flow);
+        for (int i = 0; i < 2; i++) {
+            video({ frames[i].cols, frames[i].rows }, frames[i].ptr<void>(), true, 0, TEXTURE_FORMAT);
+        }
+
+        ogles_gpgpu::ProcInterface* output = flow.getOutputFilter();
+        output->getMemTransferObj()->setOutputPixelFormat(GL_RGBA);
+        ASSERT_EQ(output->getOutFrameW(), frames[0].cols);
+        ASSERT_EQ(output->getOutFrameH(), frames[0].rows);
+
+        cv::Mat result;
+        getImage(*output, result);
+
+        // the interior has the flow of the shift (up to the 8 bit quantization of the output)
+        const float scale = 2.f / (255.f * flow.getStrength());
+        int count = 0, good = 0;
+        for (int y = result.rows / 4; y < result.rows * 3 / 4; y++) {
+            for (int x = result.cols / 4; x < result.cols * 3 / 4; x++) {
+                const cv::Vec4b& pixel = result.at<cv::Vec4b>(y, x);
+                const float u = pixel[0] * scale - 1.f / flow.getStrength();
+                const float v = pixel[1] * scale - 1.f / flow.getStrength();
+                good += (std::abs(u - dx) < 0.5f) && (std::abs(v - dy) < 0.5f);
+                count++;
+            }
+        }
+        ASSERT_GT(good, count * 95 / 100);
+    }
+}
+
+TEST(OGLESGPGPUTest, KltProc) {
+    GLFWContext context;
+    ASSERT_TRUE(context);
+    if (context) {
+        // smooth texture, which is shifted twice by the same motion
+        const float dx = 10.f, dy = -6.f;
+        cv::Mat frames[3];
+        for (int i = 0; i < 3; i++) {
+            frames[i].create(240, 320, CV_8UC4);
+            for (int y = 0; y < frames[i].rows; y++) {
+                for (int x = 0; x < frames[i].cols; x++) {
+                    const float u = x - i * dx, v = y - i * dy;
+                    const float value = 0.5f + 0.2f * std::sin(u * 0.11f + 1.f) * std::cos(v * 0.07f) + 0.15f * std::sin(u * 0.05f - v * 0.13f);
+                    const uint8_t gray = cv::saturate_cast<uint8_t>(value * 255.f);
+                    frames[i].at<cv::Vec4b>(y, x) = cv::Vec4b(gray, gray, gray, 255);
+                }
+            }
+        }
+
+        glActiveTexture(GL_TEXTURE0);
+        ogles_gpgpu::VideoSource video;
+        ogles_gpgpu::KltPipeline klt(4, 256);
+        video.set(&klt);
+        video({ frames[0].cols, frames[0].rows }, frames[0].ptr<void>(), true, 0, TEXTURE_FORMAT);
+
+        // a grid of points in the first frame and a lost point
+        std::vector<ogles_gpgpu::TrackedPoint> points;
+        for (int y = 60; y <= 180; y += 20) {
+            for (int x = 80; x <= 240; x += 20) {
+                points.emplace_back(x, y);
+            }
+        }
+        points.emplace_back(5, 5, false);
+        klt.getTracker().setPoints(points);
+
+        // the points of each frame are the input of the next frame
+        for (int i = 1; i < 3; i++) {
+            video({ frames[i].cols, frames[i].rows }, frames[i].ptr<void>(), true, 0, TEXTURE_FORMAT);
+
+            std::vector<ogles_gpgpu::TrackedPoint> result;
+            const int tracked = klt.getTracker().getPoints(result);
+            ASSERT_EQ(result.size(), points.size());
+            ASSERT_GT(tracked, int(points.size()) * 90 / 100);
+            ASSERT_FALSE(result.back().tracked);
+
+            for (int k = 0; k < int(result.size()); k++) {
+                if (result[k].tracked) {
+                    ASSERT_NEAR(result[k].x, points[k].x + i * dx, 0.5f);
+                    ASSERT_NEAR(result[k].y, points[k].y + i * dy, 0.5f);
+                }
+            }
+        }
+    }
+}
+
 TEST(OGLESGPGPUTest, Rgb2HsvProc) {
     GLFWContext context;
     ASSERT_TRUE(context);